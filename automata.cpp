@@ -3,37 +3,141 @@
 
 using namespace std;
 
+namespace {
+
+/**
+ * A run of byte ranges matching the UTF-8 encodings of a range of code points.
+ */
+typedef vector<pair<unsigned char, unsigned char>> Utf8Sequence;
+
+/**
+ * Encode a code point in UTF-8.
+ *
+ * @return The number of bytes written.
+ */
+int encodeUtf8(uint32_t codePoint, unsigned char *bytes) {
+    if(codePoint < 0x80) {
+        bytes[0] = (unsigned char) codePoint;
+        return 1;
+    }
+    if(codePoint < 0x800) {
+        bytes[0] = (unsigned char)(0xC0 | (codePoint >> 6));
+        bytes[1] = (unsigned char)(0x80 | (codePoint & 0x3F));
+        return 2;
+    }
+    if(codePoint < 0x10000) {
+        bytes[0] = (unsigned char)(0xE0 | (codePoint >> 12));
+        bytes[1] = (unsigned char)(0x80 | ((codePoint >> 6) & 0x3F));
+        bytes[2] = (unsigned char)(0x80 | (codePoint & 0x3F));
+        return 3;
+    }
+    bytes[0] = (unsigned char)(0xF0 | (codePoint >> 18));
+    bytes[1] = (unsigned char)(0x80 | ((codePoint >> 12) & 0x3F));
+    bytes[2] = (unsigned char)(0x80 | ((codePoint >> 6) & 0x3F));
+    bytes[3] = (unsigned char)(0x80 | (codePoint & 0x3F));
+    return 4;
+}
+
+/**
+ * Split a range of code points into sequences of byte ranges. The range is cut
+ * at the surrogates and at the boundaries between encoding lengths, then until
+ * low and high only differ in bytes whose ranges are complete, so that every
+ * piece is the product of one byte range per position. The first byte ranges
+ * of two pieces are either equal or disjoint.
+ */
+void utf8Sequences(uint32_t low, uint32_t high, vector<Utf8Sequence> &sequences) {
+    vector<pair<uint32_t, uint32_t>> pending;
+    pending.push_back(pair<uint32_t, uint32_t>(low, high));
+    while(!pending.empty()) {
+        uint32_t lo = pending.back().first, hi = pending.back().second;
+        pending.pop_back();
+        if(lo > hi) continue;
+        //ASCII letters are a single byte each
+        if(hi <= 0x7F) {
+            sequences.push_back(Utf8Sequence(1, pair<unsigned char, unsigned char>((unsigned char) lo, (unsigned char) hi)));
+            continue;
+        }
+        //Surrogates have no valid encoding
+        if(lo < 0xE000 && hi > 0xD7FF) {
+            pending.push_back(pair<uint32_t, uint32_t>(0xE000, hi));
+            pending.push_back(pair<uint32_t, uint32_t>(lo, 0xD7FF));
+            continue;
+        }
+        bool split = false;
+        for(uint32_t boundary : {0x7Fu, 0x7FFu, 0xFFFFu}) {
+            if(lo <= boundary && hi > boundary) {
+                pending.push_back(pair<uint32_t, uint32_t>(boundary + 1, hi));
+                pending.push_back(pair<uint32_t, uint32_t>(lo, boundary));
+                split = true;
+                break;
+            }
+        }
+        for(int i = 1; i < 4 && !split; i++) {
+            uint32_t mask = (1u << (6 * i)) - 1;
+            if((lo & ~mask) == (hi & ~mask)) continue;
+            if((lo & mask) != 0) {
+                pending.push_back(pair<uint32_t, uint32_t>((lo | mask) + 1, hi));
+                pending.push_back(pair<uint32_t, uint32_t>(lo, lo | mask));
+                split = true;
+            } else if((hi & mask) != mask) {
+                pending.push_back(pair<uint32_t, uint32_t>(hi & ~mask, hi));
+                pending.push_back(pair<uint32_t, uint32_t>(lo, (hi & ~mask) - 1));
+                split = true;
+            }
+        }
+        if(split) continue;
+        unsigned char loBytes[4], hiBytes[4];
+        int length = encodeUtf8(lo, loBytes);
+        encodeUtf8(hi, hiBytes);
+        Utf8Sequence sequence;
+        for(int i = 0; i < length; i++) sequence.push_back(pair<unsigned char, unsigned char>(loBytes[i], hiBytes[i]));
+        sequences.push_back(sequence);
+    }
+}
+
+}
+
 /**
  * Constructor for Abstract DFA.
  * 
  * @param noStates
  *            Number of states in the DFA.
  */
-AbstractDFA::AbstractDFA(int noStates) : numStates(noStates), actState(initialState){}
+template<typename Symbol>
+BasicDFA<Symbol>::BasicDFA(int noStates) : numStates(noStates), actState(initialState){}
 
 /**
  * Reset the automaton to the initial state.
  */
-void AbstractDFA::reset() { actState = initialState; }
+template<typename Symbol>
+void BasicDFA<Symbol>::reset() { actState = initialState; }
 
 /**
  * Performs one step of the DFA for a given letter. If there is a transition
  * for the given letter, then the automaton proceeds to the successor state.
- * Otherwise it goes to the sink state. By construction it will stay in the
- * sink for every input letter.
+ * Otherwise it follows the first range transition that contains the letter
+ * or the default transition of the state, if any, or it goes to the sink
+ * state. By construction it will stay in the sink for every input letter.
  * 
  * @param letter
  *            The current input.
  */
-void AbstractDFA::doStep(char letter) {
+template<typename Symbol>
+void BasicDFA<Symbol>::doStep(Symbol letter) {
     //A check is made to verify that the current state does not correspond to the trap state, otherwise there is no point in proceeding
     if(actState != trapState){
         //The iterator corresponding to the transition function is created with input (current status, letter)
-        map<tpair, int>::iterator ftran = transitionF.find(tpair(actState,letter));
+        typename map<pair<int, Symbol>, int>::iterator ftran = transitionF.find(pair<int, Symbol>(actState,letter));
         //This check is done to verify that the iterator is in a state that allows it to consume the input symbol.
         if(ftran != transitionF.end()){
             //The automata shifts to the state determined by the transition function
             actState = ftran->second;
+        }else if(const Range *frange = findRangeTransition(actState, letter)){
+            //The letter belongs to a range of letters that share the same transition
+            actState = frange->target;
+        }else if(map<int, int>::iterator fdefault = defaultF.find(actState); fdefault != defaultF.end()){
+            //The letter has no transition of its own, so the default transition of the state is taken
+            actState = fdefault->second;
         }else{
             //The automata is in a state where it isn't possible to proceed, as there are no further transition functions.
             actState = trapState;
@@ -41,12 +145,105 @@ void AbstractDFA::doStep(char letter) {
     }
 }
 
+/**
+ * Add a transition taken by every letter in the range [low, high].
+ *
+ * @param state
+ *            The source state.
+ * @param low
+ *            First letter of the range, as unsigned number.
+ * @param high
+ *            Last letter of the range, as unsigned number.
+ * @param target
+ *            The state reached with a letter of the range.
+ */
+template<typename Symbol>
+void BasicDFA<Symbol>::addRangeTransition(int state, Letter low, Letter high, int target) {
+    rangeF[state].push_back(Range{low, high, target});
+}
+
+/**
+ * Add a transition taken by every letter of a set of bytes. The set is
+ * stored as the ranges of consecutive letters it contains.
+ *
+ * @param state
+ *            The source state.
+ * @param letters
+ *            The set of letters, indexed by unsigned byte.
+ * @param target
+ *            The state reached with a letter of the set.
+ */
+template<typename Symbol>
+void BasicDFA<Symbol>::addSetTransition(int state, const tset &letters, int target) {
+    for(int low = 0; low < 256; low++) {
+        if(!letters.test(low)) continue;
+        int high = low;
+        while(high + 1 < 256 && letters.test(high + 1)) high++;
+        addRangeTransition(state, (Letter) low, (Letter) high, target);
+        low = high;
+    }
+}
+
+/**
+ * Find the first range transition of a state that contains the letter.
+ *
+ * @return The transition, or nullptr if no range contains the letter.
+ */
+template<typename Symbol>
+const typename BasicDFA<Symbol>::Range *BasicDFA<Symbol>::findRangeTransition(int state, Symbol letter) const {
+    typename map<int, vector<Range>>::const_iterator franges = rangeF.find(state);
+    if(franges == rangeF.end()) return nullptr;
+    Letter value = (Letter) letter;
+    for(const Range &frange : franges->second){
+        if(frange.low <= value && value <= frange.high) return &frange;
+    }
+    return nullptr;
+}
+
+/**
+ * Add a transition taken by every Unicode code point in [low, high], compiled
+ * into byte-level transitions over its UTF-8 encoding.
+ *
+ * @param state
+ *            The source state.
+ * @param low
+ *            First code point of the range.
+ * @param high
+ *            Last code point of the range (at most U+10FFFF).
+ * @param target
+ *            The state reached after a whole code point of the range.
+ */
+template<typename Symbol>
+void BasicDFA<Symbol>::addCodePointTransition(int state, uint32_t low, uint32_t high, int target)
+        requires is_same_v<Symbol, char> {
+    if(high > 0x10FFFF) high = 0x10FFFF;
+    vector<Utf8Sequence> sequences;
+    utf8Sequences(low, high, sequences);
+    for(const Utf8Sequence &sequence : sequences) {
+        int current = state;
+        for(size_t i = 0; i + 1 < sequence.size(); i++) {
+            //A prefix already added for another sequence leads to the same intermediate state
+            int next = trapState;
+            for(const Range &frange : rangeF[current]) {
+                if(frange.low == sequence[i].first && frange.high == sequence[i].second) next = frange.target;
+            }
+            if(next == trapState) {
+                next = numStates++;
+                addRangeTransition(current, sequence[i].first, sequence[i].second, next);
+            }
+            current = next;
+        }
+        addRangeTransition(current, sequence.back().first, sequence.back().second, target);
+    }
+}
+
 /**
  * Check if the automaton is currently accepting.
  * 
  * @return True, if the automaton is currently in the accepting state.
  */
-bool AbstractDFA::isAccepting() {
+template<typename Symbol>
+bool BasicDFA<Symbol>::isAccepting() {
     //For each final state in the vector "finalStates" a check is made to determine
     //whether or not the current state belongs to it.
     for(auto it : finalStates){
@@ -59,17 +256,24 @@ bool AbstractDFA::isAccepting() {
  * Run the DFA on the input.
  * 
  * @param inputWord
- *            stream that contains the input word
+ *            pointer to the first symbol of the input word
+ * @param length
+ *            number of symbols of the input word
  * @return True, if if the word is accepted by this automaton
  */
-bool AbstractDFA::run(const string &inputWord) {
+template<typename Symbol>
+bool BasicDFA<Symbol>::run(const Symbol *inputWord, size_t length) {
     this->reset();
-    for(int i = 0; i < inputWord.length(); i++) {
+    for(size_t i = 0; i < length; i++) {
         doStep(inputWord[i]);
     }
     return isAccepting();
 }
 
+template class BasicDFA<char>;
+template class BasicDFA<uint16_t>;
+template class BasicDFA<uint32_t>;
+
 
 /**
  * Construct a new DFA that recognizes exactly the given word. Given a word
@@ -104,61 +308,58 @@ WordDFA::WordDFA(const string &word) : AbstractDFA(word.length()+1) {
  * are three kinds of comments: single line comment that starts with // and ends
  * with a newline, multiline comments that starts with (* and ends with *), and
  * multiline comments that starts with { and ends with }
+ *
+ * @param validateUtf8
+ *            If true, the text of the comment must be valid UTF-8.
  */
-CommentDFA::CommentDFA() : AbstractDFA(8) {
+CommentDFA::CommentDFA(bool validateUtf8) : AbstractDFA(8) {
     // For the accurate representation of the DFA to which this function relates, see the folder:
     // https://github.com/LucaPolese/PrimaEsercitazioneAutomi/blob/master/out/comment.pdf
     //As can be seen from the automaton in the illustration, each type of comment corresponds
     // to a different branch of the automaton.
-    // Both Self-loops on states 2 and 4 and transitions starting from state 6 and 7
-    // are hard coded in the function CommentDFA::doStep(),therefore it's unnecessary
-    // to code them in this method
+    // The self-loops on states 2, 4 and 6, and the transition from state 7 back to 6, stand for
+    // "every other letter", so they are coded as default transitions, or as transitions on
+    // every code point when the text of the comment has to be valid UTF-8
+    auto everyOtherLetter = [this, validateUtf8](int state, int target) {
+        if(validateUtf8) addCodePointTransition(state, 0, 0x10FFFF, target);
+        else defaultF.insert(pair<int, int>(state, target));
+    };
     transitionF.insert(pair<tpair, int>(tpair(0, '/'), 1));
     transitionF.insert(pair<tpair, int>(tpair(1, '/'), 2));
     transitionF.insert(pair<tpair, int>(tpair(2, '\n'), 3));
+    everyOtherLetter(2, 2);
     transitionF.insert(pair<tpair, int>(tpair(0, '{'), 4));
     transitionF.insert(pair<tpair, int>(tpair(4, '}'), 3));
+    everyOtherLetter(4, 4);
     transitionF.insert(pair<tpair, int>(tpair(0, '('), 5));
     transitionF.insert(pair<tpair, int>(tpair(5, '*'), 6));
+    transitionF.insert(pair<tpair, int>(tpair(6, '*'), 7));
+    everyOtherLetter(6, 6);
+    transitionF.insert(pair<tpair, int>(tpair(7, '*'), 7));
     transitionF.insert(pair<tpair, int>(tpair(7, ')'), 3));
+    everyOtherLetter(7, 6);
     finalStates.push_back(3);
 }
 
 /**
- * Performs one step of the DFA for a given letter. This method works
- * differently than in the superclass AbstractDFA.
- * 
- * @param letter
- *            The current input.
+ * Construct a new DFA that recognizes identifiers: a letter or an underscore,
+ * followed by any number of letters, digits and underscores.
+ *
+ * @param unicode
+ *            If true, every non-ASCII code point counts as a letter.
  */
-void CommentDFA::doStep(char letter) {
-    switch (actState) {
-        case 2:
-            if (letter == '\n') {
-                actState = 3;
-            }
-            break;
-        case 4:
-            if (letter == '}') {
-                actState = 3;
-            }
-            break;
-        case 6:
-            if (letter == '*') {
-                actState = 7;
-            }
-            break;
-        case 7:
-            if (letter == ')') {
-                actState = 3;
-            } else if (letter != '*') {
-                actState = 6;
-            }
-            break;
-        default:
-            AbstractDFA::doStep(letter);
-            break;
+IdentifierDFA::IdentifierDFA(bool unicode) : AbstractDFA(2) {
+    //State 0 waits for the first letter, state 1 (final) loops on every letter that may follow it
+    tset first;
+    for(int letter = 'a'; letter <= 'z'; letter++) first.set(letter);
+    for(int letter = 'A'; letter <= 'Z'; letter++) first.set(letter);
+    first.set('_');
+    addSetTransition(0, first, 1);
+    addSetTransition(1, first, 1);
+    addRangeTransition(1, '0', '9', 1);
+    if(unicode) {
+        addCodePointTransition(0, 0x80, 0x10FFFF, 1);
+        addCodePointTransition(1, 0x80, 0x10FFFF, 1);
     }
-}	
-
-
+    finalStates.push_back(1);
+}
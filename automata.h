@@ -1,18 +1,44 @@
 #pragma once
 
+#include<bitset>
+#include<cstdint>
 #include<iostream>
 #include<map>
+#include<type_traits>
 #include<vector>
 
 using namespace std;
 
 typedef std::pair<int,char> tpair;
+typedef std::bitset<256> tset;
 
 /**
- * Abstract class for Deterministic Finite Automata.
+ * Abstract class for Deterministic Finite Automata over an alphabet of symbols.
+ * Byte-level automata use char; higher-level automata can run over the tokens
+ * produced by a lexer by using a wider symbol (e.g. a uint16_t token kind).
+ * The class is instantiated in automata.cpp for char, uint16_t and uint32_t.
+ *
+ * @param Symbol
+ *            Type of the input letters.
  */
-class AbstractDFA {
+template<typename Symbol>
+class BasicDFA {
+    friend class CompiledDFA;
+public:
+    /**
+     * @brief Letter represents a symbol as an unsigned number, the order used by the ranges
+     */
+    typedef make_unsigned_t<Symbol> Letter;
 protected:
+    /**
+     * A transition taken by every letter in [low, high].
+     */
+    struct Range {
+        Letter low;
+        Letter high;
+        int target;
+    };
+
     /**
      * @brief initialState represents the initial state of the DFA
      */
@@ -31,14 +57,85 @@ protected:
 	int numStates;
 	/**
 	 * @brief This is the map that rappresents all the transition functions in the form (state,input) -> state
-	 * @param tpair represents the pair <state,character> that defines the input of the transition function
+	 * @param pair represents the pair <state,symbol> that defines the input of the transition function
 	 * @param int represents the state in which the transition function sends the input pair
 	 */
-	map<tpair,int> transitionF;
+	map<pair<int,Symbol>,int> transitionF;
+	/**
+	 * @brief This is the map that rappresents the default transitions in the form state -> state. A default
+	 * transition is taken when the state has no transition in transitionF for the input letter, so
+	 * "every other letter" needs a single entry instead of one per character
+	 */
+	map<int,int> defaultF;
+	/**
+	 * @brief This is the map that rappresents the transitions on ranges of letters in the form (state,range) -> state.
+	 * A range transition is taken when the state has no transition in transitionF for the input letter and
+	 * the letter (as unsigned number) belongs to the range; if more ranges contain it, the first one added wins
+	 */
+	map<int,vector<Range>> rangeF;
     /**
      *  @brief This is the vector that rappresents all the final states of the automata
      */
     vector<int> finalStates;
+
+	/**
+	 * Add a transition taken by every letter in the range [low, high].
+	 *
+	 * @param state
+	 *            The source state.
+	 * @param low
+	 *            First letter of the range, as unsigned number.
+	 * @param high
+	 *            Last letter of the range, as unsigned number.
+	 * @param target
+	 *            The state reached with a letter of the range.
+	 */
+	void addRangeTransition(int state, Letter low, Letter high, int target);
+
+	/**
+	 * Add a transition taken by every letter of a set of bytes. The set is
+	 * stored as the ranges of consecutive letters it contains.
+	 *
+	 * @param state
+	 *            The source state.
+	 * @param letters
+	 *            The set of letters, indexed by unsigned byte.
+	 * @param target
+	 *            The state reached with a letter of the set.
+	 */
+	void addSetTransition(int state, const tset &letters, int target);
+
+	/**
+	 * Find the first range transition of a state that contains the letter.
+	 *
+	 * @param state
+	 *            The source state.
+	 * @param letter
+	 *            The current input.
+	 * @return The transition, or nullptr if no range contains the letter.
+	 */
+	const Range *findRangeTransition(int state, Symbol letter) const;
+
+	/**
+	 * Add a transition taken by every Unicode code point in [low, high], compiled
+	 * into byte-level transitions over its UTF-8 encoding: the range is split into
+	 * sequences of byte ranges, and the bytes after the first one go through new
+	 * intermediate states, shared by the sequences with the same prefix. Nothing
+	 * is decoded at run time, and byte sequences that are not valid UTF-8 (overlong
+	 * forms, surrogates, code points above U+10FFFF) have no transition, so they
+	 * lead to the trap unless the state has a default transition.
+	 * Code point ranges added from the same state must not overlap.
+	 *
+	 * @param state
+	 *            The source state.
+	 * @param low
+	 *            First code point of the range.
+	 * @param high
+	 *            Last code point of the range (at most U+10FFFF).
+	 * @param target
+	 *            The state reached after a whole code point of the range.
+	 */
+	void addCodePointTransition(int state, uint32_t low, uint32_t high, int target) requires is_same_v<Symbol, char>;
 public:
 	/**
 	 * Constructor for Abstract DFA.
@@ -46,7 +143,9 @@ public:
 	 * @param noStates
 	 *            Number of states in the DFA.
 	 */
-	AbstractDFA(int noStates);
+	BasicDFA(int noStates);
+
+	virtual ~BasicDFA() = default;
 
 	/**
 	 * Reset the automaton to the initial state.
@@ -56,13 +155,14 @@ public:
 	/**
 	 * Performs one step of the DFA for a given letter. If there is a transition
 	 * for the given letter, then the automaton proceeds to the successor state.
-	 * Otherwise it goes to the sink state. By construction it will stay in the
-	 * sink for every input letter.
+	 * Otherwise it follows the first range transition that contains the letter
+	 * or the default transition of the state, if any, or it goes to the sink
+	 * state. By construction it will stay in the sink for every input letter.
 	 * 
 	 * @param letter
 	 *            The current input.
 	 */
-	virtual void doStep(char letter);
+	virtual void doStep(Symbol letter);
 	
 	/**
 	 * Check if the automaton is currently accepting.
@@ -71,6 +171,26 @@ public:
 	 */
 	bool isAccepting();
 
+	/**
+	 * Run the DFA on the input.
+	 * 
+	 * @param inputWord
+	 *            pointer to the first symbol of the input word
+	 * @param length
+	 *            number of symbols of the input word
+	 * @return True, if if the word is accepted by this automaton
+	 */
+	bool run(const Symbol *inputWord, size_t length);
+
+	/**
+	 * Run the DFA on the input.
+	 * 
+	 * @param inputWord
+	 *            sequence of symbols that contains the input word
+	 * @return True, if if the word is accepted by this automaton
+	 */
+	bool run(const vector<Symbol> &inputWord) { return run(inputWord.data(), inputWord.size()); }
+
 	/**
 	 * Run the DFA on the input.
 	 * 
@@ -78,9 +198,21 @@ public:
 	 *            stream that contains the input word
 	 * @return True, if if the word is accepted by this automaton
 	 */
-	bool run(const string &inputWord);
+	bool run(const string &inputWord) requires is_same_v<Symbol, char> {
+		return run(inputWord.data(), inputWord.length());
+	}
 };
 
+/**
+ * @brief AbstractDFA represents the automata that read bytes, the kind used by the rest of the project
+ */
+typedef BasicDFA<char> AbstractDFA;
+
+/**
+ * @brief TokenDFA represents the automata that read token kinds produced by a lexer
+ */
+typedef BasicDFA<uint16_t> TokenDFA;
+
 /**
  * DFA recognizing a given word.
  */
@@ -105,23 +237,46 @@ public:
 class CommentDFA : public AbstractDFA {
 
 public:
+	/**
+	 * @brief lineBodyState represents the state that reads the text of a // comment
+	 */
+	static const int lineBodyState = 2;
+	/**
+	 * @brief braceBodyState represents the state that reads the text of a { } comment
+	 */
+	static const int braceBodyState = 4;
+	/**
+	 * @brief parenBodyState represents the state that reads the text of a (* *) comment
+	 */
+	static const int parenBodyState = 6;
+
 	/**
 	 * Construct a new DFA that recognizes comments within source code. There
 	 * are three kinds of comments: 
 	 *  1. a single line comment that starts with // and ends with a newline 
 	 *  2. a multiline comment that starts with (* and ends with *) 
 	 *  3. a multiline comment that starts with { and ends with }
+	 *
+	 * @param validateUtf8
+	 *            If true, the text of the comment must be valid UTF-8; otherwise
+	 *            any byte is allowed.
 	 */
-	CommentDFA();
-	
-	/**
-	 * Performs one step of the DFA for a given letter. This method works
-	 * differently than in the superclass AbstractDFA.
-	 * 
-	 * @param letter
-	 *            The current input.
-	 */
-    virtual void doStep(char letter);
+	CommentDFA(bool validateUtf8 = false);
 };
 
+/**
+ * DFA recognizing identifiers.
+ */
+class IdentifierDFA : public AbstractDFA {
 
+public:
+	/**
+	 * Construct a new DFA that recognizes identifiers: a letter or an
+	 * underscore, followed by any number of letters, digits and underscores.
+	 *
+	 * @param unicode
+	 *            If true, every non-ASCII code point (encoded in UTF-8) counts
+	 *            as a letter, as in languages that allow Unicode identifiers.
+	 */
+	IdentifierDFA(bool unicode = false);
+};
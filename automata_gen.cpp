@@ -0,0 +1,107 @@
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "automata.h"
+#include "compiled.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Build the automaton described by a declaration.
+ *
+ * @return The automaton, or nullptr if the kind is unknown.
+ */
+unique_ptr<AbstractDFA> makeAutomaton(const string &kind, const string &argument) {
+    if(kind == "word" && !argument.empty()) return make_unique<WordDFA>(argument);
+    if(kind == "comment") return make_unique<CommentDFA>(argument == "utf8");
+    if(kind == "identifier") return make_unique<IdentifierDFA>(argument == "utf8");
+    return nullptr;
+}
+
+/**
+ * Write the elements of an array as a C++ initializer list, 16 per line.
+ */
+template<typename T>
+void writeArray(ostream &out, const T *values, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        out << (i % 16 == 0 ? "\n    " : " ") << (long long) values[i] << ",";
+    }
+    out << "\n";
+}
+
+}
+
+/**
+ * Compile the automata declared in a file (one "name kind [argument]" per line,
+ * '#' starts a comment) into a C++ source file containing their tables as
+ * static const data.
+ */
+int main(int argc, char* argv[]) {
+    if(argc != 3) {
+        cout << "Usage: automata_gen declarations output.cpp" << endl;
+        return 1;
+    }
+    ifstream declarations(argv[1]);
+    if(declarations.fail()){
+        cout << "Error while reading file " << argv[1] << endl;
+        return 1;
+    }
+    //The automata are kept sorted by name, as findEmbeddedDFA() expects
+    map<string, unique_ptr<CompiledDFA>> automata;
+    string line;
+    int lineNumber = 0;
+    while(getline(declarations, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        istringstream fields(line);
+        string name, kind, argument;
+        if(!(fields >> name)) continue;
+        fields >> kind >> argument;
+        unique_ptr<AbstractDFA> dfa = makeAutomaton(kind, argument);
+        if(!dfa || automata.count(name)) {
+            cout << argv[1] << ":" << lineNumber << ": invalid or duplicate declaration of " << name << endl;
+            return 1;
+        }
+        automata[name] = make_unique<CompiledDFA>(*dfa);
+    }
+
+    ostringstream out;
+    out << "// Generated by automata_gen from " << argv[1] << ". Do not edit.\n"
+        << "#include \"embedded.h\"\n\nnamespace {\n";
+    int index = 0;
+    for(auto &entry : automata) {
+        DFATable table = entry.second->table();
+        out << "\n// " << entry.first << ": " << table.numStates << " states, " << table.numClasses << " byte classes\n";
+        out << "const unsigned char dfa" << index << "_classMap[256] = {";
+        writeArray(out, table.classMap, 256);
+        out << "};\nconst int dfa" << index << "_transitions[] = {";
+        writeArray(out, table.transitions, (size_t) table.numStates * table.numClasses);
+        out << "};\nconst unsigned char dfa" << index << "_accepting[] = {";
+        writeArray(out, table.accepting, table.numStates);
+        out << "};\n";
+        index++;
+    }
+    out << "\n}\n\nconst EmbeddedDFA embeddedAutomata[] = {\n";
+    index = 0;
+    for(auto &entry : automata) {
+        DFATable table = entry.second->table();
+        out << "    {\"" << entry.first << "\", {" << table.numStates << ", " << table.numClasses << ", "
+            << table.startState << ", " << table.trapState << ", dfa" << index << "_classMap, dfa" << index
+            << "_transitions, dfa" << index << "_accepting}},\n";
+        index++;
+    }
+    out << "};\n\nconst int embeddedAutomataCount = " << automata.size() << ";\n";
+
+    ofstream outputFile(argv[2]);
+    outputFile << out.str();
+    if(outputFile.fail()){
+        cout << "Error while writing file " << argv[2] << endl;
+        return 1;
+    }
+    return 0;
+}
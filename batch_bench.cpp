@@ -0,0 +1,77 @@
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "compiled.h"
+#include "options.h"
+
+using namespace std;
+
+namespace {
+
+double elapsedSeconds(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+}
+
+/**
+ * Measure the throughput of runBatch for several numbers of lanes and
+ * prefetch distances against one input at a time, on a random complete DFA
+ * that is large enough not to fit in the caches.
+ *   batch_bench [states [inputs [length]]]
+ * The defaults (200000 states, 16 classes) give a table of about 12 MB; the
+ * inputs take at most 4 GiB.
+ */
+int main(int argc, char* argv[]) {
+    uint64_t numStates = 200000, count = 20000, length = 256;
+    if(argc > 4 || (argc > 1 && !parseNumber(argv[1], 1, INT_MAX / 16, numStates)) ||
+       (argc > 2 && !parseNumber(argv[2], 1, UINT32_MAX, count)) || (argc > 3 && !parseNumber(argv[3], 1, UINT32_MAX, length)) ||
+       count * length > (uint64_t(1) << 32)) {
+        cout << "Usage: batch_bench [states [inputs [length]]]" << endl;
+        return 1;
+    }
+    const int numClasses = 16;
+
+    mt19937_64 generator(42);
+    vector<unsigned char> classMap(256), accepting(numStates);
+    vector<int> transitions((size_t) numStates * numClasses);
+    for(int letter = 0; letter < 256; letter++) classMap[letter] = (unsigned char) (letter % numClasses);
+    for(int &target : transitions) target = (int) (generator() % numStates);
+    for(unsigned char &final : accepting) final = generator() % 2;
+    DFATable dfa{(int) numStates, numClasses, 0, -1, classMap.data(), transitions.data(), accepting.data()};
+
+    string text(count * length, ' ');
+    for(char &letter : text) letter = (char) generator();
+    vector<string_view> inputs;
+    for(size_t i = 0; i < count; i++) inputs.push_back(string_view(text).substr(i * length, length));
+    vector<unsigned char> expected(count), results(count);
+    double bytes = (double) text.length();
+    cout << "Table: " << transitions.size() * sizeof(int) / (1 << 20) << " MB, inputs: " << count << " x " << length << " bytes" << endl;
+
+    auto start = chrono::steady_clock::now();
+    for(size_t i = 0; i < count; i++) {
+        int state = dfa.startState;
+        for(unsigned char letter : inputs[i]) state = dfa.step(state, letter);
+        expected[i] = dfa.isAccepting(state);
+    }
+    cout << "one at a time: " << bytes / elapsedSeconds(start) / 1e6 << " MB/s" << endl;
+
+    for(unsigned lanes : {4u, 8u, 16u, 32u}) {
+        for(unsigned distance : {0u, 1u, lanes / 4, lanes / 2, lanes - 1}) {
+            if(distance == 1 && lanes / 4 == 1) continue;
+            BatchOptions options;
+            options.lanes = lanes;
+            options.prefetchDistance = distance;
+            start = chrono::steady_clock::now();
+            runBatch(dfa, inputs.data(), count, results.data(), options);
+            double seconds = elapsedSeconds(start);
+            cout << "lanes " << lanes << ", prefetch distance " << distance << ": " << bytes / seconds / 1e6 << " MB/s"
+                 << (results == expected ? "" : " (WRONG RESULTS)") << endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "bounded.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Mark the states reachable from a state, following the transitions forward
+ * or, with reversed adjacency lists, backward.
+ */
+vector<unsigned char> reachable(const vector<vector<int>> &edges, int from) {
+    vector<unsigned char> seen(edges.size(), 0);
+    vector<int> stack(1, from);
+    seen[from] = 1;
+    while(!stack.empty()) {
+        int state = stack.back();
+        stack.pop_back();
+        for(int next : edges[state]) {
+            if(!seen[next]) {
+                seen[next] = 1;
+                stack.push_back(next);
+            }
+        }
+    }
+    return seen;
+}
+
+}
+
+/**
+ * Construct a counter-augmented automaton. The loop of every counted state is
+ * its strongly connected component: what it reaches and what reaches it.
+ *
+ * @param dfa
+ *            The compiled automaton; its arrays must outlive this object.
+ * @param countedStates
+ *            The states whose incoming letters are counted.
+ * @param min
+ *            Smallest number of letters allowed in a counted run.
+ * @param max
+ *            Largest number of letters allowed in a counted run, or unbounded.
+ */
+BoundedDFA::BoundedDFA(const DFATable &dfa, const vector<int> &countedStates, uint32_t min, uint32_t max)
+    : table(dfa), counted(dfa.numStates, 0), component(dfa.numStates, -1), minCount(min), maxCount(max) {
+    vector<vector<int>> forward(table.numStates), backward(table.numStates);
+    for(int state = 0; state < table.numStates; state++) {
+        for(int letterClass = 0; letterClass < table.numClasses; letterClass++) {
+            int next = table.transitions[state * table.numClasses + letterClass];
+            forward[state].push_back(next);
+            backward[next].push_back(state);
+        }
+    }
+    for(int seed : countedStates) {
+        counted[seed] = 1;
+        if(component[seed] != -1) continue;
+        vector<unsigned char> reached = reachable(forward, seed), reaching = reachable(backward, seed);
+        for(int state = 0; state < table.numStates; state++) {
+            if(reached[state] && reaching[state] && state != table.trapState) component[state] = seed;
+        }
+        component[seed] = seed;
+    }
+}
+
+/**
+ * Run the DFA on the input.
+ *
+ * @param inputWord
+ *            stream that contains the input word
+ * @return True, if the word is accepted by the automaton and every counted
+ *         run respects the bounds
+ */
+bool BoundedDFA::run(const string &inputWord) const {
+    int state = table.startState;
+    uint32_t counter = 0, pending = 0;
+    for(size_t i = 0; i < inputWord.length(); i++) {
+        int next = table.step(state, inputWord[i]);
+        bool inside = component[state] != -1 && component[next] == component[state];
+        if(inside) {
+            //One more letter inside the loop: the letter held back belongs to the run
+            counter += pending;
+            pending = counted[next] ? 0 : 1;
+            if(counted[next]) counter++;
+            if(counter > maxCount) return false;
+        } else {
+            //The run ends (a letter held back is dropped) and another may start
+            if(component[state] != -1 && counter < minCount) return false;
+            counter = 0;
+            pending = 0;
+        }
+        state = next;
+        if(state == table.trapState) return false;
+    }
+    if(component[state] != -1 && counter < minCount) return false;
+    return table.isAccepting(state);
+}
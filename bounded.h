@@ -0,0 +1,76 @@
+#pragma once
+
+#include<cstdint>
+#include<string>
+#include<vector>
+#include "compiled.h"
+
+using namespace std;
+
+/**
+ * Counter-augmented DFA for bounded repetition. Instead of unrolling a bound
+ * like x{1000} or "a comment of at most 10,000 characters" into thousands of
+ * states, a compiled automaton is paired with a single counter.
+ *
+ * The caller marks the states whose incoming letters are counted (e.g. the
+ * body of a comment). A counted run starts when the automaton enters the
+ * strongly connected component of a counted state (its loop) and ends when it
+ * leaves it; the letter that enters the loop is not counted. Inside the loop,
+ * a letter that leads into a counted state is counted at once, while a letter
+ * that leads into another state of the loop is held back: it is counted when
+ * the run takes one more letter inside the loop, and dropped if the run ends
+ * instead. So the "*" of a closing "*)" is not comment text, but a "*"
+ * followed by anything but ")" is, and the intermediate bytes of a UTF-8
+ * letter are counted once the letter is complete.
+ * A run must end with minCount <= counter <= maxCount, otherwise the word is
+ * rejected; the automaton goes to the trap as soon as the counter exceeds
+ * maxCount.
+ */
+class BoundedDFA {
+    DFATable table;
+    vector<unsigned char> counted;
+    /**
+     * @brief component represents, for every state, the counted loop it belongs to, or -1
+     */
+    vector<int> component;
+    uint32_t minCount;
+    uint32_t maxCount;
+public:
+    /**
+     * @brief unbounded represents a maxCount that doesn't limit the repetition
+     */
+    static const uint32_t unbounded = 0xffffffffu;
+
+    /**
+     * Construct a counter-augmented automaton.
+     *
+     * @param dfa
+     *            The compiled automaton; its arrays must outlive this object.
+     * @param countedStates
+     *            The states whose incoming letters are counted; their loops delimit the runs.
+     * @param min
+     *            Smallest number of letters allowed in a counted run.
+     * @param max
+     *            Largest number of letters allowed in a counted run, or unbounded.
+     */
+    BoundedDFA(const DFATable &dfa, const vector<int> &countedStates, uint32_t min, uint32_t max);
+
+    /**
+     * Run the DFA on the input.
+     *
+     * @param inputWord
+     *            stream that contains the input word
+     * @return True, if the word is accepted by the automaton and every counted
+     *         run respects the bounds
+     */
+    bool run(const string &inputWord) const;
+
+    /**
+     * Check if a state is counted.
+     *
+     * @param state
+     *            A state of the automaton.
+     * @return True, if the letters leading into the state are counted.
+     */
+    bool isCounted(int state) const { return counted[state] != 0; }
+};
@@ -0,0 +1,234 @@
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checkpoint.h"
+#include "summary.h"
+
+using namespace std;
+
+namespace {
+
+const char checkpointMagic[8] = {'L', 'S', 'C', 'A', 'N', 'C', 'P', '2'};
+
+/**
+ * Fixed-size header of a checkpoint file, followed by the file name and by
+ * one AutomatonProgress for every automaton.
+ */
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t numAutomata;
+    uint32_t nameLength;
+    uint64_t offset;
+    uint64_t fileSize;
+    int64_t fileModified;
+};
+
+struct AutomatonProgress {
+    uint64_t fingerprint;
+    int32_t state;
+    uint32_t reserved;
+    uint64_t matches;
+};
+
+/**
+ * @brief streamBlock represents the number of bytes read at a time and scanned by every automaton in turn
+ */
+const size_t streamBlock = 1 << 20;
+
+/**
+ * Write all the bytes of a buffer to a file descriptor.
+ */
+bool writeAll(int fd, const string &bytes) {
+    for(size_t written = 0; written < bytes.size();) {
+        ssize_t result = ::write(fd, bytes.data() + written, bytes.size() - written);
+        if(result <= 0) return false;
+        written += (size_t) result;
+    }
+    return true;
+}
+
+/**
+ * Size and modification time (in nanoseconds) of a file.
+ */
+bool fileVersion(const string &path, uint64_t &size, int64_t &modified) {
+    struct stat info;
+    if(stat(path.c_str(), &info) != 0) return false;
+    size = (uint64_t) info.st_size;
+    modified = (int64_t) info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+/**
+ * Flush the directory that contains a file, so that a rename in it survives a crash.
+ */
+bool syncDirectory(const string &path) {
+    size_t slash = path.find_last_of('/');
+    string directory = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if(fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+}
+
+/**
+ * Progress of a scan that has not started yet: every automaton is in its start state.
+ *
+ * @param tables
+ *            The automata.
+ * @param file
+ *            The input file.
+ * @return False, if the file doesn't exist.
+ */
+bool ScanCheckpoint::start(const vector<DFATable> &tables, const string &file) {
+    fileName = file;
+    offset = 0;
+    fingerprints.clear();
+    states.clear();
+    matches.assign(tables.size(), 0);
+    for(const DFATable &table : tables) {
+        fingerprints.push_back(ScanSummary::fingerprintOf(table));
+        states.push_back(table.startState);
+    }
+    return fileVersion(file, fileSize, fileModified);
+}
+
+/**
+ * Check if this checkpoint belongs to a scan of a file with the given automata.
+ *
+ * @param tables
+ *            The automata.
+ * @param file
+ *            The input file.
+ * @return True, if the scan can be resumed from this checkpoint.
+ */
+bool ScanCheckpoint::belongsTo(const vector<DFATable> &tables, const string &file) const {
+    if(file != fileName || tables.size() != fingerprints.size()) return false;
+    //A file rewritten or truncated since the scan started doesn't continue the bytes already scanned
+    uint64_t size;
+    int64_t modified;
+    if(!fileVersion(file, size, modified) || size != fileSize || modified != fileModified || offset > size) return false;
+    for(size_t i = 0; i < tables.size(); i++) {
+        if(fingerprints[i] != ScanSummary::fingerprintOf(tables[i]) || states[i] < 0 || states[i] >= tables[i].numStates) return false;
+    }
+    return true;
+}
+
+/**
+ * Write the checkpoint to a temporary file, flush it to the disk and rename
+ * it over the previous one, then flush the directory: after a crash the
+ * checkpoint is either the previous one or the new one, never empty or torn.
+ *
+ * @param path
+ *            Destination file.
+ * @return True, if the file has been written.
+ */
+bool ScanCheckpoint::save(const string &path) const {
+    CheckpointHeader header;
+    memcpy(header.magic, checkpointMagic, sizeof(checkpointMagic));
+    header.numAutomata = (uint32_t) states.size();
+    header.nameLength = (uint32_t) fileName.length();
+    header.offset = offset;
+    header.fileSize = fileSize;
+    header.fileModified = fileModified;
+    string bytes((const char *) &header, sizeof(header));
+    bytes += fileName;
+    for(size_t i = 0; i < states.size(); i++) {
+        AutomatonProgress automaton{fingerprints[i], states[i], 0, matches[i]};
+        bytes.append((const char *) &automaton, sizeof(automaton));
+    }
+    string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) return false;
+    bool written = writeAll(fd, bytes) && fsync(fd) == 0;
+    if(::close(fd) != 0 || !written) return false;
+    return rename(temporary.c_str(), path.c_str()) == 0 && syncDirectory(path);
+}
+
+/**
+ * Read a checkpoint written by save().
+ *
+ * @param path
+ *            The checkpoint file.
+ * @return True, if the file is a valid checkpoint.
+ */
+bool ScanCheckpoint::load(const string &path) {
+    ifstream in(path, ios::binary);
+    CheckpointHeader header;
+    if(!in.read((char *) &header, sizeof(header)) || memcmp(header.magic, checkpointMagic, sizeof(checkpointMagic)) != 0) return false;
+    string name(header.nameLength, '\0');
+    if(!in.read(name.data(), (streamsize) name.length())) return false;
+    vector<AutomatonProgress> automata(header.numAutomata);
+    if(!in.read((char *) automata.data(), (streamsize) (automata.size() * sizeof(AutomatonProgress)))) return false;
+    fileName = move(name);
+    offset = header.offset;
+    fileSize = header.fileSize;
+    fileModified = header.fileModified;
+    fingerprints.clear();
+    states.clear();
+    matches.clear();
+    for(const AutomatonProgress &automaton : automata) {
+        fingerprints.push_back(automaton.fingerprint);
+        states.push_back(automaton.state);
+        matches.push_back(automaton.matches);
+    }
+    return true;
+}
+
+/**
+ * Scan a file with several automata in one pass, from the position of a
+ * checkpoint. Every block is scanned by each automaton in turn while it is
+ * in the cache; an automaton in its trap state skips the rest of the file.
+ *
+ * @param tables
+ *            The automata.
+ * @param progress
+ *            The position to start from; receives the final progress.
+ * @param checkpointPath
+ *            Where checkpoints are saved, or empty for none.
+ * @param interval
+ *            Bytes between two checkpoints.
+ * @param stop
+ *            Flag that requests an early stop, or nullptr.
+ * @return False, if the file could not be read, has been changed since the
+ *         scan started, or a checkpoint could not be written.
+ */
+bool streamScan(const vector<DFATable> &tables, ScanCheckpoint &progress, const string &checkpointPath, uint64_t interval,
+                const atomic<bool> *stop) {
+    if(!progress.belongsTo(tables, progress.fileName)) return false;
+    ifstream inputFile(progress.fileName, ios::binary);
+    inputFile.seekg((streamoff) progress.offset);
+    if(inputFile.fail()) return false;
+    string block(streamBlock, '\0');
+    uint64_t nextCheckpoint = progress.offset + interval;
+    while(true) {
+        if(stop != nullptr && stop->load()) break;
+        inputFile.read(block.data(), (streamsize) block.size());
+        size_t read = (size_t) inputFile.gcount();
+        if(read == 0) break;
+        for(size_t i = 0; i < tables.size(); i++) {
+            const DFATable &table = tables[i];
+            int state = progress.states[i];
+            if(state == table.trapState) continue;
+            uint64_t found = 0;
+            for(size_t position = 0; position < read; position++) {
+                state = table.step(state, (unsigned char) block[position]);
+                found += table.accepting[state];
+            }
+            progress.states[i] = state;
+            progress.matches[i] += found;
+        }
+        progress.offset += read;
+        if(!checkpointPath.empty() && progress.offset >= nextCheckpoint) {
+            if(!progress.save(checkpointPath)) return false;
+            nextCheckpoint = progress.offset + interval;
+        }
+    }
+    if(inputFile.bad()) return false;
+    return checkpointPath.empty() || progress.save(checkpointPath);
+}
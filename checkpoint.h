@@ -0,0 +1,113 @@
+#pragma once
+
+#include<atomic>
+#include<cstdint>
+#include<string>
+#include<vector>
+#include "compiled.h"
+
+using namespace std;
+
+/**
+ * Progress of a long scan of a file with several automata: everything needed
+ * to continue the scan from the same byte after the process has been killed.
+ * A DFA keeps no buffer, so the partial matches that span the checkpoint are
+ * carried by the current state of every automaton.
+ */
+struct ScanCheckpoint {
+    /**
+     * @brief fileName represents the input file
+     */
+    string fileName;
+    /**
+     * @brief fileSize represents the size of the input file when the scan started
+     */
+    uint64_t fileSize = 0;
+    /**
+     * @brief fileModified represents the modification time of the input file when the scan started, in nanoseconds
+     */
+    int64_t fileModified = 0;
+    /**
+     * @brief offset represents the number of bytes of the file already scanned
+     */
+    uint64_t offset = 0;
+    /**
+     * @brief fingerprints represents a hash of every automaton, so that the scan is not resumed with other automata
+     */
+    vector<uint64_t> fingerprints;
+    /**
+     * @brief states represents the current state of every automaton
+     */
+    vector<int32_t> states;
+    /**
+     * @brief matches represents, for every automaton, the number of prefixes accepted so far
+     */
+    vector<uint64_t> matches;
+
+    /**
+     * Progress of a scan that has not started yet. The size and the
+     * modification time of the file are recorded, so that the scan is not
+     * resumed after the file has been changed.
+     *
+     * @param tables
+     *            The automata.
+     * @param file
+     *            The input file.
+     * @return False, if the file doesn't exist.
+     */
+    bool start(const vector<DFATable> &tables, const string &file);
+
+    /**
+     * Check if this checkpoint belongs to a scan of a file with the given
+     * automata, and if the file still has the size and the modification time
+     * it had when the scan started.
+     *
+     * @param tables
+     *            The automata.
+     * @param file
+     *            The input file.
+     * @return True, if the scan can be resumed from this checkpoint.
+     */
+    bool belongsTo(const vector<DFATable> &tables, const string &file) const;
+
+    /**
+     * Write the checkpoint. The file is replaced atomically and flushed to the
+     * disk, so a kill or a crash during the write leaves the previous checkpoint.
+     *
+     * @param path
+     *            Destination file.
+     * @return True, if the file has been written.
+     */
+    bool save(const string &path) const;
+
+    /**
+     * Read a checkpoint written by save().
+     *
+     * @param path
+     *            The checkpoint file.
+     * @return True, if the file is a valid checkpoint.
+     */
+    bool load(const string &path);
+};
+
+/**
+ * Scan a file with several automata in one pass, one block at a time, from
+ * the position of a checkpoint, and save a checkpoint every interval bytes.
+ * The scan stops early, after saving a checkpoint, when stop becomes true
+ * (e.g. from a SIGTERM handler on a preemptible machine).
+ *
+ * @param tables
+ *            The automata.
+ * @param progress
+ *            The position to start from; receives the final progress.
+ * @param checkpointPath
+ *            Where checkpoints are saved, or empty for none.
+ * @param interval
+ *            Bytes between two checkpoints.
+ * @param stop
+ *            Flag that requests an early stop, or nullptr.
+ * @return False, if the file could not be read, has been changed since the
+ *         scan started, or a checkpoint could not be written.
+ */
+bool streamScan(const vector<DFATable> &tables, ScanCheckpoint &progress, const string &checkpointPath, uint64_t interval,
+                const atomic<bool> *stop = nullptr);
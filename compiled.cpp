@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <map>
+#include "compiled.h"
+
+using namespace std;
+
+/**
+ * Run the DFA on the input. The scan stops as soon as the trap state is
+ * reached.
+ *
+ * @param inputWord
+ *            stream that contains the input word
+ * @return True, if the word is accepted by this automaton
+ */
+bool DFATable::run(const string &inputWord) const {
+    int state = startState;
+    for(int i = 0; i < (int) inputWord.length(); i++) {
+        state = step(state, inputWord[i]);
+        //Once in the trap state the result can't change anymore
+        if(state == trapState) break;
+    }
+    return isAccepting(state);
+}
+
+/**
+ * Run the DFA on the input and collect the end offsets of its accepted
+ * prefixes. The scan stops as soon as the trap state is reached.
+ *
+ * @param inputWord
+ *            The input word.
+ * @param ends
+ *            Receives the lengths of the accepted non-empty prefixes, in increasing order.
+ * @return True, if the word is accepted by this automaton
+ */
+bool DFATable::acceptedPrefixes(string_view inputWord, vector<uint64_t> &ends) const {
+    ends.clear();
+    int state = startState;
+    for(size_t i = 0; i < inputWord.length() && state != trapState; i++) {
+        state = step(state, inputWord[i]);
+        if(isAccepting(state)) ends.push_back(i + 1);
+    }
+    return inputWord.empty() ? isAccepting(state) : !ends.empty() && ends.back() == inputWord.length();
+}
+
+/**
+ * Run a DFA on many inputs at once, in interleaved lanes.
+ *
+ * @param dfa
+ *            The automaton.
+ * @param inputs
+ *            The input words.
+ * @param count
+ *            The number of inputs.
+ * @param results
+ *            Receives 1 for every accepted input and 0 for the others.
+ * @param options
+ *            Number of lanes and prefetch distance.
+ */
+void runBatch(const DFATable &dfa, const string_view *inputs, size_t count, unsigned char *results,
+              const BatchOptions &options) {
+    unsigned lanes = min(max(options.lanes, 1u), BatchOptions::maxLanes);
+    unsigned distance = options.prefetchDistance % lanes;
+    //For every lane: the input it scans (or count if it is idle), the position and the state
+    size_t input[BatchOptions::maxLanes], position[BatchOptions::maxLanes];
+    int state[BatchOptions::maxLanes];
+    size_t next = 0, active = 0;
+    for(unsigned lane = 0; lane < lanes; lane++) {
+        input[lane] = next < count ? next++ : count;
+        position[lane] = 0;
+        state[lane] = dfa.startState;
+        if(input[lane] < count) active++;
+    }
+    while(active > 0) {
+        for(unsigned lane = 0; lane < lanes; lane++) {
+            if(input[lane] == count) continue;
+            const string_view &word = inputs[input[lane]];
+            if(position[lane] == word.length() || state[lane] == dfa.trapState) {
+                //The lane is done: it takes the next input, if there is one
+                results[input[lane]] = dfa.isAccepting(state[lane]);
+                input[lane] = next < count ? next++ : count;
+                position[lane] = 0;
+                state[lane] = dfa.startState;
+                if(input[lane] == count) active--;
+                continue;
+            }
+            state[lane] = dfa.step(state[lane], word[position[lane]++]);
+            if(distance != 0) {
+                //The cell that another lane will read distance steps from now is already known
+                unsigned ahead = (lane + distance) % lanes;
+                if(input[ahead] != count && position[ahead] < inputs[input[ahead]].length()) {
+                    unsigned char letter = inputs[input[ahead]][position[ahead]];
+                    __builtin_prefetch(&dfa.transitions[state[ahead] * dfa.numClasses + dfa.classMap[letter]]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Compile an automaton from its transition data. Every row starts from the
+ * default transition of the state (or the trap), then the range transitions and
+ * the single-letter transitions are written over it, in reverse order of
+ * priority. The trap state of the source automaton becomes the last row.
+ *
+ * @param dfa
+ *            The automaton to compile.
+ */
+CompiledDFA::CompiledDFA(const AbstractDFA &dfa) : numStates(dfa.numStates + 1), startState(AbstractDFA::initialState),
+                                                   trapState(dfa.numStates) {
+    //The successor of every (state, byte) pair, column by column
+    vector<vector<int>> columns(256, vector<int>(numStates, trapState));
+    for(auto &fdefault : dfa.defaultF) {
+        for(int letter = 0; letter < 256; letter++) columns[letter][fdefault.first] = fdefault.second;
+    }
+    for(auto &franges : dfa.rangeF) {
+        //The first range added wins, so the ranges are written from the last one
+        for(auto frange = franges.second.rbegin(); frange != franges.second.rend(); ++frange) {
+            for(int letter = frange->low; letter <= frange->high; letter++) {
+                columns[letter][franges.first] = frange->target;
+            }
+        }
+    }
+    for(auto &ftran : dfa.transitionF) {
+        columns[(unsigned char) ftran.first.second][ftran.first.first] = ftran.second;
+    }
+    //Transitions to the trap state of the source automaton go to the trap row
+    for(auto &column : columns) {
+        for(int &target : column) {
+            if(target == AbstractDFA::trapState) target = trapState;
+        }
+    }
+    accepting.assign(numStates, 0);
+    for(int state : dfa.finalStates) {
+        if(state >= 0 && state < trapState) accepting[state] = 1;
+    }
+
+    //Bytes with the same column can't be told apart by the automaton, so they share a class
+    map<vector<int>, int> classOfColumn;
+    classMap.assign(256, 0);
+    for(int letter = 0; letter < 256; letter++) {
+        auto inserted = classOfColumn.insert(pair<vector<int>, int>(columns[letter], (int) classOfColumn.size()));
+        classMap[letter] = (unsigned char) inserted.first->second;
+    }
+    numClasses = (int) classOfColumn.size();
+    transitions.assign((size_t) numStates * numClasses, 0);
+    for(int letter = 0; letter < 256; letter++) {
+        for(int state = 0; state < numStates; state++) {
+            transitions[(size_t) state * numClasses + classMap[letter]] = columns[letter][state];
+        }
+    }
+}
+
+/**
+ * Copy a compiled table into owned storage.
+ *
+ * @param table
+ *            The table to copy.
+ */
+CompiledDFA::CompiledDFA(const DFATable &table)
+    : numStates(table.numStates), numClasses(table.numClasses), startState(table.startState),
+      trapState(table.trapState),
+      classMap(table.classMap, table.classMap + 256),
+      transitions(table.transitions, table.transitions + (size_t) table.numStates * table.numClasses),
+      accepting(table.accepting, table.accepting + table.numStates) {}
+
+/**
+ * View of the compiled automaton.
+ *
+ * @return The table.
+ */
+DFATable CompiledDFA::table() const {
+    return DFATable{numStates, numClasses, startState, trapState,
+                    classMap.data(), transitions.data(), accepting.data()};
+}
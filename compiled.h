@@ -0,0 +1,182 @@
+#pragma once
+
+#include<cstdint>
+#include<string>
+#include<string_view>
+#include<vector>
+#include "automata.h"
+#include "hugepages.h"
+
+using namespace std;
+
+/**
+ * Read-only view of a compiled DFA: a dense transition table indexed by state
+ * and byte class. The automaton is complete, the trap state is an ordinary
+ * non-accepting state whose row loops on itself.
+ * The view doesn't own its arrays, so it can point either into a CompiledDFA or
+ * into static const tables embedded in the binary.
+ */
+struct DFATable {
+    /**
+     * @brief numStates represents the number of rows of the table (trap state included)
+     */
+    int numStates;
+    /**
+     * @brief numClasses represents the number of byte classes, i.e. the number of columns
+     */
+    int numClasses;
+    /**
+     * @brief startState represents the initial state
+     */
+    int startState;
+    /**
+     * @brief trapState represents the state that can't be left, or -1 if there is none
+     */
+    int trapState;
+    /**
+     * @brief classMap represents the class of every byte (256 entries)
+     */
+    const unsigned char *classMap;
+    /**
+     * @brief transitions represents the successor of every state for every class, row by row
+     */
+    const int *transitions;
+    /**
+     * @brief accepting represents, for every state, 1 if the state is final and 0 otherwise
+     */
+    const unsigned char *accepting;
+
+    /**
+     * Successor of a state for a given letter.
+     *
+     * @param state
+     *            The current state.
+     * @param letter
+     *            The current input.
+     * @return The next state.
+     */
+    int step(int state, unsigned char letter) const {
+        return transitions[state * numClasses + classMap[letter]];
+    }
+
+    /**
+     * Check if a state is final.
+     *
+     * @param state
+     *            A state of the automaton.
+     * @return True, if the state is accepting.
+     */
+    bool isAccepting(int state) const { return accepting[state] != 0; }
+
+    /**
+     * Run the DFA on the input. The scan stops as soon as the trap state is
+     * reached.
+     *
+     * @param inputWord
+     *            stream that contains the input word
+     * @return True, if the word is accepted by this automaton
+     */
+    bool run(const string &inputWord) const;
+
+    /**
+     * Run the DFA on the input and collect where its matches end, i.e. the
+     * lengths of the non-empty prefixes it accepts.
+     *
+     * @param inputWord
+     *            The input word.
+     * @param ends
+     *            Receives the end offsets, in increasing order.
+     * @return True, if the word is accepted by this automaton
+     */
+    bool acceptedPrefixes(string_view inputWord, vector<uint64_t> &ends) const;
+};
+
+/**
+ * Tuning of runBatch.
+ */
+struct BatchOptions {
+    /**
+     * @brief lanes represents the number of inputs scanned together (at most maxLanes)
+     */
+    unsigned lanes = 16;
+    /**
+     * @brief prefetchDistance represents how many lane steps before its use the next transition
+     * of a lane is prefetched, or 0 to disable the prefetch (less than lanes)
+     */
+    unsigned prefetchDistance = 8;
+
+    static constexpr unsigned maxLanes = 64;
+};
+
+/**
+ * Run a DFA on many inputs at once. The inputs are scanned in interleaved
+ * lanes, one byte of every lane in turn, so the loads of the different lanes
+ * overlap instead of waiting for each other; when a lane finishes its input
+ * it takes the next one. Since the next byte of a lane is known, the table
+ * cell it will read is prefetched a few lane steps in advance, which hides
+ * the cache misses of tables larger than the L2 cache.
+ *
+ * @param dfa
+ *            The automaton.
+ * @param inputs
+ *            The input words.
+ * @param count
+ *            The number of inputs.
+ * @param results
+ *            Receives 1 for every accepted input and 0 for the others.
+ * @param options
+ *            Number of lanes and prefetch distance.
+ */
+void runBatch(const DFATable &dfa, const string_view *inputs, size_t count, unsigned char *results,
+              const BatchOptions &options = BatchOptions());
+
+/**
+ * DFA compiled into a dense transition table. Bytes that behave the same way in
+ * every state are merged into one class, so the table has one column per class
+ * instead of one per byte.
+ */
+class CompiledDFA {
+    int numStates;
+    int numClasses;
+    int startState;
+    int trapState;
+    vector<unsigned char> classMap;
+    // the table is the large part: it goes on huge pages when it is big enough
+    vector<int, HugePageAllocator<int>> transitions;
+    vector<unsigned char> accepting;
+public:
+    /**
+     * Compile an automaton from its transition data (single letters, sets and
+     * ranges of letters, default transitions). The trap state of the source
+     * automaton becomes the last row of the table.
+     *
+     * @param dfa
+     *            The automaton to compile.
+     */
+    CompiledDFA(const AbstractDFA &dfa);
+
+    /**
+     * Copy a compiled table (e.g. one embedded in the binary) into owned storage.
+     *
+     * @param table
+     *            The table to copy.
+     */
+    CompiledDFA(const DFATable &table);
+
+    /**
+     * View of the compiled automaton. The view is invalidated when this object
+     * is destroyed.
+     *
+     * @return The table.
+     */
+    DFATable table() const;
+
+    /**
+     * Run the DFA on the input.
+     *
+     * @param inputWord
+     *            stream that contains the input word
+     * @return True, if the word is accepted by this automaton
+     */
+    bool run(const string &inputWord) const { return table().run(inputWord); }
+};
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "corpus.h"
+
+using namespace std;
+
+namespace {
+
+const char corpusMagic[8] = {'L', 'C', 'O', 'R', 'P', 'U', 'S', '1'};
+
+/**
+ * Fixed-size header of a corpus file. The data blob follows it, then the
+ * offsets (count + 1 uint64, the last one is the size of the blob) at
+ * offsetsStart, a multiple of 8.
+ */
+struct CorpusHeader {
+    char magic[8];
+    uint64_t count;
+    uint64_t dataBytes;
+    uint64_t offsetsStart;
+};
+
+/**
+ * @brief viewBlock represents the number of inputs whose views are built and scanned by runBatch at a time
+ */
+const size_t viewBlock = 4096;
+
+}
+
+/**
+ * Start a corpus file: the header is written again by close(), once the
+ * sizes are known.
+ *
+ * @param path
+ *            Destination file.
+ * @return True, if the file could be created.
+ */
+bool CorpusWriter::open(const string &path) {
+    out.open(path, ios::binary | ios::trunc);
+    offsets.assign(1, 0);
+    CorpusHeader header{};
+    out.write((const char *) &header, sizeof(header));
+    return !out.fail();
+}
+
+/**
+ * Append an input to the data blob.
+ *
+ * @param input
+ *            The bytes of the input.
+ * @return True, if the input has been written.
+ */
+bool CorpusWriter::add(string_view input) {
+    out.write(input.data(), (streamsize) input.length());
+    offsets.push_back(offsets.back() + input.length());
+    return !out.fail();
+}
+
+/**
+ * Write the offsets and the header and close the file.
+ *
+ * @return True, if the corpus is complete.
+ */
+bool CorpusWriter::close() {
+    CorpusHeader header;
+    memcpy(header.magic, corpusMagic, sizeof(corpusMagic));
+    header.count = offsets.size() - 1;
+    header.dataBytes = offsets.back();
+    header.offsetsStart = (sizeof(CorpusHeader) + header.dataBytes + 7) & ~uint64_t(7);
+    static const char padding[8] = {0};
+    out.write(padding, (streamsize) (header.offsetsStart - sizeof(CorpusHeader) - header.dataBytes));
+    out.write((const char *) offsets.data(), (streamsize) (offsets.size() * sizeof(uint64_t)));
+    out.seekp(0);
+    out.write((const char *) &header, sizeof(header));
+    out.close();
+    return !out.fail();
+}
+
+PackedCorpus::PackedCorpus() : data(nullptr), offsets(nullptr), count(0), mapping(nullptr), mappingSize(0) {}
+
+PackedCorpus::~PackedCorpus() { clear(); }
+
+/**
+ * Unmap the corpus.
+ */
+void PackedCorpus::clear() {
+    if(mapping != nullptr) munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+    data = nullptr;
+    offsets = nullptr;
+    count = 0;
+}
+
+/**
+ * Map a corpus written by CorpusWriter. The kernel is told that the blob is
+ * read sequentially, so it reads ahead aggressively.
+ *
+ * @param path
+ *            The corpus file.
+ * @return True, if the file is a valid corpus.
+ */
+bool PackedCorpus::open(const string &path) {
+    clear();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat info;
+    void *mapped = MAP_FAILED;
+    if(fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(CorpusHeader)) {
+        mapped = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if(mapped == MAP_FAILED) return false;
+    mapping = mapped;
+    mappingSize = (size_t) info.st_size;
+
+    const CorpusHeader *header = (const CorpusHeader *) mapped;
+    //dataBytes is bounded before the addition, so that a crafted header cannot make it overflow
+    if(memcmp(header->magic, corpusMagic, sizeof(corpusMagic)) != 0 || header->offsetsStart % 8 != 0 ||
+       header->dataBytes > mappingSize - sizeof(CorpusHeader) ||
+       header->offsetsStart < sizeof(CorpusHeader) + header->dataBytes || header->offsetsStart > mappingSize ||
+       header->count >= (mappingSize - header->offsetsStart) / sizeof(uint64_t)) {
+        clear();
+        return false;
+    }
+    const char *base = (const char *) mapped;
+    data = base + sizeof(CorpusHeader);
+    offsets = (const uint64_t *) (base + header->offsetsStart);
+    count = header->count;
+    if(offsets[0] != 0 || offsets[count] != header->dataBytes || !is_sorted(offsets, offsets + count + 1)) {
+        clear();
+        return false;
+    }
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+    return true;
+}
+
+/**
+ * Run a DFA on every input of a packed corpus. Every thread takes a
+ * contiguous range of inputs and scans it with runBatch, a block of views at
+ * a time, so no view array for the whole corpus is allocated.
+ *
+ * @param dfa
+ *            The automaton.
+ * @param corpus
+ *            The inputs.
+ * @param results
+ *            Receives 1 for every accepted input and 0 for the others (corpus.size() entries).
+ * @param threads
+ *            Number of worker threads, or 0 for one per hardware thread.
+ * @param options
+ *            Number of lanes and prefetch distance of runBatch.
+ */
+void runCorpus(const DFATable &dfa, const PackedCorpus &corpus, unsigned char *results, unsigned threads,
+               const BatchOptions &options) {
+    if(threads == 0) threads = max(1u, thread::hardware_concurrency());
+    size_t count = corpus.size();
+    threads = (unsigned) max<size_t>(1, min<size_t>(threads, count / viewBlock + 1));
+    auto scanRange = [&](unsigned worker) {
+        size_t first = count * worker / threads, last = count * (worker + 1) / threads;
+        vector<string_view> views;
+        for(size_t block = first; block < last; block += viewBlock) {
+            size_t blockEnd = min(last, block + viewBlock);
+            views.clear();
+            for(size_t i = block; i < blockEnd; i++) views.push_back(corpus[i]);
+            runBatch(dfa, views.data(), views.size(), results + block, options);
+        }
+    };
+    vector<thread> workers;
+    for(unsigned worker = 1; worker < threads; worker++) workers.emplace_back(scanRange, worker);
+    scanRange(0);
+    for(thread &worker : workers) worker.join();
+}
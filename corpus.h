@@ -0,0 +1,113 @@
+#pragma once
+
+#include<cstdint>
+#include<fstream>
+#include<string>
+#include<string_view>
+#include<vector>
+#include "compiled.h"
+
+using namespace std;
+
+/**
+ * Writes a packed corpus: many small inputs stored one after the other in a
+ * single data blob, followed by the array of their offsets, so that millions
+ * of inputs are one file to map instead of millions of files or allocations.
+ */
+class CorpusWriter {
+    ofstream out;
+    vector<uint64_t> offsets;
+public:
+    /**
+     * Start a corpus file.
+     *
+     * @param path
+     *            Destination file.
+     * @return True, if the file could be created.
+     */
+    bool open(const string &path);
+
+    /**
+     * Append an input.
+     *
+     * @param input
+     *            The bytes of the input.
+     * @return True, if the input has been written.
+     */
+    bool add(string_view input);
+
+    /**
+     * Write the offsets and the header and close the file.
+     *
+     * @return True, if the corpus is complete.
+     */
+    bool close();
+};
+
+/**
+ * Read-only packed corpus mapped with mmap. The inputs are views into the
+ * mapping, so opening a corpus doesn't read or copy it.
+ */
+class PackedCorpus {
+    const char *data;
+    const uint64_t *offsets;
+    uint64_t count;
+    void *mapping;
+    size_t mappingSize;
+
+    void clear();
+public:
+    PackedCorpus();
+    ~PackedCorpus();
+
+    PackedCorpus(const PackedCorpus &) = delete;
+    PackedCorpus &operator=(const PackedCorpus &) = delete;
+
+    /**
+     * Map a corpus written by CorpusWriter. The file stays mapped until the
+     * object is destroyed or another corpus is opened.
+     *
+     * @param path
+     *            The corpus file.
+     * @return True, if the file is a valid corpus.
+     */
+    bool open(const string &path);
+
+    /**
+     * Number of inputs.
+     */
+    size_t size() const { return (size_t) count; }
+
+    /**
+     * Total size of the inputs in bytes.
+     */
+    uint64_t bytes() const { return count == 0 ? 0 : offsets[count]; }
+
+    /**
+     * An input of the corpus.
+     *
+     * @param index
+     *            Index of the input, less than size().
+     * @return The bytes of the input.
+     */
+    string_view operator[](size_t index) const { return string_view(data + offsets[index], offsets[index + 1] - offsets[index]); }
+};
+
+/**
+ * Run a DFA on every input of a packed corpus, in corpus order. The corpus is
+ * cut into as many contiguous ranges as threads, so every thread reads its
+ * part of the blob sequentially, and each range is scanned with runBatch.
+ *
+ * @param dfa
+ *            The automaton.
+ * @param corpus
+ *            The inputs.
+ * @param results
+ *            Receives 1 for every accepted input and 0 for the others (corpus.size() entries).
+ * @param threads
+ *            Number of worker threads, or 0 for one per hardware thread.
+ * @param options
+ *            Number of lanes and prefetch distance of runBatch.
+ */
+void runCorpus(const DFATable &dfa, const PackedCorpus &corpus, unsigned char *results, unsigned threads = 0,
+               const BatchOptions &options = BatchOptions());
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "corpus.h"
+#include "embedded.h"
+#include "options.h"
+#include "results.h"
+
+using namespace std;
+
+/**
+ * Pack many small inputs into one corpus file, or run an embedded automaton
+ * on every input of a corpus.
+ *   corpus pack [--lines] corpusfile inputfile...
+ *   corpus run [--threads n] [--verdicts] [--results resultfile] corpusfile automaton
+ * pack stores every input file as one input, or with --lines every line of
+ * the input files (without its newline). run prints the number of accepted
+ * inputs and the throughput; with --verdicts it also prints the verdict of
+ * every input, one per line, and with --results it writes them as a columnar
+ * result file (file ID = index of the input, pattern ID 0). At most 1024
+ * threads are used.
+ */
+int main(int argc, char* argv[]) {
+    string command = argc > 1 ? argv[1] : "";
+    int argi = 2;
+    bool lines = false, verdicts = false;
+    uint64_t threads = 0;
+    string resultsFile;
+    bool validOptions = true;
+    while(validOptions && argi < argc && string(argv[argi]).rfind("--", 0) == 0) {
+        string option(argv[argi]);
+        if(option == "--lines") {
+            lines = true;
+            argi++;
+        } else if(option == "--verdicts") {
+            verdicts = true;
+            argi++;
+        } else if(option == "--results" && argi + 1 < argc) {
+            resultsFile = argv[argi + 1];
+            argi += 2;
+        } else if(option == "--threads" && argi + 1 < argc) {
+            // every thread also encodes its own result block, so the count is bounded
+            validOptions = parseNumber(argv[argi + 1], 0, 1024, threads);
+            argi += 2;
+        } else {
+            break;
+        }
+    }
+    if(!validOptions) command.clear();
+    if(command == "pack" && argc - argi >= 2) {
+        CorpusWriter writer;
+        if(!writer.open(argv[argi])) {
+            cout << "Error while writing file " << argv[argi] << endl;
+            return 1;
+        }
+        size_t inputs = 0;
+        for(int i = argi + 1; i < argc; i++) {
+            ifstream inputFile(argv[i], ios::binary);
+            if(inputFile.fail()) {
+                cout << "Error while reading file " << argv[i] << endl;
+                return 1;
+            }
+            bool written = true;
+            if(lines) {
+                string line;
+                while(written && getline(inputFile, line)) {
+                    written = writer.add(line);
+                    inputs++;
+                }
+            } else {
+                string input((istreambuf_iterator<char>(inputFile)), (istreambuf_iterator<char>()));
+                written = writer.add(input);
+                inputs++;
+            }
+            if(!written) {
+                cout << "Error while writing file " << argv[argi] << endl;
+                return 1;
+            }
+        }
+        if(!writer.close()) {
+            cout << "Error while writing file " << argv[argi] << endl;
+            return 1;
+        }
+        cout << "Inputs: " << inputs << endl;
+        return 0;
+    }
+    if(command == "run" && argc - argi == 2) {
+        PackedCorpus corpus;
+        if(!corpus.open(argv[argi])) {
+            cout << "Invalid corpus file " << argv[argi] << endl;
+            return 1;
+        }
+        const DFATable *table = findEmbeddedDFA(argv[argi + 1]);
+        if(table == nullptr) {
+            cout << "Unknown automaton " << argv[argi + 1] << endl;
+            return 1;
+        }
+        vector<unsigned char> results(corpus.size());
+        auto start = chrono::steady_clock::now();
+        runCorpus(*table, corpus, results.data(), (unsigned) threads);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if(verdicts) {
+            for(unsigned char result : results) cout << (int) result << '\n';
+        }
+        if(!resultsFile.empty()) {
+            ResultWriter writer;
+            if(!writer.open(resultsFile)) {
+                cout << "Error while writing file " << resultsFile << endl;
+                return 1;
+            }
+            // every thread encodes a contiguous range of rows in its own block and writes it when it is full
+            unsigned writers = threads == 0 ? max(1u, thread::hardware_concurrency()) : (unsigned) threads;
+            vector<unsigned char> written(writers, 1);
+            auto encodeRange = [&](unsigned worker) {
+                ResultBlock block;
+                size_t first = results.size() * worker / writers, last = results.size() * (worker + 1) / writers;
+                for(size_t i = first; i < last; i++) {
+                    block.add(i, 0, results[i] != 0);
+                    if(block.full() && !writer.write(block)) written[worker] = 0;
+                }
+                if(!writer.write(block)) written[worker] = 0;
+            };
+            vector<thread> workers;
+            for(unsigned worker = 1; worker < writers; worker++) workers.emplace_back(encodeRange, worker);
+            encodeRange(0);
+            for(thread &worker : workers) worker.join();
+            if(count(written.begin(), written.end(), 0) != 0) {
+                cout << "Error while writing file " << resultsFile << endl;
+                return 1;
+            }
+        }
+        size_t accepted = count(results.begin(), results.end(), 1);
+        cout << "Inputs: " << corpus.size() << ", accepted: " << accepted << endl;
+        cout << "Throughput: " << corpus.bytes() / 1e6 / max(seconds, 1e-9) << " MB/s, "
+             << corpus.size() / 1e6 / max(seconds, 1e-9) << " M inputs/s" << endl;
+        return 0;
+    }
+    cout << "Usage: corpus pack [--lines] corpusfile inputfile... | corpus run [--threads n] [--verdicts] [--results resultfile] corpusfile automaton" << endl;
+    return 1;
+}
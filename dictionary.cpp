@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <map>
+#include "dictionary.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * State of the automaton while it is being built. Edges are appended in
+ * increasing letter order because the words arrive sorted.
+ */
+struct BuildState {
+    bool final = false;
+    vector<pair<unsigned char, int>> edges;
+
+    bool operator<(const BuildState &other) const {
+        return final != other.final ? final < other.final : edges < other.edges;
+    }
+};
+
+/**
+ * Builder for the incremental construction: the register holds one
+ * representative for every class of equivalent states already minimized.
+ */
+struct Builder {
+    vector<BuildState> states;
+    map<BuildState, int> registry;
+
+    int newState() {
+        states.emplace_back();
+        return (int) states.size() - 1;
+    }
+
+    /**
+     * Minimize the last branch below a state: its last child is replaced by an
+     * equivalent registered state, if there is one, or becomes the representative.
+     */
+    void replaceOrRegister(int state) {
+        int child = states[state].edges.back().second;
+        if(!states[child].edges.empty()) replaceOrRegister(child);
+        auto found = registry.find(states[child]);
+        if(found != registry.end()) {
+            states[state].edges.back().second = found->second;
+            //The child is now unreachable; it is dropped when the states are renumbered
+            states[child].edges.clear();
+        } else {
+            registry.insert(pair<BuildState, int>(states[child], child));
+        }
+    }
+};
+
+}
+
+/**
+ * Construct the minimal DFA of a set of words with the incremental algorithm
+ * of Daciuk et al. for sorted input.
+ *
+ * @param words
+ *            The words of the dictionary.
+ */
+DictionaryDFA::DictionaryDFA(vector<string> words) : AbstractDFA(0) {
+    //std::string compares bytes as unsigned chars, which is the order of the IDs
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+
+    Builder builder;
+    int root = builder.newState();
+    for(const string &w : words) {
+        //Follow the prefix shared with the previous word
+        int state = root;
+        size_t i = 0;
+        while(i < w.length() && !builder.states[state].edges.empty()
+              && builder.states[state].edges.back().first == (unsigned char) w[i]) {
+            state = builder.states[state].edges.back().second;
+            i++;
+        }
+        //The branch of the previous word after the shared prefix won't change anymore
+        if(!builder.states[state].edges.empty()) builder.replaceOrRegister(state);
+        for(; i < w.length(); i++) {
+            int next = builder.newState();
+            builder.states[state].edges.push_back(pair<unsigned char, int>((unsigned char) w[i], next));
+            state = next;
+        }
+        builder.states[state].final = true;
+    }
+    if(!builder.states[root].edges.empty()) builder.replaceOrRegister(root);
+
+    //The reachable states are renumbered in depth-first post-order, so every state comes
+    //after its successors and the root gets the last number; the order is then reversed
+    //to make the root state 0 (initialState)
+    vector<int> number(builder.states.size(), -1), postOrder;
+    vector<pair<int, size_t>> stack;
+    stack.push_back(pair<int, size_t>(root, 0));
+    number[root] = 0;
+    while(!stack.empty()) {
+        int state = stack.back().first;
+        size_t &edge = stack.back().second;
+        if(edge < builder.states[state].edges.size()) {
+            int target = builder.states[state].edges[edge++].second;
+            if(number[target] == -1) {
+                number[target] = 0;
+                stack.push_back(pair<int, size_t>(target, 0));
+            }
+        } else {
+            postOrder.push_back(state);
+            stack.pop_back();
+        }
+    }
+    numStates = (int) postOrder.size();
+    for(int i = 0; i < numStates; i++) number[postOrder[i]] = numStates - 1 - i;
+
+    //Counting the words of every state in post-order only needs the counts of its successors
+    wordCount.assign(numStates, 0);
+    finalFlags.assign(numStates, 0);
+    for(int old : postOrder) {
+        const BuildState &source = builder.states[old];
+        int state = number[old];
+        finalFlags[state] = source.final;
+        wordCount[state] = source.final ? 1 : 0;
+        for(auto &edge : source.edges) wordCount[state] += wordCount[number[edge.second]];
+    }
+
+    edgeStart.assign(numStates + 1, 0);
+    for(int old : postOrder) edgeStart[number[old] + 1] = (uint32_t) builder.states[old].edges.size();
+    for(int state = 0; state < numStates; state++) edgeStart[state + 1] += edgeStart[state];
+    edgeLetters.resize(edgeStart[numStates]);
+    edgeTargets.resize(edgeStart[numStates]);
+    edgeRank.resize(edgeStart[numStates]);
+    for(int old : postOrder) {
+        const BuildState &source = builder.states[old];
+        int state = number[old];
+        uint64_t before = source.final ? 1 : 0;
+        uint32_t e = edgeStart[state];
+        for(auto &edge : source.edges) {
+            int target = number[edge.second];
+            edgeLetters[e] = edge.first;
+            edgeTargets[e] = (uint32_t) target;
+            edgeRank[e] = before;
+            before += wordCount[target];
+            //The same transitions are also stored in the model of AbstractDFA, so run() and the
+            //compilers that read transitionF work as usual; an acyclic DFA has few edges
+            transitionF.insert(pair<tpair, int>(tpair(state, (char) edge.first), target));
+            e++;
+        }
+        if(source.final) finalStates.push_back(state);
+    }
+}
+
+/**
+ * Run the DFA on the input and return the rank of the word: the ranks of the
+ * edges along the path are summed up.
+ *
+ * @param inputWord
+ *            stream that contains the input word
+ * @return The ID of the word, or notFound if it is not in the dictionary
+ */
+int64_t DictionaryDFA::rank(string_view inputWord) const {
+    uint64_t id = 0;
+    uint32_t state = initialState;
+    for(unsigned char letter : inputWord) {
+        auto first = edgeLetters.begin() + edgeStart[state];
+        auto last = edgeLetters.begin() + edgeStart[state + 1];
+        auto edge = lower_bound(first, last, letter);
+        if(edge == last || *edge != letter) return notFound;
+        size_t e = edge - edgeLetters.begin();
+        id += edgeRank[e];
+        state = edgeTargets[e];
+    }
+    return finalFlags[state] ? (int64_t) id : notFound;
+}
+
+/**
+ * Rebuild a word from its ID. At every state the edge to follow is the last
+ * one whose rank doesn't exceed the remaining ID.
+ *
+ * @param id
+ *            A number in [0, size()).
+ * @return The word with that ID, or an empty string if the ID is out of range.
+ */
+string DictionaryDFA::word(uint64_t id) const {
+    string result;
+    if(id >= size()) return result;
+    uint32_t state = initialState;
+    while(!(finalFlags[state] && id == 0)) {
+        auto first = edgeRank.begin() + edgeStart[state];
+        auto last = edgeRank.begin() + edgeStart[state + 1];
+        size_t e = (upper_bound(first, last, id) - edgeRank.begin()) - 1;
+        id -= edgeRank[e];
+        result.push_back((char) edgeLetters[e]);
+        state = edgeTargets[e];
+    }
+    return result;
+}
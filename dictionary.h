@@ -0,0 +1,86 @@
+#pragma once
+
+#include<cstdint>
+#include<string>
+#include<string_view>
+#include<vector>
+#include "automata.h"
+#include "hugepages.h"
+
+using namespace std;
+
+/**
+ * Minimal acyclic DFA recognizing a finite set of words, with minimal perfect
+ * hashing: every state knows how many accepted words start from it, so the
+ * rank of a word in the sorted dictionary (a dense ID in [0, size())) is
+ * computed while the word is read, in O(length), and the word can be rebuilt
+ * from its ID. No separate hash table is needed to intern the words.
+ */
+class DictionaryDFA : public AbstractDFA {
+	/**
+	 * @brief edgeStart represents, for every state, the index of its first edge (numStates + 1 entries)
+	 */
+	vector<uint32_t, HugePageAllocator<uint32_t>> edgeStart;
+	/**
+	 * @brief edgeLetters represents the letter of every edge, sorted as unsigned bytes within a state
+	 */
+	vector<unsigned char, HugePageAllocator<unsigned char>> edgeLetters;
+	/**
+	 * @brief edgeTargets represents the target state of every edge
+	 */
+	vector<uint32_t, HugePageAllocator<uint32_t>> edgeTargets;
+	/**
+	 * @brief edgeRank represents, for every edge, how many words of its source state come before
+	 * the words that continue with the edge (the source state itself, if final, and the smaller siblings)
+	 */
+	vector<uint64_t, HugePageAllocator<uint64_t>> edgeRank;
+	/**
+	 * @brief wordCount represents, for every state, the number of accepted words that start from it
+	 */
+	vector<uint64_t> wordCount;
+	/**
+	 * @brief finalFlags represents, for every state, 1 if the state is final
+	 */
+	vector<unsigned char> finalFlags;
+
+public:
+	/**
+	 * @brief notFound represents the rank of a word that is not in the dictionary
+	 */
+	static const int64_t notFound = -1;
+
+	/**
+	 * Construct the minimal DFA of a set of words with the incremental
+	 * algorithm of Daciuk et al. for sorted input. The words are sorted and
+	 * deduplicated first; the ID of a word is its position in byte order.
+	 *
+	 * @param words
+	 *            The words of the dictionary.
+	 */
+	DictionaryDFA(vector<string> words);
+
+	/**
+	 * Number of words in the dictionary.
+	 *
+	 * @return The number of distinct words.
+	 */
+	uint64_t size() const { return wordCount.empty() ? 0 : wordCount[initialState]; }
+
+	/**
+	 * Run the DFA on the input and return the rank of the word.
+	 *
+	 * @param inputWord
+	 *            stream that contains the input word
+	 * @return The ID of the word, or notFound if it is not in the dictionary
+	 */
+	int64_t rank(string_view inputWord) const;
+
+	/**
+	 * Rebuild a word from its ID (the inverse of rank()).
+	 *
+	 * @param id
+	 *            A number in [0, size()).
+	 * @return The word with that ID, or an empty string if the ID is out of range.
+	 */
+	string word(uint64_t id) const;
+};
@@ -0,0 +1,24 @@
+#include <cstring>
+#include "embedded.h"
+
+using namespace std;
+
+/**
+ * Look up an embedded automaton by name. The generated array is sorted by
+ * name, so a binary search is enough.
+ *
+ * @param name
+ *            The name declared in embedded_automata.txt.
+ * @return The compiled table, or nullptr if no automaton has that name.
+ */
+const DFATable *findEmbeddedDFA(const string &name) {
+    int low = 0, high = embeddedAutomataCount - 1;
+    while(low <= high) {
+        int middle = (low + high) / 2;
+        int order = strcmp(name.c_str(), embeddedAutomata[middle].name);
+        if(order == 0) return &embeddedAutomata[middle].table;
+        if(order < 0) high = middle - 1;
+        else low = middle + 1;
+    }
+    return nullptr;
+}
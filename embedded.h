@@ -0,0 +1,40 @@
+#pragma once
+
+#include<string>
+#include "compiled.h"
+
+using namespace std;
+
+/**
+ * Automaton compiled at build time by automata_gen from the declarations in
+ * embedded_automata.txt. Its tables are static const data, so using it requires
+ * no construction work at startup.
+ */
+struct EmbeddedDFA {
+    /**
+     * @brief name represents the name under which the automaton has been declared
+     */
+    const char *name;
+    /**
+     * @brief table represents the compiled automaton
+     */
+    DFATable table;
+};
+
+/**
+ * @brief embeddedAutomata represents every embedded automaton, sorted by name
+ */
+extern const EmbeddedDFA embeddedAutomata[];
+/**
+ * @brief embeddedAutomataCount represents the number of entries of embeddedAutomata
+ */
+extern const int embeddedAutomataCount;
+
+/**
+ * Look up an embedded automaton by name.
+ *
+ * @param name
+ *            The name declared in embedded_automata.txt.
+ * @return The compiled table, or nullptr if no automaton has that name.
+ */
+const DFATable *findEmbeddedDFA(const string &name);
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include "equivalence.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * One byte for every class of the joint partition of the bytes: two bytes
+ * are in the same joint class if both automata put them in the same class.
+ */
+vector<unsigned char> jointLetters(const unsigned char *classMapA, const unsigned char *classMapB) {
+    map<pair<int, int>, unsigned char> classes;
+    for(int letter = 0; letter < 256; letter++) {
+        classes.insert(pair<pair<int, int>, unsigned char>(pair<int, int>(classMapA[letter], classMapB[letter]), (unsigned char) letter));
+    }
+    vector<unsigned char> letters;
+    for(auto &joint : classes) letters.push_back(joint.second);
+    sort(letters.begin(), letters.end());
+    return letters;
+}
+
+/**
+ * A node of a breadth-first search: the node it was reached from and the letter read.
+ */
+struct Visit {
+    size_t parent;
+    unsigned char letter;
+};
+
+string wordTo(const vector<Visit> &visits, size_t node) {
+    string word;
+    for(; node != 0; node = visits[node].parent) word.push_back((char) visits[node].letter);
+    reverse(word.begin(), word.end());
+    return word;
+}
+
+/**
+ * Breadth-first search of the product of two DFAs for the first pair of
+ * states that satisfies a condition; pairs from which a can only reach its
+ * trap state are not expanded if pruneTrap is set.
+ *
+ * @return True, if such a pair exists; its word is stored in counterexample.
+ */
+template<typename Condition>
+bool searchProduct(const DFATable &a, const DFATable &b, bool pruneTrap, Condition found, string *counterexample) {
+    vector<unsigned char> letters = jointLetters(a.classMap, b.classMap);
+    vector<pair<int, int>> pairs;
+    vector<Visit> visits;
+    unordered_map<uint64_t, size_t> seen;
+    pairs.push_back(pair<int, int>(a.startState, b.startState));
+    visits.push_back(Visit{0, 0});
+    seen.insert(pair<uint64_t, size_t>(((uint64_t) a.startState << 32) | (uint32_t) b.startState, 0));
+    for(size_t i = 0; i < pairs.size(); i++) {
+        int p = pairs[i].first, q = pairs[i].second;
+        if(found(p, q)) {
+            if(counterexample != nullptr) *counterexample = wordTo(visits, i);
+            return true;
+        }
+        if(pruneTrap && p == a.trapState) continue;
+        for(unsigned char letter : letters) {
+            int nextP = a.step(p, letter), nextQ = b.step(q, letter);
+            if(seen.insert(pair<uint64_t, size_t>(((uint64_t) nextP << 32) | (uint32_t) nextQ, pairs.size())).second) {
+                pairs.push_back(pair<int, int>(nextP, nextQ));
+                visits.push_back(Visit{i, letter});
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Union-find over the states of both automata, with path halving and union by size.
+ */
+struct UnionFind {
+    vector<int> parent, size;
+
+    UnionFind(int count) : parent(count), size(count, 1) {
+        for(int i = 0; i < count; i++) parent[i] = i;
+    }
+
+    int find(int x) {
+        while(parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    bool merge(int x, int y) {
+        x = find(x);
+        y = find(y);
+        if(x == y) return false;
+        if(size[x] < size[y]) swap(x, y);
+        parent[y] = x;
+        size[x] += size[y];
+        return true;
+    }
+};
+
+bool isSubset(const NFA::StateSet &smaller, const NFA::StateSet &larger) {
+    for(size_t word = 0; word < smaller.size(); word++) {
+        if(smaller[word] & ~larger[word]) return false;
+    }
+    return true;
+}
+
+}
+
+/**
+ * Check if two compiled DFAs accept the same language (Hopcroft-Karp). If
+ * they don't, the shortest counterexample is found by a breadth-first search
+ * of the product, since the order in which the union-find visits the pairs
+ * doesn't give the shortest one.
+ *
+ * @param a
+ *            The first automaton.
+ * @param b
+ *            The second automaton.
+ * @param counterexample
+ *            If not null and the languages differ, receives a shortest word
+ *            accepted by exactly one of the automata.
+ * @return True, if the automata are equivalent.
+ */
+bool equivalent(const DFATable &a, const DFATable &b, string *counterexample) {
+    vector<unsigned char> letters = jointLetters(a.classMap, b.classMap);
+    //The states of b follow those of a in the union-find
+    UnionFind classes(a.numStates + b.numStates);
+    vector<pair<int, int>> stack;
+    classes.merge(a.startState, a.numStates + b.startState);
+    stack.push_back(pair<int, int>(a.startState, b.startState));
+    bool same = true;
+    while(same && !stack.empty()) {
+        int p = stack.back().first, q = stack.back().second;
+        stack.pop_back();
+        if(a.isAccepting(p) != b.isAccepting(q)) {
+            same = false;
+            break;
+        }
+        for(unsigned char letter : letters) {
+            int nextP = a.step(p, letter), nextQ = b.step(q, letter);
+            if(classes.merge(nextP, a.numStates + nextQ)) stack.push_back(pair<int, int>(nextP, nextQ));
+        }
+    }
+    if(same) return true;
+    if(counterexample != nullptr) {
+        searchProduct(a, b, false, [&](int p, int q) { return a.isAccepting(p) != b.isAccepting(q); }, counterexample);
+    }
+    return false;
+}
+
+/**
+ * Check if every word accepted by a is also accepted by b.
+ *
+ * @param a
+ *            The smaller automaton.
+ * @param b
+ *            The larger automaton.
+ * @param counterexample
+ *            If not null and the inclusion doesn't hold, receives a shortest
+ *            word accepted by a and rejected by b.
+ * @return True, if the language of a is included in the language of b.
+ */
+bool isIncluded(const DFATable &a, const DFATable &b, string *counterexample) {
+    return !searchProduct(a, b, true, [&](int p, int q) { return a.isAccepting(p) && !b.isAccepting(q); }, counterexample);
+}
+
+/**
+ * Check if every word accepted by a DFA is also accepted by an NFA, with an
+ * antichain of sets of NFA states for every DFA state. The pairs are visited
+ * in breadth-first order, so a pair that is skipped because a smaller set was
+ * visited before can't hide a shorter counterexample.
+ *
+ * @param a
+ *            The smaller automaton.
+ * @param b
+ *            The larger automaton, finalized.
+ * @param counterexample
+ *            If not null and the inclusion doesn't hold, receives a shortest
+ *            word accepted by a and rejected by b.
+ * @return True, if the language of a is included in the language of b.
+ */
+bool isIncluded(const DFATable &a, const NFA &b, string *counterexample) {
+    vector<unsigned char> letters = jointLetters(a.classMap, b.byteClasses().data());
+    vector<pair<int, NFA::StateSet>> pairs;
+    vector<Visit> visits;
+    //For every state of a, the minimal sets visited with it (indexes into pairs)
+    vector<vector<size_t>> antichains(a.numStates);
+    pairs.push_back(pair<int, NFA::StateSet>(a.startState, b.startSet()));
+    visits.push_back(Visit{0, 0});
+    antichains[a.startState].push_back(0);
+    NFA::StateSet next;
+    for(size_t i = 0; i < pairs.size(); i++) {
+        int p = pairs[i].first;
+        if(a.isAccepting(p) && !b.isAccepting(pairs[i].second)) {
+            if(counterexample != nullptr) *counterexample = wordTo(visits, i);
+            return false;
+        }
+        if(p == a.trapState) continue;
+        for(unsigned char letter : letters) {
+            int nextP = a.step(p, letter);
+            b.step(pairs[i].second, letter, next);
+            vector<size_t> &antichain = antichains[nextP];
+            bool subsumed = false;
+            for(size_t other : antichain) {
+                if(isSubset(pairs[other].second, next)) {
+                    subsumed = true;
+                    break;
+                }
+            }
+            if(subsumed) continue;
+            //The sets that contain the new one are no longer minimal
+            antichain.erase(remove_if(antichain.begin(), antichain.end(),
+                                      [&](size_t other) { return isSubset(next, pairs[other].second); }),
+                            antichain.end());
+            antichain.push_back(pairs.size());
+            pairs.push_back(pair<int, NFA::StateSet>(nextP, next));
+            visits.push_back(Visit{i, letter});
+        }
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include<string>
+#include "compiled.h"
+#include "nfa.h"
+
+using namespace std;
+
+/**
+ * Check if two compiled DFAs accept the same language, with the algorithm of
+ * Hopcroft and Karp: pairs of states that must be equivalent are merged in a
+ * union-find structure, so every state is visited at most once per automaton
+ * and the check takes near-linear time. The two automata may have different
+ * byte classes.
+ *
+ * @param a
+ *            The first automaton.
+ * @param b
+ *            The second automaton.
+ * @param counterexample
+ *            If not null and the languages differ, receives a shortest word
+ *            accepted by exactly one of the automata.
+ * @return True, if the automata are equivalent.
+ */
+bool equivalent(const DFATable &a, const DFATable &b, string *counterexample = nullptr);
+
+/**
+ * Check if every word accepted by a is also accepted by b, by a
+ * breadth-first search of the product automaton.
+ *
+ * @param a
+ *            The smaller automaton.
+ * @param b
+ *            The larger automaton.
+ * @param counterexample
+ *            If not null and the inclusion doesn't hold, receives a shortest
+ *            word accepted by a and rejected by b.
+ * @return True, if the language of a is included in the language of b.
+ */
+bool isIncluded(const DFATable &a, const DFATable &b, string *counterexample = nullptr);
+
+/**
+ * Check if every word accepted by a DFA is also accepted by an NFA, without
+ * determinizing the NFA. The search visits pairs (DFA state, set of NFA
+ * states) and keeps, for every DFA state, only an antichain of the sets: a
+ * pair whose set contains the set of a pair already visited can't lead to a
+ * shorter counterexample, so it is skipped.
+ *
+ * @param a
+ *            The smaller automaton.
+ * @param b
+ *            The larger automaton, finalized.
+ * @param counterexample
+ *            If not null and the inclusion doesn't hold, receives a shortest
+ *            word accepted by a and rejected by b.
+ * @return True, if the language of a is included in the language of b.
+ */
+bool isIncluded(const DFATable &a, const NFA &b, string *counterexample = nullptr);
@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include "histogram.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Small dense index of the calling thread, used to pick its shard.
+ */
+int threadSlot() {
+    static atomic<int> nextSlot(0);
+    thread_local int slot = nextSlot.fetch_add(1, memory_order_relaxed);
+    return slot % LatencyHistogram::maxShards;
+}
+
+/**
+ * Position of the most significant bit of a non-zero value.
+ */
+int highestBit(uint64_t value) { return 63 - __builtin_clzll(value); }
+
+}
+
+/**
+ * Value below which the given fraction of the recorded values falls.
+ *
+ * @param quantile
+ *            A number between 0 and 1 (e.g. 0.99 for p99).
+ * @return The percentile, or 0 if nothing has been recorded.
+ */
+uint64_t HistogramSnapshot::percentile(double quantile) const {
+    if(totalCount == 0) return 0;
+    //The rank is the number of values that have to be at or below the percentile
+    uint64_t rank = (uint64_t)(quantile * totalCount + 0.5);
+    if(rank < 1) rank = 1;
+    if(rank > totalCount) rank = totalCount;
+    uint64_t seen = 0;
+    for(int i = 0; i < (int) counts.size(); i++){
+        seen += counts[i];
+        if(seen >= rank){
+            uint64_t bound = LatencyHistogram::bucketUpperBound(i);
+            return bound < maxValue ? bound : maxValue;
+        }
+    }
+    return maxValue;
+}
+
+/**
+ * Arithmetic mean of the recorded values.
+ *
+ * @return The mean, or 0 if nothing has been recorded.
+ */
+double HistogramSnapshot::mean() const {
+    return totalCount == 0 ? 0.0 : (double) sum / totalCount;
+}
+
+/**
+ * Remove the values of an earlier snapshot of the same histogram.
+ *
+ * @param earlier
+ *            A snapshot taken before this one.
+ */
+void HistogramSnapshot::subtract(const HistogramSnapshot &earlier) {
+    for(size_t i = 0; i < counts.size() && i < earlier.counts.size(); i++) counts[i] -= earlier.counts[i];
+    totalCount -= earlier.totalCount;
+    sum -= earlier.sum;
+}
+
+/**
+ * Write the snapshot on one line: count, sum, largest value, number of
+ * non-empty buckets and then index and count of each.
+ *
+ * @param out
+ *            Stream on which the snapshot is written.
+ */
+void HistogramSnapshot::write(ostream &out) const {
+    size_t used = counts.size() - count(counts.begin(), counts.end(), 0);
+    out << totalCount << ' ' << sum << ' ' << maxValue << ' ' << used;
+    for(size_t i = 0; i < counts.size(); i++){
+        if(counts[i] != 0) out << ' ' << i << ' ' << counts[i];
+    }
+    out << '\n';
+}
+
+/**
+ * Read a snapshot written by write().
+ *
+ * @param in
+ *            Stream from which the snapshot is read.
+ * @return False, if the line is not a valid snapshot.
+ */
+bool HistogramSnapshot::read(istream &in) {
+    size_t used;
+    if(!(in >> totalCount >> sum >> maxValue >> used)) return false;
+    counts.assign(LatencyHistogram::bucketCount, 0);
+    uint64_t seen = 0;
+    for(size_t i = 0; i < used; i++){
+        size_t index;
+        uint64_t bucketValues;
+        if(!(in >> index >> bucketValues) || index >= counts.size()) return false;
+        counts[index] += bucketValues;
+        seen += bucketValues;
+    }
+    return seen == totalCount;
+}
+
+LatencyHistogram::Shard::Shard() : sum(0), maxValue(0) {
+    for(auto &count : counts) count.store(0, memory_order_relaxed);
+}
+
+/**
+ * Constructor for LatencyHistogram.
+ *
+ * @param histogramName
+ *            Name used when the histogram is reported.
+ */
+LatencyHistogram::LatencyHistogram(const string &histogramName) : name(histogramName) {
+    for(auto &shard : shards) shard.store(nullptr, memory_order_relaxed);
+}
+
+LatencyHistogram::~LatencyHistogram() {
+    for(auto &shard : shards) delete shard.load();
+}
+
+/**
+ * Record a value (usually a latency in nanoseconds).
+ *
+ * @param value
+ *            The value to record.
+ */
+void LatencyHistogram::record(uint64_t value) {
+    Shard *shard = localShard();
+    shard->counts[bucketIndex(value)].fetch_add(1, memory_order_relaxed);
+    shard->sum.fetch_add(value, memory_order_relaxed);
+    uint64_t previous = shard->maxValue.load(memory_order_relaxed);
+    while(previous < value && !shard->maxValue.compare_exchange_weak(previous, value, memory_order_relaxed)){}
+}
+
+/**
+ * Add the values of a snapshot, as if they had been recorded by the calling
+ * thread.
+ *
+ * @param values
+ *            The values to add.
+ */
+void LatencyHistogram::add(const HistogramSnapshot &values) {
+    Shard *shard = localShard();
+    for(size_t i = 0; i < values.counts.size() && i < (size_t) bucketCount; i++){
+        if(values.counts[i] != 0) shard->counts[i].fetch_add(values.counts[i], memory_order_relaxed);
+    }
+    shard->sum.fetch_add(values.sum, memory_order_relaxed);
+    uint64_t previous = shard->maxValue.load(memory_order_relaxed);
+    while(previous < values.maxValue && !shard->maxValue.compare_exchange_weak(previous, values.maxValue, memory_order_relaxed)){}
+}
+
+/**
+ * Shard of the calling thread, created the first time the thread uses it.
+ */
+LatencyHistogram::Shard *LatencyHistogram::localShard() {
+    atomic<Shard *> &slot = shards[threadSlot()];
+    Shard *shard = slot.load(memory_order_acquire);
+    if(shard == nullptr){
+        //The first thread that uses the slot publishes the shard, a thread that loses the race discards its own
+        Shard *created = new Shard();
+        if(slot.compare_exchange_strong(shard, created, memory_order_acq_rel)){
+            shard = created;
+        }else{
+            delete created;
+        }
+    }
+    return shard;
+}
+
+/**
+ * Merge the shards of every thread into a single snapshot.
+ *
+ * @return The merged counts.
+ */
+HistogramSnapshot LatencyHistogram::snapshot() const {
+    HistogramSnapshot merged;
+    merged.counts.assign(bucketCount, 0);
+    for(auto &slot : shards){
+        Shard *shard = slot.load(memory_order_acquire);
+        if(shard == nullptr) continue;
+        for(int i = 0; i < bucketCount; i++){
+            uint64_t count = shard->counts[i].load(memory_order_relaxed);
+            merged.counts[i] += count;
+            merged.totalCount += count;
+        }
+        merged.sum += shard->sum.load(memory_order_relaxed);
+        uint64_t shardMax = shard->maxValue.load(memory_order_relaxed);
+        if(shardMax > merged.maxValue) merged.maxValue = shardMax;
+    }
+    return merged;
+}
+
+/**
+ * Name of the histogram.
+ *
+ * @return The name given at construction.
+ */
+const string &LatencyHistogram::getName() const { return name; }
+
+/**
+ * Index of the bucket that contains the given value. Values below
+ * 2^(subBucketBits+1) have a bucket each, above that every power of two is
+ * split in 2^subBucketBits buckets.
+ *
+ * @param value
+ *            A recorded value.
+ * @return The bucket index, in [0, bucketCount).
+ */
+int LatencyHistogram::bucketIndex(uint64_t value) {
+    int shift = value == 0 ? 0 : highestBit(value) - subBucketBits;
+    if(shift < 0) shift = 0;
+    return (shift << subBucketBits) + (int)(value >> shift);
+}
+
+/**
+ * Smallest value that falls in the given bucket.
+ *
+ * @param index
+ *            The bucket index.
+ * @return The lower bound of the bucket.
+ */
+uint64_t LatencyHistogram::bucketLowerBound(int index) {
+    int shift = (index >> subBucketBits) - 1;
+    if(shift < 0) shift = 0;
+    return (uint64_t)(index - (shift << subBucketBits)) << shift;
+}
+
+/**
+ * Largest value that falls in the given bucket.
+ *
+ * @param index
+ *            The bucket index.
+ * @return The upper bound of the bucket.
+ */
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    int shift = (index >> subBucketBits) - 1;
+    if(shift < 0) shift = 0;
+    return bucketLowerBound(index) + ((uint64_t(1) << shift) - 1);
+}
+
+/**
+ * Write a one-line summary of a histogram, with the values converted from
+ * nanoseconds to microseconds.
+ *
+ * @param out
+ *            Stream on which the summary is written.
+ * @param histogram
+ *            The histogram to report.
+ */
+void printLatencySummary(ostream &out, const LatencyHistogram &histogram) {
+    HistogramSnapshot merged = histogram.snapshot();
+    auto micros = [](double nanos) { return nanos / 1000.0; };
+    ios_base::fmtflags flags = out.flags();
+    out << fixed << setprecision(1)
+        << "LATENCY " << histogram.getName() << " (us): count=" << merged.totalCount
+        << " mean=" << micros(merged.mean())
+        << " p50=" << micros(merged.percentile(0.50))
+        << " p90=" << micros(merged.percentile(0.90))
+        << " p99=" << micros(merged.percentile(0.99))
+        << " p99.9=" << micros(merged.percentile(0.999))
+        << " max=" << micros(merged.maxValue) << endl;
+    out.flags(flags);
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include<atomic>
+#include<cstdint>
+#include<iostream>
+#include<string>
+#include<vector>
+
+using namespace std;
+
+/**
+ * Merged view of a LatencyHistogram at a given moment.
+ */
+class HistogramSnapshot {
+public:
+    /**
+     * @brief counts represents the number of recorded values for every bucket
+     */
+    vector<uint64_t> counts;
+    /**
+     * @brief totalCount represents the number of recorded values
+     */
+    uint64_t totalCount = 0;
+    /**
+     * @brief sum represents the sum of the recorded values
+     */
+    uint64_t sum = 0;
+    /**
+     * @brief maxValue represents the largest recorded value
+     */
+    uint64_t maxValue = 0;
+
+    /**
+     * Value below which the given fraction of the recorded values falls. The
+     * result is the upper bound of the bucket that contains the percentile,
+     * capped to the largest recorded value.
+     *
+     * @param quantile
+     *            A number between 0 and 1 (e.g. 0.99 for p99).
+     * @return The percentile, or 0 if nothing has been recorded.
+     */
+    uint64_t percentile(double quantile) const;
+
+    /**
+     * Arithmetic mean of the recorded values.
+     *
+     * @return The mean, or 0 if nothing has been recorded.
+     */
+    double mean() const;
+
+    /**
+     * Remove the values of an earlier snapshot of the same histogram, leaving
+     * the values recorded since. The largest value is kept as it is.
+     *
+     * @param earlier
+     *            A snapshot taken before this one.
+     */
+    void subtract(const HistogramSnapshot &earlier);
+
+    /**
+     * Write the snapshot on one line, with the non-empty buckets only.
+     *
+     * @param out
+     *            Stream on which the snapshot is written.
+     */
+    void write(ostream &out) const;
+
+    /**
+     * Read a snapshot written by write().
+     *
+     * @param in
+     *            Stream from which the snapshot is read.
+     * @return False, if the line is not a valid snapshot.
+     */
+    bool read(istream &in);
+};
+
+/**
+ * HDR-style histogram with log-linear buckets: every power of two is split in
+ * 2^subBucketBits linear sub-buckets, so the relative error of a percentile is
+ * at most 1/2^subBucketBits over the whole 64-bit range.
+ * Recording is lock-free: every thread increments the counters of its own shard
+ * with relaxed atomics, and the shards are only summed when a snapshot is taken.
+ */
+class LatencyHistogram {
+public:
+    /**
+     * @brief subBucketBits represents the precision of the histogram (32 sub-buckets, ~3% error)
+     */
+    static const int subBucketBits = 5;
+    /**
+     * @brief bucketCount represents the number of buckets needed to cover every 64-bit value
+     */
+    static const int bucketCount = (65 - subBucketBits) << subBucketBits;
+    /**
+     * @brief maxShards represents the number of per-thread shards; extra threads share them
+     */
+    static const int maxShards = 64;
+
+    /**
+     * Constructor for LatencyHistogram.
+     *
+     * @param histogramName
+     *            Name used when the histogram is reported.
+     */
+    LatencyHistogram(const string &histogramName);
+
+    ~LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    /**
+     * Record a value (usually a latency in nanoseconds).
+     *
+     * @param value
+     *            The value to record.
+     */
+    void record(uint64_t value);
+
+    /**
+     * Add the values of a snapshot (e.g. recorded by another process), as if
+     * they had been recorded by the calling thread.
+     *
+     * @param values
+     *            The values to add.
+     */
+    void add(const HistogramSnapshot &values);
+
+    /**
+     * Merge the shards of every thread into a single snapshot.
+     *
+     * @return The merged counts.
+     */
+    HistogramSnapshot snapshot() const;
+
+    /**
+     * Name of the histogram.
+     *
+     * @return The name given at construction.
+     */
+    const string &getName() const;
+
+    /**
+     * Index of the bucket that contains the given value.
+     *
+     * @param value
+     *            A recorded value.
+     * @return The bucket index, in [0, bucketCount).
+     */
+    static int bucketIndex(uint64_t value);
+
+    /**
+     * Smallest value that falls in the given bucket.
+     *
+     * @param index
+     *            The bucket index.
+     * @return The lower bound of the bucket.
+     */
+    static uint64_t bucketLowerBound(int index);
+
+    /**
+     * Largest value that falls in the given bucket.
+     *
+     * @param index
+     *            The bucket index.
+     * @return The upper bound of the bucket.
+     */
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    /**
+     * Counters written by the threads mapped to a shard.
+     */
+    struct Shard {
+        atomic<uint64_t> counts[bucketCount];
+        atomic<uint64_t> sum;
+        atomic<uint64_t> maxValue;
+        Shard();
+    };
+
+    string name;
+    atomic<Shard *> shards[maxShards];
+
+    /**
+     * Shard of the calling thread, created on first use.
+     */
+    Shard *localShard();
+};
+
+/**
+ * Write a one-line summary of a histogram (count, mean, p50, p90, p99, p99.9 and
+ * max), with the values converted from nanoseconds to microseconds.
+ *
+ * @param out
+ *            Stream on which the summary is written.
+ * @param histogram
+ *            The histogram to report.
+ */
+void printLatencySummary(ostream &out, const LatencyHistogram &histogram);
@@ -0,0 +1,55 @@
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+#include "hugepages.h"
+
+using namespace std;
+
+namespace {
+
+size_t roundToHugePages(size_t bytes) {
+    return (bytes + hugePageSize - 1) / hugePageSize * hugePageSize;
+}
+
+}
+
+/**
+ * Allocate memory for a table, on 2 MB pages if it is large enough.
+ *
+ * @param bytes
+ *            Size of the table.
+ * @return The memory, or nullptr if it could not be allocated.
+ */
+void *allocateTable(size_t bytes) {
+    if(bytes < hugePageSize) return ::operator new(bytes, nothrow);
+    size_t length = roundToHugePages(bytes);
+    void *memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(memory != MAP_FAILED) return memory;
+    //No reserved huge pages: a 2 MB aligned block is cut out of a larger mapping, so that
+    //transparent huge pages can back all of it
+    size_t mapped = length + hugePageSize;
+    char *block = (char *) mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(block == MAP_FAILED) return nullptr;
+    char *aligned = (char *) (((uintptr_t) block + hugePageSize - 1) / hugePageSize * hugePageSize);
+    if(aligned > block) munmap(block, aligned - block);
+    if(block + mapped > aligned + length) munmap(aligned + length, block + mapped - (aligned + length));
+    madvise(aligned, length, MADV_HUGEPAGE);
+    return aligned;
+}
+
+/**
+ * Release memory obtained from allocateTable.
+ *
+ * @param memory
+ *            The memory.
+ * @param bytes
+ *            The size passed to allocateTable.
+ */
+void releaseTable(void *memory, size_t bytes) {
+    if(memory == nullptr) return;
+    if(bytes < hugePageSize) {
+        ::operator delete(memory);
+    } else {
+        munmap(memory, roundToHugePages(bytes));
+    }
+}
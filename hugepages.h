@@ -0,0 +1,61 @@
+#pragma once
+
+#include<cstddef>
+#include<new>
+
+using namespace std;
+
+/**
+ * @brief hugePageSize represents the size of the large pages used for big tables (2 MB on x86-64)
+ */
+const size_t hugePageSize = 1 << 21;
+
+/**
+ * Allocate memory for a table. A table of at least hugePageSize bytes is
+ * placed on 2 MB pages, so that a scan doesn't miss the TLB at almost every
+ * transition: explicit huge pages are used if the system has reserved some,
+ * otherwise the memory is aligned to 2 MB and marked with
+ * madvise(MADV_HUGEPAGE) for transparent huge pages. Smaller tables use
+ * the ordinary heap.
+ *
+ * @param bytes
+ *            Size of the table.
+ * @return The memory, or nullptr if it could not be allocated.
+ */
+void *allocateTable(size_t bytes);
+
+/**
+ * Release memory obtained from allocateTable.
+ *
+ * @param memory
+ *            The memory.
+ * @param bytes
+ *            The size passed to allocateTable.
+ */
+void releaseTable(void *memory, size_t bytes);
+
+/**
+ * Allocator for the vectors that hold large tables (see allocateTable).
+ *
+ * @param T
+ *            Type of the elements.
+ */
+template<typename T>
+struct HugePageAllocator {
+    typedef T value_type;
+
+    HugePageAllocator() = default;
+    template<typename U>
+    HugePageAllocator(const HugePageAllocator<U> &) {}
+
+    T *allocate(size_t count) {
+        void *memory = allocateTable(count * sizeof(T));
+        if(memory == nullptr) throw bad_alloc();
+        return static_cast<T *>(memory);
+    }
+
+    void deallocate(T *memory, size_t count) { releaseTable(memory, count * sizeof(T)); }
+
+    template<typename U>
+    bool operator==(const HugePageAllocator<U> &) const { return true; }
+};
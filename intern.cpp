@@ -0,0 +1,104 @@
+#include <cstring>
+#include "intern.h"
+
+using namespace std;
+
+InternTable::InternTable() : slots(1024, Slot{0, noId}), blockCursor(nullptr), blockLeft(0), arenaAllocated(0) {}
+
+/**
+ * Hash used by the table (64-bit FNV-1a).
+ *
+ * @param bytes
+ *            The identifier.
+ * @return The hash.
+ */
+uint64_t InternTable::hash(string_view bytes) {
+    uint64_t h = hashSeed;
+    for(unsigned char letter : bytes) h = hashStep(h, letter);
+    return h;
+}
+
+/**
+ * Return the ID of an identifier, adding it to the table the first time.
+ *
+ * @param bytes
+ *            The identifier.
+ * @param bytesHash
+ *            hash(bytes), computed by the caller.
+ * @return The ID of the identifier.
+ */
+uint32_t InternTable::intern(string_view bytes, uint64_t bytesHash) {
+    size_t mask = slots.size() - 1;
+    for(size_t i = bytesHash & mask;; i = (i + 1) & mask) {
+        Slot &slot = slots[i];
+        if(slot.id == noId) {
+            //The table is kept at most half full, so probes stay short
+            if(2 * (names.size() + 1) > slots.size()) {
+                grow();
+                return intern(bytes, bytesHash);
+            }
+            slot.hash = bytesHash;
+            slot.id = (uint32_t) names.size();
+            names.push_back(string_view(store(bytes), bytes.length()));
+            return slot.id;
+        }
+        if(slot.hash == bytesHash && names[slot.id] == bytes) return slot.id;
+    }
+}
+
+/**
+ * Look an identifier up without adding it.
+ *
+ * @param bytes
+ *            The identifier.
+ * @return The ID of the identifier, or noId.
+ */
+uint32_t InternTable::find(string_view bytes) const {
+    uint64_t bytesHash = hash(bytes);
+    size_t mask = slots.size() - 1;
+    for(size_t i = bytesHash & mask;; i = (i + 1) & mask) {
+        const Slot &slot = slots[i];
+        if(slot.id == noId) return noId;
+        if(slot.hash == bytesHash && names[slot.id] == bytes) return slot.id;
+    }
+}
+
+/**
+ * Copy the bytes of a new identifier into the arena.
+ */
+const char *InternTable::store(string_view bytes) {
+    if(bytes.length() > blockLeft) {
+        //Identifiers longer than a block get a block of their own
+        size_t size = bytes.length() > blockSize / 4 ? bytes.length() : blockSize;
+        blocks.push_back(make_unique<char[]>(size));
+        arenaAllocated += size;
+        if(size == blockSize) {
+            blockCursor = blocks.back().get();
+            blockLeft = blockSize;
+        } else {
+            memcpy(blocks.back().get(), bytes.data(), bytes.length());
+            return blocks.back().get();
+        }
+    }
+    char *copy = blockCursor;
+    memcpy(copy, bytes.data(), bytes.length());
+    blockCursor += bytes.length();
+    blockLeft -= bytes.length();
+    return copy;
+}
+
+/**
+ * Double the number of slots; the stored hashes are reused, so no identifier
+ * is hashed again.
+ */
+void InternTable::grow() {
+    vector<Slot> old(slots.size() * 2, Slot{0, noId});
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for(const Slot &slot : old) {
+        if(slot.id == noId) continue;
+        size_t i = slot.hash & mask;
+        while(slots[i].id != noId) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include<cstdint>
+#include<memory>
+#include<string_view>
+#include<vector>
+
+using namespace std;
+
+/**
+ * Table that maps identifier bytes to stable dense IDs (0, 1, 2, ... in order
+ * of first appearance), so later stages compare integers instead of strings.
+ * The table uses open addressing with linear probing; the bytes of every
+ * identifier are copied once into an arena of large blocks, so interning never
+ * allocates a string per token and the returned views stay valid as long as
+ * the table exists.
+ */
+class InternTable {
+public:
+    /**
+     * @brief noId represents the ID returned when an identifier is not in the table
+     */
+    static const uint32_t noId = 0xffffffffu;
+
+    InternTable();
+
+    InternTable(const InternTable &) = delete;
+    InternTable &operator=(const InternTable &) = delete;
+
+    /**
+     * Hash used by the table (64-bit FNV-1a). The lexer computes it while it
+     * scans the identifier, by calling hashStep() for every byte.
+     *
+     * @param bytes
+     *            The identifier.
+     * @return The hash.
+     */
+    static uint64_t hash(string_view bytes);
+
+    /**
+     * @brief hashSeed represents the hash of the empty identifier
+     */
+    static const uint64_t hashSeed = 0xcbf29ce484222325ull;
+
+    /**
+     * Extend a hash with one more byte.
+     *
+     * @param hash
+     *            The hash of the bytes read so far.
+     * @param letter
+     *            The next byte.
+     * @return The hash including the new byte.
+     */
+    static uint64_t hashStep(uint64_t hash, unsigned char letter) { return (hash ^ letter) * 0x100000001b3ull; }
+
+    /**
+     * Return the ID of an identifier, adding it to the table the first time.
+     *
+     * @param bytes
+     *            The identifier.
+     * @param bytesHash
+     *            hash(bytes), computed by the caller.
+     * @return The ID of the identifier.
+     */
+    uint32_t intern(string_view bytes, uint64_t bytesHash);
+
+    /**
+     * Return the ID of an identifier, adding it to the table the first time.
+     *
+     * @param bytes
+     *            The identifier.
+     * @return The ID of the identifier.
+     */
+    uint32_t intern(string_view bytes) { return intern(bytes, hash(bytes)); }
+
+    /**
+     * Look an identifier up without adding it.
+     *
+     * @param bytes
+     *            The identifier.
+     * @return The ID of the identifier, or noId.
+     */
+    uint32_t find(string_view bytes) const;
+
+    /**
+     * Bytes of an interned identifier.
+     *
+     * @param id
+     *            An ID returned by intern().
+     * @return A view into the arena of the table.
+     */
+    string_view name(uint32_t id) const { return names[id]; }
+
+    /**
+     * Number of distinct identifiers.
+     *
+     * @return The number of IDs handed out.
+     */
+    uint32_t size() const { return (uint32_t) names.size(); }
+
+    /**
+     * Bytes allocated by the arena.
+     *
+     * @return The total size of the arena blocks.
+     */
+    size_t arenaBytes() const { return arenaAllocated; }
+
+private:
+    /**
+     * @brief blockSize represents the size of an arena block
+     */
+    static const size_t blockSize = 64 * 1024;
+
+    /**
+     * A slot of the open-addressing table; id == noId marks an empty slot.
+     */
+    struct Slot {
+        uint64_t hash;
+        uint32_t id;
+    };
+
+    const char *store(string_view bytes);
+    void grow();
+
+    vector<Slot> slots;
+    vector<string_view> names;
+    vector<unique_ptr<char[]>> blocks;
+    char *blockCursor;
+    size_t blockLeft;
+    size_t arenaAllocated;
+};
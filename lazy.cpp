@@ -0,0 +1,137 @@
+#include <algorithm>
+#include "lazy.h"
+
+using namespace std;
+
+namespace {
+
+bool isEmpty(const NFA::StateSet &states) {
+    return all_of(states.begin(), states.end(), [](uint64_t word) { return word == 0; });
+}
+
+}
+
+/**
+ * Hash of a set of states (64-bit mix of its words).
+ */
+size_t LazyDFA::SetHash::operator()(const NFA::StateSet &states) const {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL;
+    for(uint64_t word : states) {
+        hash ^= word + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    }
+    return (size_t) hash;
+}
+
+/**
+ * Construct a lazy DFA with an empty cache.
+ *
+ * @param nfa
+ *            A finalized NFA.
+ * @param options
+ *            Tuning of the cache and of the fallback.
+ */
+LazyDFA::LazyDFA(const NFA &nfa, Options options) : nfa(nfa), options(options) {
+    //A cached state costs its row of transitions, its set (stored twice, in sets and as
+    //the key of index) and roughly the overhead of a hash map node
+    bytesPerState = nfa.classCount() * sizeof(int) + 2 * nfa.setWords() * sizeof(uint64_t) + 64;
+}
+
+/**
+ * Find a set of states in the cache, or add it. The cache is judged by the
+ * bytes read per state built since the last flush (cachedBytes against
+ * sets.size()), so both only grow here and in run(), and restart in flush().
+ *
+ * @return The number of the cached state, or unknown if the cache is full.
+ */
+int LazyDFA::addState(const NFA::StateSet &states) {
+    auto found = index.find(states);
+    if(found != index.end()) return found->second;
+    if((sets.size() + 1) * bytesPerState > options.cacheBytes) return unknown;
+    int state = (int) sets.size();
+    sets.push_back(states);
+    accepting.push_back(nfa.isAccepting(states));
+    transitions.resize(transitions.size() + nfa.classCount(), unknown);
+    index.insert(pair<NFA::StateSet, int>(states, state));
+    if(isEmpty(states)) deadState = state;
+    counters.statesBuilt++;
+    return state;
+}
+
+/**
+ * Drop every cached state and transition.
+ */
+void LazyDFA::flush() {
+    sets.clear();
+    accepting.clear();
+    transitions.clear();
+    index.clear();
+    deadState = unknown;
+    //The efficiency of the cache is measured again from the next state built
+    cachedBytes = 0;
+    counters.cacheFlushes++;
+}
+
+/**
+ * Run the automaton on the input. The current state is a cached DFA state
+ * (state >= 0) or, during a fallback, a set of NFA states (current); the
+ * run stops as soon as no NFA state is active.
+ *
+ * @param inputWord
+ *            stream that contains the input word
+ * @return True, if the word is accepted by this automaton
+ */
+bool LazyDFA::run(const string &inputWord) {
+    const vector<unsigned char> &classMap = nfa.byteClasses();
+    int classes = nfa.classCount();
+    size_t length = inputWord.length(), fallbackEnd = 0;
+    NFA::StateSet current = nfa.startSet(), next;
+    int state = addState(current);
+    if(state == unknown) {
+        flush();
+        state = addState(current);
+    }
+    for(size_t i = 0; i < length; i++) {
+        unsigned char letter = inputWord[i];
+        if(state == unknown) {
+            nfa.step(current, letter, next);
+            current.swap(next);
+            counters.nfaBytes++;
+            if(isEmpty(current)) return false;
+            if(i + 1 == fallbackEnd) {
+                //The cache was flushed when the fallback started, so there is room for a state
+                //unless the budget can't hold even one: then the NFA goes on for another round
+                state = addState(current);
+                if(state == unknown) fallbackEnd = i + 1 + options.fallbackBytes;
+            }
+            continue;
+        }
+        int target = transitions[(size_t) state * classes + classMap[letter]];
+        if(target == unknown) {
+            nfa.step(sets[state], letter, next);
+            target = addState(next);
+            if(target != unknown) {
+                //addState may have moved the transitions, so the slot is looked up again
+                transitions[(size_t) state * classes + classMap[letter]] = target;
+            } else {
+                bool thrashing = cachedBytes < options.minBytesPerState * sets.size();
+                flush();
+                target = thrashing ? unknown : addState(next);
+                if(target == unknown) {
+                    current.swap(next);
+                    fallbackEnd = i + 1 + options.fallbackBytes;
+                    counters.fallbacks++;
+                }
+            }
+        }
+        state = target;
+        if(state == unknown) {
+            counters.nfaBytes++;
+            if(isEmpty(current)) return false;
+            continue;
+        }
+        counters.dfaBytes++;
+        cachedBytes++;
+        if(state == deadState) return false;
+    }
+    return state == unknown ? nfa.isAccepting(current) : (bool) accepting[state];
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include<cstdint>
+#include<string>
+#include<unordered_map>
+#include<vector>
+#include "nfa.h"
+
+using namespace std;
+
+/**
+ * Lazy DFA of an NFA: the subset construction is done while the input is
+ * read, and only the states and transitions that the input actually visits
+ * are built and cached. The cache has a memory budget; when it is full it is
+ * flushed and rebuilt from the current state.
+ *
+ * Some inputs make the cache thrash (e.g. (a|b)*a(a|b){20} on random a/b
+ * text, which visits a new state at almost every byte). When, at a flush,
+ * the cache has produced fewer than minBytesPerState bytes per state built,
+ * the engine falls back to the bit-parallel simulation of the NFA for the
+ * next fallbackBytes bytes, then switches back to the DFA. Either way the
+ * run takes linear time and bounded memory.
+ *
+ * A LazyDFA refers to its NFA, which must outlive it; the cache makes run()
+ * non-const, so an instance must not be shared by concurrent threads.
+ */
+class LazyDFA {
+public:
+    /**
+     * Tuning of the cache and of the fallback.
+     */
+    struct Options {
+        /**
+         * @brief cacheBytes represents the memory budget of the cached states and transitions
+         */
+        size_t cacheBytes = 1 << 20;
+        /**
+         * @brief minBytesPerState represents the cache efficiency below which a flush triggers the fallback
+         */
+        double minBytesPerState = 10;
+        /**
+         * @brief fallbackBytes represents the number of bytes simulated on the NFA before the DFA is tried again
+         */
+        size_t fallbackBytes = 1 << 16;
+    };
+
+    /**
+     * Counters of the engine, accumulated over every run.
+     */
+    struct Stats {
+        uint64_t statesBuilt = 0;
+        uint64_t cacheFlushes = 0;
+        uint64_t fallbacks = 0;
+        uint64_t dfaBytes = 0;
+        uint64_t nfaBytes = 0;
+    };
+
+    /**
+     * Construct a lazy DFA with an empty cache.
+     *
+     * @param nfa
+     *            A finalized NFA.
+     * @param options
+     *            Tuning of the cache and of the fallback.
+     */
+    LazyDFA(const NFA &nfa, Options options);
+    LazyDFA(const NFA &nfa) : LazyDFA(nfa, Options()) {}
+
+    /**
+     * Run the automaton on the input.
+     *
+     * @param inputWord
+     *            stream that contains the input word
+     * @return True, if the word is accepted by this automaton
+     */
+    bool run(const string &inputWord);
+
+    /**
+     * Counters accumulated over every run.
+     *
+     * @return The statistics of the engine.
+     */
+    const Stats &stats() const { return counters; }
+
+    /**
+     * Number of states currently in the cache.
+     *
+     * @return The number of cached states.
+     */
+    size_t cachedStates() const { return sets.size(); }
+
+private:
+    struct SetHash {
+        size_t operator()(const NFA::StateSet &states) const;
+    };
+
+    static constexpr int unknown = -1;
+
+    const NFA &nfa;
+    Options options;
+    Stats counters;
+    size_t bytesPerState;
+    int deadState = unknown;
+    /**
+     * @brief cachedBytes represents the bytes read through cached transitions since the last flush, over every run
+     */
+    uint64_t cachedBytes = 0;
+    vector<NFA::StateSet> sets;
+    vector<unsigned char> accepting;
+    vector<int> transitions;
+    unordered_map<NFA::StateSet, int, SetHash> index;
+
+    int addState(const NFA::StateSet &states);
+    void flush();
+};
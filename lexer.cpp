@@ -0,0 +1,170 @@
+#include "embedded.h"
+#include "lexer.h"
+
+using namespace std;
+
+namespace {
+
+const vector<string> languageKeywords = {
+    "begin", "do", "else", "end", "for", "function", "if", "procedure",
+    "program", "repeat", "then", "to", "until", "var", "while"
+};
+
+bool isSpace(unsigned char letter) {
+    return letter == ' ' || letter == '\t' || letter == '\n' || letter == '\r' || letter == '\f' || letter == '\v';
+}
+
+bool isDigit(unsigned char letter) { return letter >= '0' && letter <= '9'; }
+
+}
+
+/**
+ * Construct a lexer for the keywords of the language.
+ *
+ * @param table
+ *            The table in which identifiers are interned.
+ */
+Lexer::Lexer(InternTable &table) : identifierDFA(*findEmbeddedDFA("identifier-utf8")), commentDFA(*findEmbeddedDFA("comment")),
+                                   keywords(languageKeywords), identifiers(table) {}
+
+/**
+ * Length of the longest prefix of input[start..] accepted by the automaton.
+ *
+ * @param unterminated
+ *            Set to true if the automaton reached the end of the input without trapping or accepting.
+ * @return The length, or 0 if no non-empty prefix is accepted.
+ */
+size_t Lexer::longestMatch(const DFATable &dfa, string_view input, size_t start, bool &unterminated) const {
+    int state = dfa.startState;
+    size_t match = 0;
+    for(size_t i = start; i < input.length(); i++) {
+        state = dfa.step(state, input[i]);
+        if(state == dfa.trapState) return match;
+        if(dfa.isAccepting(state)) match = i + 1 - start;
+    }
+    unterminated = match == 0;
+    return match;
+}
+
+/**
+ * Split the input into tokens.
+ *
+ * @param input
+ *            The source text.
+ * @param tokens
+ *            Receives the tokens, in order.
+ * @return False, if the input is longer than maxInputLength.
+ */
+bool Lexer::tokenize(string_view input, vector<Token> &tokens) {
+    tokens.clear();
+    if(input.length() > maxInputLength) return false;
+    //A comment opener that runs to the end of the input unterminated means that no comment
+    //starting with the same byte further on can be closed either (it would have closed the first
+    //one), so the comment automaton is not run again from that byte: this keeps an input full of
+    //unclosed "{" linear
+    bool unterminated[256] = {false};
+    size_t i = 0;
+    while(i < input.length()) {
+        unsigned char letter = input[i];
+        if(isSpace(letter)) {
+            i++;
+            continue;
+        }
+        //Comments come first, because "(" and "/" are also punctuation
+        size_t length = unterminated[letter] ? 0 : longestMatch(commentDFA, input, i, unterminated[letter]);
+        if(length > 0) {
+            tokens.push_back(Token{TokenKind::Comment, (uint32_t) i, (uint32_t) length, 0});
+            i += length;
+            continue;
+        }
+        //The identifier automaton and the hash of the identifier advance together; the hash
+        //is saved every time the automaton accepts, since a UTF-8 letter spans several bytes
+        int state = identifierDFA.startState;
+        uint64_t hash = InternTable::hashSeed, matchHash = 0;
+        size_t end = i, matchEnd = i;
+        while(end < input.length()) {
+            state = identifierDFA.step(state, input[end]);
+            if(state == identifierDFA.trapState) break;
+            hash = InternTable::hashStep(hash, input[end]);
+            end++;
+            if(identifierDFA.isAccepting(state)) {
+                matchEnd = end;
+                matchHash = hash;
+            }
+        }
+        if(matchEnd > i) {
+            string_view text = input.substr(i, matchEnd - i);
+            int64_t keywordId = keywords.rank(text);
+            if(keywordId != DictionaryDFA::notFound) {
+                tokens.push_back(Token{TokenKind::Keyword, (uint32_t) i, (uint32_t)(matchEnd - i), (uint32_t) keywordId});
+            } else {
+                tokens.push_back(Token{TokenKind::Identifier, (uint32_t) i, (uint32_t)(matchEnd - i), identifiers.intern(text, matchHash)});
+            }
+            i = matchEnd;
+            continue;
+        }
+        if(isDigit(letter)) {
+            size_t end = i + 1;
+            while(end < input.length() && isDigit(input[end])) end++;
+            tokens.push_back(Token{TokenKind::Number, (uint32_t) i, (uint32_t)(end - i), 0});
+            i = end;
+            continue;
+        }
+        TokenKind kind = letter < 0x80 ? TokenKind::Punctuation : TokenKind::Unknown;
+        tokens.push_back(Token{kind, (uint32_t) i, 1, letter});
+        i++;
+    }
+    return true;
+}
+
+/**
+ * Symbol of a token for the token-level automata.
+ *
+ * @param token
+ *            A token produced by the Lexer.
+ * @return The symbol of the token.
+ */
+uint16_t tokenSymbol(const Token &token) {
+    switch(token.kind) {
+        case TokenKind::Punctuation:
+            return (uint16_t) token.id;
+        case TokenKind::Keyword:
+            return (uint16_t)(keywordSymbolBase + token.id);
+        default:
+            return (uint16_t)(kindSymbolBase + (uint16_t) token.kind);
+    }
+}
+
+/**
+ * Symbols of a sequence of tokens.
+ *
+ * @param tokens
+ *            Tokens produced by the Lexer.
+ * @return The symbol of every token, in order.
+ */
+vector<uint16_t> tokenSymbols(const vector<Token> &tokens) {
+    vector<uint16_t> symbols;
+    symbols.reserve(tokens.size());
+    for(const Token &token : tokens) symbols.push_back(tokenSymbol(token));
+    return symbols;
+}
+
+/**
+ * Construct a new DFA that recognizes the token streams in which the keyword
+ * repeat is followed, sooner or later, by the keyword until.
+ *
+ * @param lexer
+ *            The lexer that produces the tokens, which defines the keyword IDs.
+ */
+RepeatUntilDFA::RepeatUntilDFA(const Lexer &lexer) : TokenDFA(3) {
+    //State 0 waits for repeat, state 1 for until, state 2 (final) accepts whatever follows;
+    //every other token keeps the automaton where it is
+    uint16_t repeatSymbol = (uint16_t)(keywordSymbolBase + lexer.keywordId("repeat"));
+    uint16_t untilSymbol = (uint16_t)(keywordSymbolBase + lexer.keywordId("until"));
+    transitionF.insert(pair<pair<int, uint16_t>, int>(pair<int, uint16_t>(0, repeatSymbol), 1));
+    defaultF.insert(pair<int, int>(0, 0));
+    transitionF.insert(pair<pair<int, uint16_t>, int>(pair<int, uint16_t>(1, untilSymbol), 2));
+    defaultF.insert(pair<int, int>(1, 1));
+    defaultF.insert(pair<int, int>(2, 2));
+    finalStates.push_back(2);
+}
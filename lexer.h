@@ -0,0 +1,154 @@
+#pragma once
+
+#include<cstdint>
+#include<string>
+#include<string_view>
+#include<vector>
+#include "automata.h"
+#include "compiled.h"
+#include "dictionary.h"
+#include "intern.h"
+
+using namespace std;
+
+/**
+ * Kinds of the tokens produced by the Lexer.
+ */
+enum class TokenKind : uint16_t {
+    Identifier,
+    Keyword,
+    Number,
+    Comment,
+    Punctuation,
+    Unknown
+};
+
+/**
+ * A token of the input. The text is not copied: the token refers to its
+ * position in the input, and identifiers and keywords carry a dense ID.
+ */
+struct Token {
+    /**
+     * @brief kind represents the class of the token
+     */
+    TokenKind kind;
+    /**
+     * @brief offset represents the position of the first byte of the token in the input
+     */
+    uint32_t offset;
+    /**
+     * @brief length represents the number of bytes of the token
+     */
+    uint32_t length;
+    /**
+     * @brief id represents the interned ID of an identifier, the keyword ID of a keyword,
+     * the byte of a punctuation token, and 0 otherwise
+     */
+    uint32_t id;
+};
+
+/**
+ * Splits a source text into tokens with the compiled identifier and comment
+ * automata (longest match), skipping white space. Identifiers may contain
+ * UTF-8 encoded letters; bytes that are not valid UTF-8 become Unknown tokens. Keywords are recognized by a
+ * DictionaryDFA, whose ranks are the keyword IDs, and every other identifier is
+ * interned in an InternTable while it is scanned: its hash is computed during
+ * the same pass over the bytes that runs the identifier automaton.
+ */
+class Lexer {
+    DFATable identifierDFA;
+    DFATable commentDFA;
+    DictionaryDFA keywords;
+    InternTable &identifiers;
+
+    size_t longestMatch(const DFATable &dfa, string_view input, size_t start, bool &unterminated) const;
+public:
+    /**
+     * @brief maxInputLength represents the length of the longest input, whose offsets fit in a Token
+     */
+    static const uint64_t maxInputLength = UINT32_MAX;
+
+    /**
+     * Construct a lexer for the keywords of the language recognized by the
+     * automata of this project (program, begin, repeat, until, ...).
+     *
+     * @param table
+     *            The table in which identifiers are interned.
+     */
+    Lexer(InternTable &table);
+
+    /**
+     * Split the input into tokens.
+     *
+     * @param input
+     *            The source text.
+     * @param tokens
+     *            Receives the tokens, in order.
+     * @return False, if the input is longer than maxInputLength.
+     */
+    bool tokenize(string_view input, vector<Token> &tokens);
+
+    /**
+     * The keyword with a given ID.
+     *
+     * @param id
+     *            The id of a Keyword token.
+     * @return The keyword.
+     */
+    string keyword(uint32_t id) const { return keywords.word(id); }
+
+    /**
+     * ID of a keyword.
+     *
+     * @param word
+     *            A keyword of the language.
+     * @return The ID of the keyword, or DictionaryDFA::notFound.
+     */
+    int64_t keywordId(const string &word) const { return keywords.rank(word); }
+};
+
+/**
+ * @brief keywordSymbolBase represents the symbol of the keyword with ID 0 in a token stream
+ */
+const uint16_t keywordSymbolBase = 0x100;
+/**
+ * @brief kindSymbolBase represents the symbol of the first TokenKind in a token stream
+ */
+const uint16_t kindSymbolBase = 0x8000;
+
+/**
+ * Symbol of a token for the token-level automata (TokenDFA): a punctuation
+ * token is its byte, a keyword is keywordSymbolBase + its ID, and every other
+ * token is kindSymbolBase + its kind.
+ *
+ * @param token
+ *            A token produced by the Lexer.
+ * @return The symbol of the token.
+ */
+uint16_t tokenSymbol(const Token &token);
+
+/**
+ * Symbols of a sequence of tokens.
+ *
+ * @param tokens
+ *            Tokens produced by the Lexer.
+ * @return The symbol of every token, in order.
+ */
+vector<uint16_t> tokenSymbols(const vector<Token> &tokens);
+
+/**
+ * Token-level DFA recognizing the token streams that contain a repeat ... until
+ * structure, without scanning the bytes again.
+ */
+class RepeatUntilDFA : public TokenDFA {
+
+public:
+	/**
+	 * Construct a new DFA that recognizes the token streams in which the
+	 * keyword repeat is followed, sooner or later, by the keyword until.
+	 *
+	 * @param lexer
+	 *            The lexer that produces the tokens, which defines the keyword IDs.
+	 */
+	RepeatUntilDFA(const Lexer &lexer);
+};
@@ -1,35 +1,501 @@
+#include <chrono>
+#include <climits>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include "automata.h"
+#include "bounded.h"
+#include "embedded.h"
+#include "equivalence.h"
+#include "histogram.h"
+#include "lazy.h"
+#include "lexer.h"
+#include "metrics.h"
+#include "minimize.h"
+#include "options.h"
+#include "replicated.h"
+#include "results.h"
+#include "subset.h"
+#include "trace.h"
+#include "workers.h"
 
 using namespace std;
 
-int main(int argc, char* argv[]) {
-      if(argc != 2) {
-        cout << "Usage: main filename" << endl;
-        return 1;
+namespace {
+
+// latency of a whole file (open, read, scan with every automaton, output)
+LatencyHistogram fileLatency("file");
+// latency of a single run of an automaton on a file
+LatencyHistogram scanLatency("scan");
+
+Counter &filesScanned = Metrics::counter("automata_files_scanned_total", "Files read and scanned.");
+Counter &fileErrors = Metrics::counter("automata_file_errors_total", "Files that could not be read.");
+Counter &bytesScanned = Metrics::counter("automata_bytes_scanned_total", "Input bytes fed to the automata.");
+Counter &workerCrashes = Metrics::counter("automata_worker_crashes_total", "Worker processes that died while scanning.");
+Counter &lazyStatesBuilt = Metrics::counter("automata_lazy_dfa_states_built_total", "States built by the lazy DFAs.");
+Counter &lazyCacheFlushes = Metrics::counter("automata_lazy_dfa_cache_flushes_total", "Lazy DFA caches flushed because they were full.");
+Counter &lazyFallbacks = Metrics::counter("automata_lazy_dfa_fallbacks_total", "Switches from a thrashing lazy DFA to the NFA simulation.");
+Counter &lazyDfaBytes = Metrics::counter("automata_lazy_dfa_bytes_total", "Bytes read by the lazy DFAs, by engine.", "engine=\"dfa\"");
+Counter &lazyNfaBytes = Metrics::counter("automata_lazy_dfa_bytes_total", "Bytes read by the lazy DFAs, by engine.", "engine=\"nfa\"");
+
+/**
+ * An automaton run on every file, with its label and the counter of its runs
+ * looked up once, so a run doesn't go through the registry lock.
+ */
+struct ScannedAutomaton {
+    string label;
+    Counter &runs;
+
+    /**
+     * @param engine
+     *            "table" or "lazy", the engine the automaton runs on.
+     */
+    ScannedAutomaton(const string &automatonLabel, const string &engine)
+        : label(automatonLabel),
+          runs(Metrics::counter("automata_engine_selections_total", "Runs of an automaton, by automaton and engine.",
+                                "automaton=\"" + label + "\",engine=\"" + engine + "\"")) {}
+};
+
+// identifiers get the same ID in every file of a batch
+InternTable identifiers;
+bool printTokens = false;
+// name of the embedded automaton used for the COMMENT verdict
+string commentAutomaton = "comment";
+// longest comment text recognized, if any
+uint32_t maxCommentLength = BoundedDFA::unbounded;
+// patterns given with --pattern, and their lazy DFAs (built in main, they refer to the NFAs)
+vector<string> patterns;
+vector<NFA> patternNFAs;
+vector<LazyDFA> patternDFAs;
+LazyDFA::Options lazyOptions;
+// with --compile-patterns, the patterns whose DFA is small enough are determinized up front
+bool compilePatterns = false;
+vector<unique_ptr<CompiledDFA>> patternTables;
+// with --numa-replicate, the compiled patterns are copied on every NUMA node
+bool replicateTables = false;
+vector<unique_ptr<ReplicatedDFA>> patternReplicas;
+// the label and the counters of every automaton
+ScannedAutomaton repeatScan("REPEAT", "table");
+ScannedAutomaton commentScan("COMMENT", "table");
+// with --max-comment-length, the COMMENT verdict comes from the bounded automaton instead
+ScannedAutomaton boundedCommentScan("COMMENT", "bounded");
+vector<ScannedAutomaton> patternScans;
+// with --results, every verdict is also written as a row of a columnar result file, through a block of this process
+ResultWriter resultWriter;
+ResultBlock resultBlock;
+// a worker keeps the full blocks of a file for its report instead of writing them: the parent writes them when the
+// file is delivered, so the rows of a file scanned again after a crash are written once
+bool spoolResults = false;
+string spooledResults;
+
+/**
+ * Nanoseconds elapsed since the given instant.
+ */
+uint64_t elapsedNanos(chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Write the rows of the result block, or keep them for the report of the
+ * file in a worker.
+ */
+void flushResults() {
+    if(!spoolResults) {
+        resultWriter.write(resultBlock);
+        return;
     }
+    spooledResults += resultBlock.encode();
+    resultBlock.clear();
+}
+
+/**
+ * Add a verdict to the result file, if there is one.
+ *
+ * @param fileId
+ *            Position of the input file on the command line, from 0.
+ * @param patternId
+ *            0 for REPEAT, 1 for COMMENT, 1 + i for PATTERN i.
+ * @param ends
+ *            The end offsets of the matches, empty if the automaton has no table to find them.
+ */
+void recordResult(size_t fileId, uint32_t patternId, bool verdict, const vector<uint64_t> &ends) {
+    if(!resultWriter.isOpen()) return;
+    resultBlock.add(fileId, patternId, verdict, ends);
+    if(resultBlock.full()) flushResults();
+}
 
+/**
+ * Run an automaton on the input, recording the scan latency. With a result
+ * file, the same pass also collects the end offsets of the matches.
+ */
+bool timedRun(const DFATable &dfa, const string &input, ScannedAutomaton &automaton, vector<uint64_t> &ends) {
+    TraceSpan span("scan ", automaton.label, "scan");
+    automaton.runs.add();
+    bytesScanned.add(input.length());
+    auto start = chrono::steady_clock::now();
+    ends.clear();
+    bool result = resultWriter.isOpen() ? dfa.acceptedPrefixes(input, ends) : dfa.run(input);
+    scanLatency.record(elapsedNanos(start));
+    return result;
+}
+
+/**
+ * Run a bounded DFA on the input, recording the scan latency.
+ */
+bool timedRun(const BoundedDFA &dfa, const string &input, ScannedAutomaton &automaton) {
+    TraceSpan span("scan ", automaton.label, "scan");
+    automaton.runs.add();
+    bytesScanned.add(input.length());
+    auto start = chrono::steady_clock::now();
+    bool result = dfa.run(input);
+    scanLatency.record(elapsedNanos(start));
+    return result;
+}
+
+/**
+ * Run a lazy DFA on the input, recording the scan latency and publishing the
+ * counters of its cache and of its NFA fallback.
+ */
+bool timedRun(LazyDFA &dfa, const string &input, ScannedAutomaton &automaton) {
+    TraceSpan span("scan ", automaton.label, "scan");
+    automaton.runs.add();
+    LazyDFA::Stats before = dfa.stats();
+    bytesScanned.add(input.length());
+    auto start = chrono::steady_clock::now();
+    bool result = dfa.run(input);
+    scanLatency.record(elapsedNanos(start));
+    const LazyDFA::Stats &after = dfa.stats();
+    lazyStatesBuilt.add(after.statesBuilt - before.statesBuilt);
+    lazyCacheFlushes.add(after.cacheFlushes - before.cacheFlushes);
+    lazyFallbacks.add(after.fallbacks - before.fallbacks);
+    lazyDfaBytes.add(after.dfaBytes - before.dfaBytes);
+    lazyNfaBytes.add(after.nfaBytes - before.nfaBytes);
+    return result;
+}
+
+/**
+ * Read a file and print whether it is recognized by every automaton.
+ *
+ * @param fileName
+ *            Path of the input file.
+ * @param fileId
+ *            Position of the file on the command line, for the result file.
+ * @param out
+ *            Stream that receives the verdicts.
+ * @return True, if the file could be read.
+ */
+bool scanFile(const char *fileName, size_t fileId, ostream &out) {
+    auto start = chrono::steady_clock::now();
     // open input file
-    ifstream inputFile(argv[1]);
+    ifstream inputFile;
+    {
+        TraceSpan span("open ", fileName, "io");
+        inputFile.open(fileName);
+    }
     if(inputFile.fail()){
         // file open error
-        cout << "Error while reading file " << argv[1] << endl;
-        return 1;
-    }    
+        out << "Error while reading file " << fileName << endl;
+        fileErrors.add();
+        return false;
+    }
     // read file into a string
-    string inputProgram((istreambuf_iterator<char>(inputFile)),
-                        (istreambuf_iterator<char>()));
-	cout << "Input: " << inputProgram << endl;
+    string inputProgram;
+    {
+        TraceSpan span("read ", fileName, "io");
+        inputProgram.assign((istreambuf_iterator<char>(inputFile)),
+                            (istreambuf_iterator<char>()));
+    }
+    {
+        TraceSpan span("output input", "output");
+        out << "Input: " << inputProgram << endl;
+    }
     // close input file
     inputFile.close();
     // Try to recognize with automaton for "repeat"
-	WordDFA repeatDFA("repeat");
-	cout << "REPEAT: " << repeatDFA.run(inputProgram) << endl;
-	// Try to recognize with automaton for comments
-	CommentDFA commentDFA; 
-	cout << "COMMENT: " << commentDFA.run(inputProgram) << endl;
+    vector<uint64_t> ends;
+    bool repeatResult = timedRun(*findEmbeddedDFA("repeat"), inputProgram, repeatScan, ends);
+    recordResult(fileId, 0, repeatResult, ends);
+    {
+        TraceSpan span("output REPEAT", "output");
+        out << "REPEAT: " << repeatResult << endl;
+    }
+    // Try to recognize with automaton for comments
+    bool commentResult;
+    if(maxCommentLength == BoundedDFA::unbounded) {
+        commentResult = timedRun(*findEmbeddedDFA(commentAutomaton), inputProgram, commentScan, ends);
+    } else {
+        static BoundedDFA boundedCommentDFA(*findEmbeddedDFA(commentAutomaton),
+                                            {CommentDFA::lineBodyState, CommentDFA::braceBodyState, CommentDFA::parenBodyState},
+                                            0, maxCommentLength);
+        // the bounded automaton has no table to find the matches with, its row only has the verdict
+        commentResult = timedRun(boundedCommentDFA, inputProgram, boundedCommentScan);
+        ends.clear();
+    }
+    recordResult(fileId, 1, commentResult, ends);
+    {
+        TraceSpan span("output COMMENT", "output");
+        out << "COMMENT: " << commentResult << endl;
+    }
+    for(size_t i = 0; i < patternDFAs.size(); i++) {
+        bool patternResult;
+        if(patternReplicas[i]) {
+            patternResult = timedRun(patternReplicas[i]->local(), inputProgram, patternScans[i], ends);
+        } else if(patternTables[i]) {
+            patternResult = timedRun(patternTables[i]->table(), inputProgram, patternScans[i], ends);
+        } else {
+            // a lazy pattern has no table to find its matches with, its row only has the verdict
+            patternResult = timedRun(patternDFAs[i], inputProgram, patternScans[i]);
+            ends.clear();
+        }
+        recordResult(fileId, (uint32_t) (i + 2), patternResult, ends);
+        TraceSpan span("output PATTERN", "output");
+        out << "PATTERN " << i + 1 << ": " << patternResult << endl;
+    }
+    if(printTokens) {
+        static Lexer lexer(identifiers);
+        static RepeatUntilDFA repeatUntilDFA(lexer);
+        vector<Token> tokens;
+        bool tokenized;
+        {
+            TraceSpan span("lex", "scan");
+            tokenized = lexer.tokenize(inputProgram, tokens);
+        }
+        if(!tokenized) {
+            out << "File " << fileName << " is too large to be tokenized" << endl;
+            return false;
+        }
+        out << "TOKENS: " << tokens.size() << " (distinct identifiers so far: " << identifiers.size() << ")" << endl;
+        // Try to recognize a repeat ... until structure on the tokens instead of the bytes
+        TraceSpan span("scan REPEAT-UNTIL", "scan");
+        out << "REPEAT-UNTIL: " << repeatUntilDFA.run(tokenSymbols(tokens)) << endl;
+    }
+    fileLatency.record(elapsedNanos(start));
+    filesScanned.add();
+    return true;
+}
+
+/**
+ * Write the report of a file scanned by a worker: what its counters and its
+ * latency histograms recorded since the baselines, then its result rows.
+ *
+ * @param report
+ *            Stream that receives the report.
+ */
+void writeReport(ostream &report, const Metrics::CounterValues &counters, const HistogramSnapshot &files,
+                 const HistogramSnapshot &scans) {
+    Metrics::writeCounterDeltas(report, counters);
+    HistogramSnapshot recorded = fileLatency.snapshot();
+    recorded.subtract(files);
+    recorded.write(report);
+    recorded = scanLatency.snapshot();
+    recorded.subtract(scans);
+    recorded.write(report);
+    flushResults();
+    report << spooledResults;
+    spooledResults.clear();
+}
+
+/**
+ * Add the report of a file scanned by a worker to the metrics and to the
+ * result file of this process.
+ *
+ * @param report
+ *            Report written by writeReport().
+ * @return False, if the report is malformed.
+ */
+bool applyReport(const string &report) {
+    istringstream in(report);
+    HistogramSnapshot files, scans;
+    if(!Metrics::addCounterDeltas(in) || !files.read(in) || !scans.read(in) || in.get() != '\n') return false;
+    fileLatency.add(files);
+    scanLatency.add(scans);
+    string rows = report.substr((size_t) in.tellg());
+    return rows.empty() || resultWriter.writeEncoded(rows);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    bool printStats = false;
+    string metricsFile;
+    int metricsInterval = 10;
+    unsigned workers = 0;
+    string resultsFile;
+    // parse the options that precede the file names
+    int argi = 1;
+    bool validOptions = true;
+    uint64_t number;
+    while(argi < argc && string(argv[argi]).rfind("--", 0) == 0) {
+        string option(argv[argi]);
+        if(option == "--trace" && argi + 1 < argc) {
+            // record the pipeline stages and write them as Chrome trace-event JSON at exit
+            Tracer::enable(argv[argi + 1]);
+            argi += 2;
+        } else if(option == "--stats") {
+            // print the latency percentiles after the last file
+            printStats = true;
+            argi++;
+        } else if(option == "--utf8") {
+            // comments must also be valid UTF-8 to be recognized
+            commentAutomaton = "comment-utf8";
+            argi++;
+        } else if(option == "--max-comment-length" && argi + 1 < argc) {
+            // comments whose text is longer than this are not recognized
+            validOptions = parseNumber(argv[argi + 1], 0, BoundedDFA::unbounded - 1, number);
+            maxCommentLength = (uint32_t) number;
+            argi += 2;
+        } else if(option == "--tokens") {
+            // split every file into tokens and report how many there are
+            printTokens = true;
+            argi++;
+        } else if(option == "--pattern" && argi + 1 < argc) {
+            // also check whether the whole file matches a pattern (may be repeated)
+            patterns.push_back(argv[argi + 1]);
+            argi += 2;
+        } else if(option == "--pattern-file" && argi + 1 < argc) {
+            // one pattern whose alternatives are the lines of a file (a rule set)
+            ifstream ruleFile(argv[argi + 1]);
+            string rule, alternatives;
+            while(getline(ruleFile, rule)) {
+                if(rule.empty()) continue;
+                alternatives += (alternatives.empty() ? "(" : "|(") + rule + ")";
+            }
+            if(ruleFile.bad() || alternatives.empty()) {
+                cout << "Error while reading file " << argv[argi + 1] << endl;
+                return 1;
+            }
+            patterns.push_back(alternatives);
+            argi += 2;
+        } else if(option == "--compile-patterns") {
+            // determinize and minimize the patterns in parallel before the first file instead of running them lazily
+            compilePatterns = true;
+            argi++;
+        } else if(option == "--numa-replicate") {
+            // give every NUMA node its own copy of the compiled patterns
+            replicateTables = true;
+            argi++;
+        } else if(option == "--cache-bytes" && argi + 1 < argc) {
+            // memory budget of the lazy DFA cache of every pattern
+            validOptions = parseNumber(argv[argi + 1], 1, SIZE_MAX, number);
+            lazyOptions.cacheBytes = (size_t) number;
+            argi += 2;
+        } else if(option == "--metrics-file" && argi + 1 < argc) {
+            // write Prometheus text metrics for node-exporter's textfile collector
+            metricsFile = argv[argi + 1];
+            argi += 2;
+        } else if(option == "--metrics-interval" && argi + 1 < argc) {
+            // seconds between two rewrites of the metrics file
+            // at least a second: the exporter doesn't wait between two writes otherwise
+            validOptions = parseNumber(argv[argi + 1], 1, INT_MAX, number);
+            metricsInterval = (int) number;
+            argi += 2;
+        } else if(option == "--results" && argi + 1 < argc) {
+            // also write the verdicts and the match offsets as a columnar binary file
+            resultsFile = argv[argi + 1];
+            argi += 2;
+        } else if(option == "--workers" && argi + 1 < argc) {
+            // scan the files in this many worker processes, so that a crash only loses one file
+            validOptions = parseNumber(argv[argi + 1], 0, UINT_MAX, number);
+            workers = (unsigned) number;
+            argi += 2;
+        } else {
+            break;
+        }
+        if(!validOptions) break;
+    }
+    if(!validOptions || argi >= argc) {
+        cout << "Usage: main [--trace tracefile] [--stats] [--utf8] [--max-comment-length n] [--tokens] [--pattern regex]... [--pattern-file rulefile]... [--compile-patterns [--numa-replicate]] [--cache-bytes n] [--metrics-file promfile [--metrics-interval seconds]] [--workers n] [--results resultfile] filename..." << endl;
+        return 1;
+    }
+    Tracer::setThreadName("main");
+    // the NFAs are all built first: the lazy DFAs keep references to them
+    patternNFAs.resize(patterns.size());
+    for(size_t i = 0; i < patterns.size(); i++) {
+        string error;
+        if(!NFA::fromPattern(patterns[i], patternNFAs[i], &error)) {
+            cout << "Invalid pattern " << patterns[i] << ": " << error << endl;
+            return 1;
+        }
+    }
+    for(const NFA &nfa : patternNFAs) {
+        patternDFAs.emplace_back(nfa, lazyOptions);
+        unique_ptr<CompiledDFA> table;
+        if(compilePatterns) {
+            // a pattern with too many states stays lazy
+            TraceSpan span("determinize", "compile");
+            table = determinize(nfa);
+        }
+        if(table) {
+            TraceSpan span("minimize", "compile");
+            auto minimal = make_unique<CompiledDFA>(minimize(table->table()));
+            // the minimal table replaces the other one only if it provably accepts the same words
+            string counterexample;
+            if(equivalent(table->table(), minimal->table(), &counterexample)) {
+                table = move(minimal);
+            } else {
+                cout << "Minimization changed the language of a pattern, e.g. on \"" << counterexample << "\"" << endl;
+            }
+        }
+        patternScans.emplace_back("PATTERN " + to_string(patternScans.size() + 1), table ? "table" : "lazy");
+        patternReplicas.push_back(table && replicateTables ? make_unique<ReplicatedDFA>(table->table()) : nullptr);
+        if(patternReplicas.back() && patternReplicas.back()->unboundCount() > 0) {
+            cout << "Could not bind " << patternReplicas.back()->unboundCount() << " copies of pattern "
+                 << patternReplicas.size() << " to their NUMA node" << endl;
+        }
+        patternTables.push_back(move(table));
+    }
+    if(!metricsFile.empty()) {
+        Metrics::addHistogram("automata_file_latency_seconds", "Time spent on a whole input file.", fileLatency);
+        Metrics::addHistogram("automata_scan_latency_seconds", "Time spent running one automaton on a file.", scanLatency);
+        // a worker forked while the export thread holds the registry lock would deadlock, so with workers the
+        // file is only written at the end
+        if(workers == 0) Metrics::startPeriodicExport(metricsFile, metricsInterval);
+    }
+
+    if(!resultsFile.empty() && !resultWriter.open(resultsFile)) {
+        cout << "Error while writing file " << resultsFile << endl;
+        return 1;
+    }
 
-    return 0;
+    int status = 0;
+    if(workers == 0) {
+        for(int first = argi; argi < argc; argi++) {
+            if(!scanFile(argv[argi], (size_t) (argi - first), cout)) status = 1;
+        }
+    } else {
+        // the workers count and trace in their own copy of the process: the counters, the latencies and the result
+        // rows of every file come back in its report and are added here, the traces stay in the workers
+        char **fileNames = argv + argi;
+        spoolResults = true;
+        int crashes = runSharded((size_t) (argc - argi), workers,
+                                 [&](size_t shard, ostream &out, ostream &report) {
+                                     Metrics::CounterValues counters = Metrics::counterValues();
+                                     HistogramSnapshot files = fileLatency.snapshot(), scans = scanLatency.snapshot();
+                                     bool ok = scanFile(fileNames[shard], shard, out);
+                                     writeReport(report, counters, files, scans);
+                                     return ok;
+                                 },
+                                 [&](size_t shard, const string &output, const string &report, bool ok, bool crashed) {
+                                     cout << output;
+                                     if(crashed) cout << "Error while scanning file " << fileNames[shard] << " (worker crashed)" << endl;
+                                     if(!crashed && !applyReport(report)) {
+                                         cout << "Error while collecting the results of file " << fileNames[shard] << endl;
+                                         ok = false;
+                                     }
+                                     if(!ok || crashed) status = 1;
+                                 });
+        spoolResults = false;
+        workerCrashes.add((uint64_t) crashes);
+        if(!metricsFile.empty()) Metrics::writeTextfile(metricsFile);
+    }
+    resultWriter.write(resultBlock);
+    resultWriter.close();
+    Metrics::stopPeriodicExport();
+    if(printStats) {
+        printLatencySummary(cout, fileLatency);
+        printLatencySummary(cout, scanLatency);
+    }
+    return status;
 }
@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "metrics.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * All the series that share a name, with their HELP and TYPE lines.
+ */
+struct Family {
+    string help;
+    string type;
+    map<string, unique_ptr<Counter>> counters;
+    map<string, unique_ptr<Gauge>> gauges;
+    const LatencyHistogram *histogram = nullptr;
+};
+
+/**
+ * Registered families. It is created on first use, so metrics can be looked up
+ * from the initializers of globals in other translation units.
+ */
+struct Registry {
+    mutex lock;
+    map<string, Family> families;
+};
+
+Registry &registry() {
+    static Registry instance;
+    return instance;
+}
+
+mutex exportMutex;
+condition_variable exportWakeup;
+bool exportStopping = false;
+thread exportThread;
+string exportPath;
+
+Family &family(const string &name, const string &help, const string &type) {
+    Family &f = registry().families[name];
+    if(f.type.empty()){
+        f.help = help;
+        f.type = type;
+    }
+    return f;
+}
+
+/**
+ * Write a series line: name{labels} value.
+ */
+void writeSample(ostream &out, const string &name, const string &labels, double value) {
+    out << name;
+    if(!labels.empty()) out << '{' << labels << '}';
+    out << ' ' << value << '\n';
+}
+
+/**
+ * Refresh the gauges that describe the memory of the process.
+ */
+void collectProcessMemory() {
+    //The resident set size is the second field of /proc/self/statm, in pages
+    ifstream statm("/proc/self/statm");
+    long long sizePages = 0, residentPages = 0;
+    if(statm >> sizePages >> residentPages){
+        double pageSize = (double) sysconf(_SC_PAGESIZE);
+        Metrics::gauge("process_resident_memory_bytes", "Resident memory size in bytes.").set(residentPages * pageSize);
+        Metrics::gauge("process_virtual_memory_bytes", "Virtual memory size in bytes.").set(sizePages * pageSize);
+    }
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0){
+        Metrics::gauge("process_max_resident_memory_bytes", "Peak resident memory size in bytes.").set(usage.ru_maxrss * 1024.0);
+    }
+}
+
+}
+
+Counter::Counter() : value(0) {}
+
+Gauge::Gauge() : value(0) {}
+
+/**
+ * Return the counter with the given name and labels, creating it if needed.
+ *
+ * @param name
+ *            Prometheus family name.
+ * @param help
+ *            Description printed in the HELP line.
+ * @param labels
+ *            Label set without braces, or empty.
+ * @return The counter.
+ */
+Counter &Metrics::counter(const string &name, const string &help, const string &labels) {
+    lock_guard<mutex> lock(registry().lock);
+    unique_ptr<Counter> &c = family(name, help, "counter").counters[labels];
+    if(!c) c = make_unique<Counter>();
+    return *c;
+}
+
+/**
+ * Return the gauge with the given name and labels, creating it if needed.
+ *
+ * @param name
+ *            Prometheus family name.
+ * @param help
+ *            Description printed in the HELP line.
+ * @param labels
+ *            Label set without braces, or empty.
+ * @return The gauge.
+ */
+Gauge &Metrics::gauge(const string &name, const string &help, const string &labels) {
+    lock_guard<mutex> lock(registry().lock);
+    unique_ptr<Gauge> &g = family(name, help, "gauge").gauges[labels];
+    if(!g) g = make_unique<Gauge>();
+    return *g;
+}
+
+/**
+ * Export a latency histogram as a Prometheus summary in seconds.
+ *
+ * @param name
+ *            Prometheus family name.
+ * @param help
+ *            Description printed in the HELP line.
+ * @param histogram
+ *            The histogram; it must outlive the registry.
+ */
+void Metrics::addHistogram(const string &name, const string &help, const LatencyHistogram &histogram) {
+    lock_guard<mutex> lock(registry().lock);
+    family(name, help, "summary").histogram = &histogram;
+}
+
+/**
+ * Current value of every counter.
+ *
+ * @return The values, keyed by family name and label set.
+ */
+Metrics::CounterValues Metrics::counterValues() {
+    lock_guard<mutex> lock(registry().lock);
+    CounterValues values;
+    for(auto &entry : registry().families){
+        for(auto &c : entry.second.counters) values[{entry.first, c.first}] = c.second->get();
+    }
+    return values;
+}
+
+/**
+ * Write how much every counter grew since a baseline, one counter per line:
+ * name, labels, delta and help separated by tabs (which none of them
+ * contains). An empty line ends the list.
+ *
+ * @param out
+ *            Stream on which the deltas are written.
+ * @param baseline
+ *            Values returned by counterValues() earlier.
+ */
+void Metrics::writeCounterDeltas(ostream &out, const CounterValues &baseline) {
+    lock_guard<mutex> lock(registry().lock);
+    for(auto &entry : registry().families){
+        for(auto &c : entry.second.counters){
+            auto before = baseline.find({entry.first, c.first});
+            uint64_t delta = c.second->get() - (before == baseline.end() ? 0 : before->second);
+            if(delta != 0) out << entry.first << '\t' << c.first << '\t' << delta << '\t' << entry.second.help << '\n';
+        }
+    }
+    out << '\n';
+}
+
+/**
+ * Add deltas written by writeCounterDeltas() to the counters.
+ *
+ * @param in
+ *            Stream from which the deltas are read.
+ * @return False, if the deltas are malformed.
+ */
+bool Metrics::addCounterDeltas(istream &in) {
+    string line;
+    while(getline(in, line) && !line.empty()){
+        size_t labelsStart = line.find('\t'), deltaStart = line.find('\t', labelsStart + 1);
+        size_t helpStart = deltaStart == string::npos ? string::npos : line.find('\t', deltaStart + 1);
+        if(helpStart == string::npos) return false;
+        string delta = line.substr(deltaStart + 1, helpStart - deltaStart - 1);
+        if(delta.empty() || delta.find_first_not_of("0123456789") != string::npos) return false;
+        counter(line.substr(0, labelsStart), line.substr(helpStart + 1), line.substr(labelsStart + 1, deltaStart - labelsStart - 1))
+                .add(stoull(delta));
+    }
+    return !in.bad() && line.empty();
+}
+
+/**
+ * Write every metric in the Prometheus text exposition format.
+ *
+ * @param out
+ *            Stream on which the metrics are written.
+ */
+void Metrics::write(ostream &out) {
+    collectProcessMemory();
+    lock_guard<mutex> lock(registry().lock);
+    //Counters are written as plain integers up to 10^15
+    streamsize precision = out.precision(15);
+    for(auto &entry : registry().families){
+        const string &name = entry.first;
+        Family &f = entry.second;
+        out << "# HELP " << name << ' ' << f.help << '\n';
+        out << "# TYPE " << name << ' ' << f.type << '\n';
+        for(auto &c : f.counters) writeSample(out, name, c.first, (double) c.second->get());
+        for(auto &g : f.gauges) writeSample(out, name, g.first, g.second->get());
+        if(f.histogram != nullptr){
+            HistogramSnapshot merged = f.histogram->snapshot();
+            for(const char *quantile : {"0.5", "0.9", "0.99", "0.999"}){
+                writeSample(out, name, string("quantile=\"") + quantile + "\"", merged.percentile(stod(quantile)) / 1e9);
+            }
+            writeSample(out, name + "_sum", "", merged.sum / 1e9);
+            writeSample(out, name + "_count", "", (double) merged.totalCount);
+        }
+    }
+    out.precision(precision);
+}
+
+/**
+ * Write the metrics to a file for node-exporter's textfile collector, going
+ * through a temporary file and a rename.
+ *
+ * @param path
+ *            Destination file.
+ * @return True, if the file has been written.
+ */
+bool Metrics::writeTextfile(const string &path) {
+    string temporary = path + ".tmp";
+    {
+        ofstream out(temporary);
+        if(out.fail()) return false;
+        write(out);
+        if(out.fail()) return false;
+    }
+    return rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+/**
+ * Start a background thread that rewrites the textfile periodically.
+ *
+ * @param path
+ *            Destination file.
+ * @param intervalSeconds
+ *            Seconds between two writes.
+ */
+void Metrics::startPeriodicExport(const string &path, int intervalSeconds) {
+    lock_guard<mutex> lock(exportMutex);
+    if(exportThread.joinable()) return;
+    exportPath = path;
+    exportStopping = false;
+    //Without a wait between two writes the thread would spin
+    intervalSeconds = max(intervalSeconds, 1);
+    exportThread = thread([intervalSeconds]() {
+        unique_lock<mutex> lock(exportMutex);
+        //The last write follows the stop request, even if it came before the thread started
+        for(bool stopping = false; !stopping;){
+            stopping = exportWakeup.wait_for(lock, chrono::seconds(intervalSeconds), []() { return exportStopping; });
+            writeTextfile(exportPath);
+        }
+    });
+}
+
+/**
+ * Stop the periodic export and write the final values.
+ */
+void Metrics::stopPeriodicExport() {
+    {
+        lock_guard<mutex> lock(exportMutex);
+        if(!exportThread.joinable()) return;
+        exportStopping = true;
+    }
+    exportWakeup.notify_all();
+    exportThread.join();
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include<atomic>
+#include<cstdint>
+#include<iostream>
+#include<map>
+#include<string>
+#include "histogram.h"
+
+using namespace std;
+
+/**
+ * Monotonic counter, incremented with relaxed atomics.
+ */
+class Counter {
+    atomic<uint64_t> value;
+public:
+    Counter();
+
+    /**
+     * Increment the counter.
+     *
+     * @param amount
+     *            The value to add.
+     */
+    void add(uint64_t amount = 1) { value.fetch_add(amount, memory_order_relaxed); }
+
+    /**
+     * Current value of the counter.
+     *
+     * @return The sum of all the increments.
+     */
+    uint64_t get() const { return value.load(memory_order_relaxed); }
+};
+
+/**
+ * Value that can go up and down (queue depth, memory usage, ...).
+ */
+class Gauge {
+    atomic<double> value;
+public:
+    Gauge();
+
+    /**
+     * Set the current value of the gauge.
+     *
+     * @param newValue
+     *            The value to publish.
+     */
+    void set(double newValue) { value.store(newValue, memory_order_relaxed); }
+
+    /**
+     * Current value of the gauge.
+     *
+     * @return The last value that has been set.
+     */
+    double get() const { return value.load(memory_order_relaxed); }
+};
+
+/**
+ * Process-wide registry of metrics, exported in the Prometheus text exposition
+ * format. Metrics are looked up (and created the first time) by family name and
+ * label set; the returned references stay valid until the program exits, so hot
+ * paths should look a metric up once and keep the reference.
+ */
+class Metrics {
+public:
+    /**
+     * Return the counter with the given name and labels, creating it if needed.
+     *
+     * @param name
+     *            Prometheus family name (e.g. "automata_bytes_scanned_total").
+     * @param help
+     *            Description printed in the HELP line.
+     * @param labels
+     *            Label set without braces (e.g. "automaton=\"REPEAT\""), or empty.
+     * @return The counter.
+     */
+    static Counter &counter(const string &name, const string &help, const string &labels = "");
+
+    /**
+     * Return the gauge with the given name and labels, creating it if needed.
+     *
+     * @param name
+     *            Prometheus family name.
+     * @param help
+     *            Description printed in the HELP line.
+     * @param labels
+     *            Label set without braces, or empty.
+     * @return The gauge.
+     */
+    static Gauge &gauge(const string &name, const string &help, const string &labels = "");
+
+    /**
+     * Export a latency histogram (recorded in nanoseconds) as a Prometheus
+     * summary in seconds, with the 0.5, 0.9, 0.99 and 0.999 quantiles.
+     *
+     * @param name
+     *            Prometheus family name (e.g. "automata_file_latency_seconds").
+     * @param help
+     *            Description printed in the HELP line.
+     * @param histogram
+     *            The histogram; it must outlive the registry.
+     */
+    static void addHistogram(const string &name, const string &help, const LatencyHistogram &histogram);
+
+    /**
+     * @brief CounterValues represents the value of every counter, keyed by family name and label set
+     */
+    typedef map<pair<string, string>, uint64_t> CounterValues;
+
+    /**
+     * Current value of every counter.
+     *
+     * @return The values.
+     */
+    static CounterValues counterValues();
+
+    /**
+     * Write how much every counter grew since a baseline, so that another
+     * process (e.g. the parent of a worker) can add it to its own counters
+     * with addCounterDeltas(). Only the counters that grew are written, one
+     * per line, and an empty line ends the list.
+     *
+     * @param out
+     *            Stream on which the deltas are written.
+     * @param baseline
+     *            Values returned by counterValues() earlier.
+     */
+    static void writeCounterDeltas(ostream &out, const CounterValues &baseline);
+
+    /**
+     * Add deltas written by writeCounterDeltas() to the counters, creating
+     * the ones that do not exist yet.
+     *
+     * @param in
+     *            Stream from which the deltas are read.
+     * @return False, if the deltas are malformed.
+     */
+    static bool addCounterDeltas(istream &in);
+
+    /**
+     * Write every metric in the Prometheus text exposition format. The
+     * process memory gauges are refreshed before writing.
+     *
+     * @param out
+     *            Stream on which the metrics are written.
+     */
+    static void write(ostream &out);
+
+    /**
+     * Write the metrics to a file for node-exporter's textfile collector. The
+     * file is written next to the destination and then renamed, so the
+     * collector never reads a partial file.
+     *
+     * @param path
+     *            Destination file, usually ending in ".prom".
+     * @return True, if the file has been written.
+     */
+    static bool writeTextfile(const string &path);
+
+    /**
+     * Start a background thread that rewrites the textfile periodically. The
+     * file is also written one last time when stopPeriodicExport() is called.
+     *
+     * @param path
+     *            Destination file.
+     * @param intervalSeconds
+     *            Seconds between two writes.
+     */
+    static void startPeriodicExport(const string &path, int intervalSeconds);
+
+    /**
+     * Stop the periodic export started by startPeriodicExport() and write the
+     * final values.
+     */
+    static void stopPeriodicExport();
+};
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include "minimize.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Run a function on every worker (0 to threads - 1), each on its own thread, and wait.
+ */
+void parallel(unsigned threads, const function<void(unsigned)> &task) {
+    vector<thread> workers;
+    for(unsigned worker = 1; worker < threads; worker++) workers.emplace_back(task, worker);
+    task(0);
+    for(thread &worker : workers) worker.join();
+}
+
+/**
+ * The part of [0, size) given to a worker.
+ */
+pair<size_t, size_t> chunk(size_t size, unsigned worker, unsigned threads) {
+    return pair<size_t, size_t>(size * worker / threads, size * (worker + 1) / threads);
+}
+
+}
+
+/**
+ * Minimize a compiled DFA with Moore's partition refinement, on several threads.
+ *
+ * @param table
+ *            The automaton to minimize.
+ * @param threads
+ *            Number of worker threads, or 0 for one per hardware thread.
+ * @return The minimal DFA, with the initial state numbered 0.
+ */
+CompiledDFA minimize(const DFATable &table, unsigned threads) {
+    if(threads == 0) threads = max(1u, thread::hardware_concurrency());
+    int classes = table.numClasses;
+
+    //Reachable states, renumbered in breadth-first order
+    vector<int> number(table.numStates, -1), order;
+    number[table.startState] = 0;
+    order.push_back(table.startState);
+    for(size_t i = 0; i < order.size(); i++) {
+        for(int letterClass = 0; letterClass < classes; letterClass++) {
+            int target = table.transitions[(size_t) order[i] * classes + letterClass];
+            if(number[target] == -1) {
+                number[target] = (int) order.size();
+                order.push_back(target);
+            }
+        }
+    }
+    size_t states = order.size();
+    vector<int> transitions(states * classes);
+    for(size_t state = 0; state < states; state++) {
+        for(int letterClass = 0; letterClass < classes; letterClass++) {
+            transitions[state * classes + letterClass] = number[table.transitions[(size_t) order[state] * classes + letterClass]];
+        }
+    }
+
+    //Blocks are numbered by their first state, so the initial partition is {start's kind, the other kind}
+    vector<int> block(states), next(states), local(states), firstNumber(states);
+    vector<uint64_t> signature(states);
+    vector<unsigned char> first(states);
+    bool startAccepting = table.isAccepting(table.startState);
+    int blocks = 0;
+    for(size_t state = 0; state < states; state++) {
+        block[state] = table.isAccepting(order[state]) == startAccepting ? 0 : 1;
+        blocks = max(blocks, block[state] + 1);
+    }
+
+    auto sameSignature = [&](size_t a, size_t b) {
+        if(block[a] != block[b]) return false;
+        for(int letterClass = 0; letterClass < classes; letterClass++) {
+            if(block[transitions[a * classes + letterClass]] != block[transitions[b * classes + letterClass]]) return false;
+        }
+        return true;
+    };
+
+    //owned[worker][owner] lists the states of the chunk of worker whose signature falls in the share of owner
+    vector<vector<vector<int>>> owned(threads, vector<vector<int>>(threads));
+    while(true) {
+        parallel(threads, [&](unsigned worker) {
+            pair<size_t, size_t> range = chunk(states, worker, threads);
+            for(vector<int> &members : owned[worker]) members.clear();
+            for(size_t state = range.first; state < range.second; state++) {
+                uint64_t hash = 0xcbf29ce484222325ULL ^ (uint64_t) block[state];
+                for(int letterClass = 0; letterClass < classes; letterClass++) {
+                    hash = (hash ^ (uint64_t) block[transitions[state * classes + letterClass]]) * 0x100000001b3ULL;
+                }
+                signature[state] = hash ^ (hash >> 32);
+                owned[worker][signature[state] % threads].push_back((int) state);
+            }
+        });
+        //Every worker groups the states whose signature hash falls in its share, in state order (the
+        //chunks are in order), and marks the first state of every new block
+        vector<vector<int>> localBlocks(threads);
+        parallel(threads, [&](unsigned worker) {
+            unordered_map<uint64_t, vector<int>> representatives;
+            for(unsigned source = 0; source < threads; source++) {
+                for(int state : owned[source][worker]) {
+                    vector<int> &candidates = representatives[signature[state]];
+                    int found = -1;
+                    for(int candidate : candidates) {
+                        if(sameSignature(candidate, state)) {
+                            found = candidate;
+                            break;
+                        }
+                    }
+                    first[state] = found == -1;
+                    if(found == -1) {
+                        candidates.push_back(state);
+                        local[state] = (int) localBlocks[worker].size();
+                        localBlocks[worker].push_back(state);
+                    } else {
+                        local[state] = local[found];
+                    }
+                }
+            }
+        });
+        //The new blocks are numbered in the order of their first state
+        int newBlocks = 0;
+        for(size_t state = 0; state < states; state++) {
+            if(first[state]) firstNumber[state] = newBlocks++;
+        }
+        parallel(threads, [&](unsigned worker) {
+            pair<size_t, size_t> range = chunk(states, worker, threads);
+            for(size_t state = range.first; state < range.second; state++) {
+                unsigned owner = (unsigned) (signature[state] % threads);
+                next[state] = firstNumber[localBlocks[owner][local[state]]];
+            }
+        });
+        block.swap(next);
+        //A round can only split blocks: the same number of blocks means the partition is stable
+        if(newBlocks == blocks) break;
+        blocks = newBlocks;
+    }
+
+    vector<int> minimalTransitions((size_t) blocks * classes);
+    vector<unsigned char> accepting(blocks);
+    for(size_t state = 0; state < states; state++) {
+        int b = block[state];
+        accepting[b] = table.isAccepting(order[state]);
+        for(int letterClass = 0; letterClass < classes; letterClass++) {
+            minimalTransitions[(size_t) b * classes + letterClass] = block[transitions[state * classes + letterClass]];
+        }
+    }
+    int trapState = table.trapState >= 0 && number[table.trapState] >= 0 ? block[number[table.trapState]] : -1;
+    DFATable minimal{blocks, classes, block[0], trapState, table.classMap, minimalTransitions.data(), accepting.data()};
+    return CompiledDFA(minimal);
+}
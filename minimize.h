@@ -0,0 +1,24 @@
+#pragma once
+
+#include "compiled.h"
+
+using namespace std;
+
+/**
+ * Minimize a compiled DFA with Moore's partition refinement, on several
+ * threads. The states unreachable from the initial state are dropped first;
+ * then every round gives each state the signature (its block, the blocks of
+ * its successors), hashes the signatures in parallel and splits the blocks
+ * whose states have different signatures, until no block is split.
+ *
+ * Blocks are numbered by their first state, in breadth-first order from the
+ * initial state, so the result is the same whatever the number of threads.
+ * The byte classes of the input are kept.
+ *
+ * @param table
+ *            The automaton to minimize.
+ * @param threads
+ *            Number of worker threads, or 0 for one per hardware thread.
+ * @return The minimal DFA, with the initial state numbered 0.
+ */
+CompiledDFA minimize(const DFATable &table, unsigned threads = 0);
@@ -0,0 +1,484 @@
+#include <algorithm>
+#include "nfa.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Node of the syntax tree of a pattern. The tree is built before the automaton
+ * because a bounded repetition needs one copy of its operand per repetition.
+ */
+struct Node {
+    enum Kind { Letters, Empty, Concat, Alternation, Repeat } kind;
+    tset letters;
+    vector<int> children;
+    int min = 0;
+    // -1 means no upper bound
+    int max = 0;
+};
+
+/**
+ * Largest bound accepted in {m,n}: every repetition is a copy of the operand.
+ */
+const int maxRepetitions = 1000;
+
+/**
+ * Largest number of states of the automaton of a pattern: nested bounded
+ * repetitions multiply the copies of their operand, e.g. (a{1000}){1000}.
+ */
+const uint64_t maxPatternStates = 1 << 18;
+
+/**
+ * Recursive-descent parser of the pattern syntax accepted by NFA::fromPattern.
+ */
+struct Parser {
+    const string &pattern;
+    size_t pos = 0;
+    vector<Node> nodes;
+    string error;
+
+    Parser(const string &p) : pattern(p) {}
+
+    bool atEnd() const { return pos >= pattern.length(); }
+
+    int newNode(Node::Kind kind) {
+        nodes.emplace_back();
+        nodes.back().kind = kind;
+        return (int) nodes.size() - 1;
+    }
+
+    bool fail(const string &message) {
+        if(error.empty()) error = message + " at offset " + to_string(pos);
+        return false;
+    }
+
+    /**
+     * Letters of an escape sequence; pos is on the letter after the backslash.
+     */
+    tset escape() {
+        tset letters;
+        unsigned char letter = pattern[pos++];
+        switch(letter) {
+            case 'n': letters.set('\n'); break;
+            case 't': letters.set('\t'); break;
+            case 'r': letters.set('\r'); break;
+            case 'd':
+                for(int c = '0'; c <= '9'; c++) letters.set(c);
+                break;
+            case 'w':
+                for(int c = '0'; c <= '9'; c++) letters.set(c);
+                for(int c = 'a'; c <= 'z'; c++) letters.set(c);
+                for(int c = 'A'; c <= 'Z'; c++) letters.set(c);
+                letters.set('_');
+                break;
+            case 's':
+                for(char c : string(" \t\n\r\f\v")) letters.set((unsigned char) c);
+                break;
+            default:
+                letters.set(letter);
+        }
+        return letters;
+    }
+
+    /**
+     * A bracketed class; pos is after the '['.
+     */
+    bool letterClass(tset &letters) {
+        bool negated = !atEnd() && pattern[pos] == '^';
+        if(negated) pos++;
+        bool first = true;
+        while(!atEnd() && (pattern[pos] != ']' || first)) {
+            first = false;
+            if(pattern[pos] == '\\' && pos + 1 < pattern.length()) {
+                pos++;
+                letters |= escape();
+                continue;
+            }
+            unsigned char low = pattern[pos++];
+            if(pos + 1 < pattern.length() && pattern[pos] == '-' && pattern[pos + 1] != ']') {
+                unsigned char high = pattern[pos + 1];
+                if(high < low) return fail("invalid range in class");
+                for(int c = low; c <= high; c++) letters.set(c);
+                pos += 2;
+            } else {
+                letters.set(low);
+            }
+        }
+        if(atEnd()) return fail("missing ]");
+        pos++;
+        if(negated) letters.flip();
+        return true;
+    }
+
+    int atom() {
+        unsigned char letter = pattern[pos];
+        if(letter == '(') {
+            pos++;
+            int node = alternation();
+            if(node < 0) return -1;
+            if(atEnd() || pattern[pos] != ')') return fail("missing )"), -1;
+            pos++;
+            return node;
+        }
+        if(letter == '*' || letter == '+' || letter == '?' || letter == '{') return fail("nothing to repeat"), -1;
+        int node = newNode(Node::Letters);
+        pos++;
+        if(letter == '.') {
+            nodes[node].letters.set();
+        } else if(letter == '[') {
+            tset letters;
+            if(!letterClass(letters)) return -1;
+            nodes[node].letters = letters;
+        } else if(letter == '\\') {
+            if(atEnd()) return fail("trailing backslash"), -1;
+            nodes[node].letters = escape();
+        } else {
+            nodes[node].letters.set(letter);
+        }
+        return node;
+    }
+
+    bool number(int &value) {
+        size_t start = pos;
+        value = 0;
+        while(!atEnd() && pattern[pos] >= '0' && pattern[pos] <= '9') {
+            value = value * 10 + (pattern[pos++] - '0');
+            if(value > maxRepetitions) return fail("repetition bound too large");
+        }
+        return pos > start || fail("missing repetition bound");
+    }
+
+    int repeat() {
+        int node = atom();
+        while(node >= 0 && !atEnd()) {
+            int min, max;
+            char letter = pattern[pos];
+            if(letter == '*') {
+                min = 0, max = -1;
+            } else if(letter == '+') {
+                min = 1, max = -1;
+            } else if(letter == '?') {
+                min = 0, max = 1;
+            } else if(letter == '{') {
+                pos++;
+                if(!number(min)) return -1;
+                max = min;
+                if(!atEnd() && pattern[pos] == ',') {
+                    pos++;
+                    max = -1;
+                    if(!atEnd() && pattern[pos] != '}' && !number(max)) return -1;
+                }
+                if(atEnd() || pattern[pos] != '}') return fail("missing }"), -1;
+                if(max != -1 && max < min) return fail("invalid repetition bounds"), -1;
+            } else {
+                break;
+            }
+            pos++;
+            int repeated = newNode(Node::Repeat);
+            nodes[repeated].children.push_back(node);
+            nodes[repeated].min = min;
+            nodes[repeated].max = max;
+            node = repeated;
+        }
+        return node;
+    }
+
+    int concatenation() {
+        int node = newNode(Node::Concat);
+        while(!atEnd() && pattern[pos] != '|' && pattern[pos] != ')') {
+            int child = repeat();
+            if(child < 0) return -1;
+            nodes[node].children.push_back(child);
+        }
+        if(nodes[node].children.empty()) nodes[node].kind = Node::Empty;
+        return node;
+    }
+
+    int alternation() {
+        int first = concatenation();
+        if(first < 0 || atEnd() || pattern[pos] != '|') return first;
+        int node = newNode(Node::Alternation);
+        nodes[node].children.push_back(first);
+        while(!atEnd() && pattern[pos] == '|') {
+            pos++;
+            int child = concatenation();
+            if(child < 0) return -1;
+            nodes[node].children.push_back(child);
+        }
+        return node;
+    }
+};
+
+/**
+ * Number of states that build() creates for a node, or more than
+ * maxPatternStates if it would create too many.
+ */
+uint64_t expandedStates(const vector<Node> &nodes, int n) {
+    const Node &node = nodes[n];
+    if(node.kind == Node::Letters) return 2;
+    if(node.kind == Node::Empty) return 1;
+    if(node.kind == Node::Repeat) {
+        //Both factors are at most maxRepetitions + 1 and maxPatternStates + 1, so the product can't overflow
+        uint64_t copies = node.max == -1 ? node.min + 1 : node.max;
+        return min(2 + copies * expandedStates(nodes, node.children[0]), maxPatternStates + 1);
+    }
+    uint64_t count = node.kind == Node::Alternation ? 2 : 0;
+    for(int child : node.children) count = min(count + expandedStates(nodes, child), maxPatternStates + 1);
+    return count;
+}
+
+/**
+ * Thompson construction: every node becomes a fragment with one entry and
+ * one exit state, connected to the other fragments by epsilon transitions.
+ */
+pair<int, int> build(const vector<Node> &nodes, int n, NFA &nfa) {
+    const Node &node = nodes[n];
+    switch(node.kind) {
+        case Node::Letters: {
+            int entry = nfa.addState(), exit = nfa.addState();
+            for(int low = 0; low < 256; low++) {
+                if(!node.letters.test(low)) continue;
+                int high = low;
+                while(high < 255 && node.letters.test(high + 1)) high++;
+                nfa.addTransition(entry, (unsigned char) low, (unsigned char) high, exit);
+                low = high;
+            }
+            return pair<int, int>(entry, exit);
+        }
+        case Node::Empty: {
+            int state = nfa.addState();
+            return pair<int, int>(state, state);
+        }
+        case Node::Concat: {
+            pair<int, int> whole = build(nodes, node.children[0], nfa);
+            for(size_t i = 1; i < node.children.size(); i++) {
+                pair<int, int> next = build(nodes, node.children[i], nfa);
+                nfa.addEpsilon(whole.second, next.first);
+                whole.second = next.second;
+            }
+            return whole;
+        }
+        case Node::Alternation: {
+            int entry = nfa.addState(), exit = nfa.addState();
+            for(int child : node.children) {
+                pair<int, int> branch = build(nodes, child, nfa);
+                nfa.addEpsilon(entry, branch.first);
+                nfa.addEpsilon(branch.second, exit);
+            }
+            return pair<int, int>(entry, exit);
+        }
+        case Node::Repeat: {
+            int entry = nfa.addState(), current = entry;
+            for(int i = 0; i < node.min; i++) {
+                pair<int, int> copy = build(nodes, node.children[0], nfa);
+                nfa.addEpsilon(current, copy.first);
+                current = copy.second;
+            }
+            if(node.max == -1) {
+                pair<int, int> loop = build(nodes, node.children[0], nfa);
+                nfa.addEpsilon(current, loop.first);
+                nfa.addEpsilon(loop.second, current);
+                return pair<int, int>(entry, current);
+            }
+            int exit = nfa.addState();
+            for(int i = node.min; i < node.max; i++) {
+                pair<int, int> copy = build(nodes, node.children[0], nfa);
+                nfa.addEpsilon(current, exit);
+                nfa.addEpsilon(current, copy.first);
+                current = copy.second;
+            }
+            nfa.addEpsilon(current, exit);
+            return pair<int, int>(entry, exit);
+        }
+    }
+    return pair<int, int>(-1, -1);
+}
+
+}
+
+/**
+ * Add a new state.
+ *
+ * @param accepting
+ *            True, if the state is final.
+ * @return The number of the state.
+ */
+int NFA::addState(bool accepting) {
+    edges.emplace_back();
+    epsilons.emplace_back();
+    this->accepting.push_back(accepting);
+    return (int) edges.size() - 1;
+}
+
+/**
+ * Make a state final or not.
+ */
+void NFA::setAccepting(int state, bool accepting) {
+    this->accepting[state] = accepting;
+}
+
+/**
+ * Add a transition taken by every byte in [low, high].
+ */
+void NFA::addTransition(int from, unsigned char low, unsigned char high, int to) {
+    edges[from].push_back(Edge{low, high, to});
+}
+
+/**
+ * Add a transition that doesn't read any input.
+ */
+void NFA::addEpsilon(int from, int to) {
+    epsilons[from].push_back(to);
+}
+
+/**
+ * Compute the set of final states and the byte classes: a new class starts
+ * at every byte where some transition starts or ends.
+ */
+void NFA::finalize() {
+    acceptingSet.assign(setWords(), 0);
+    for(size_t state = 0; state < accepting.size(); state++) {
+        if(accepting[state]) acceptingSet[state / 64] |= uint64_t(1) << (state % 64);
+    }
+    bool boundary[257] = {};
+    for(const vector<Edge> &stateEdges : edges) {
+        for(const Edge &edge : stateEdges) {
+            boundary[edge.low] = true;
+            boundary[edge.high + 1] = true;
+        }
+    }
+    classMap.assign(256, 0);
+    numClasses = 0;
+    for(int letter = 0; letter < 256; letter++) {
+        if(boundary[letter] && letter > 0) numClasses++;
+        classMap[letter] = (unsigned char) numClasses;
+    }
+    numClasses++;
+}
+
+namespace {
+
+/**
+ * Add the states reachable through epsilon transitions to a set; the states
+ * on the stack are not in the set yet.
+ */
+void closeOver(const vector<vector<int>> &epsilons, vector<int> &stack, NFA::StateSet &states) {
+    while(!stack.empty()) {
+        int state = stack.back();
+        stack.pop_back();
+        uint64_t bit = uint64_t(1) << (state % 64);
+        if(states[state / 64] & bit) continue;
+        states[state / 64] |= bit;
+        for(int target : epsilons[state]) stack.push_back(target);
+    }
+}
+
+}
+
+/**
+ * The states active before any input is read (the closure of state 0).
+ *
+ * @return The initial set of states.
+ */
+NFA::StateSet NFA::startSet() const {
+    StateSet states(setWords(), 0);
+    vector<int> stack;
+    if(!edges.empty()) stack.push_back(0);
+    closeOver(epsilons, stack, states);
+    return states;
+}
+
+/**
+ * The states reached from a set of states by reading a byte, epsilon
+ * closure included. The set is walked one 64-bit word at a time.
+ *
+ * @param from
+ *            The current set of states.
+ * @param letter
+ *            The current input.
+ * @param to
+ *            Receives the next set of states.
+ */
+void NFA::step(const StateSet &from, unsigned char letter, StateSet &to) const {
+    static thread_local vector<int> stack;
+    to.assign(setWords(), 0);
+    for(size_t word = 0; word < from.size(); word++) {
+        for(uint64_t bits = from[word]; bits != 0; bits &= bits - 1) {
+            int state = (int)(word * 64 + __builtin_ctzll(bits));
+            for(const Edge &edge : edges[state]) {
+                if(letter >= edge.low && letter <= edge.high) stack.push_back(edge.target);
+            }
+        }
+    }
+    closeOver(epsilons, stack, to);
+}
+
+/**
+ * Check if a set of states contains a final state.
+ *
+ * @param states
+ *            A set of states.
+ * @return True, if the set is accepting.
+ */
+bool NFA::isAccepting(const StateSet &states) const {
+    for(size_t word = 0; word < states.size(); word++) {
+        if(states[word] & acceptingSet[word]) return true;
+    }
+    return false;
+}
+
+/**
+ * Run the NFA on the input by bit-parallel simulation. The run stops as soon
+ * as no state is active.
+ *
+ * @param inputWord
+ *            stream that contains the input word
+ * @return True, if the word is accepted by this automaton
+ */
+bool NFA::run(const string &inputWord) const {
+    StateSet current = startSet(), next;
+    for(unsigned char letter : inputWord) {
+        step(current, letter, next);
+        current.swap(next);
+        bool empty = true;
+        for(uint64_t word : current) empty = empty && word == 0;
+        if(empty) return false;
+    }
+    return isAccepting(current);
+}
+
+/**
+ * Build the automaton of a pattern with the Thompson construction.
+ *
+ * @param pattern
+ *            The pattern.
+ * @param nfa
+ *            Receives the automaton, already finalized.
+ * @param error
+ *            If not null, receives a description of the syntax error.
+ * @return True, if the pattern is valid.
+ */
+bool NFA::fromPattern(const string &pattern, NFA &nfa, string *error) {
+    Parser parser(pattern);
+    int root = parser.alternation();
+    if(root >= 0 && !parser.atEnd()) {
+        parser.fail("unbalanced )");
+        root = -1;
+    }
+    if(root >= 0 && expandedStates(parser.nodes, root) > maxPatternStates) {
+        parser.error = "too many states after expanding the repetitions";
+        root = -1;
+    }
+    if(root < 0) {
+        if(error != nullptr) *error = parser.error;
+        return false;
+    }
+    nfa = NFA();
+    int start = nfa.addState();
+    pair<int, int> fragment = build(parser.nodes, root, nfa);
+    nfa.addEpsilon(start, fragment.first);
+    nfa.setAccepting(fragment.second, true);
+    nfa.finalize();
+    return true;
+}
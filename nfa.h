@@ -0,0 +1,197 @@
+#pragma once
+
+#include<cstdint>
+#include<string>
+#include<vector>
+#include "automata.h"
+
+using namespace std;
+
+/**
+ * Nondeterministic Finite Automaton over bytes, with byte-range and epsilon
+ * transitions. Sets of states are bit vectors (StateSet), so the automaton is
+ * simulated one word of 64 states at a time; the simulation takes linear time
+ * in the input and memory linear in the number of states, whatever the input.
+ *
+ * The automaton is built either with addState()/addTransition()/addEpsilon()
+ * followed by finalize(), or from a pattern with fromPattern(). The initial
+ * state is state 0.
+ */
+class NFA {
+public:
+    /**
+     * @brief StateSet represents a set of states, one bit per state
+     */
+    typedef vector<uint64_t> StateSet;
+
+    /**
+     * A transition taken by every byte in [low, high].
+     */
+    struct Edge {
+        unsigned char low;
+        unsigned char high;
+        int target;
+    };
+
+    /**
+     * Add a new state.
+     *
+     * @param accepting
+     *            True, if the state is final.
+     * @return The number of the state.
+     */
+    int addState(bool accepting = false);
+
+    /**
+     * Make a state final or not.
+     *
+     * @param state
+     *            A state of the automaton.
+     * @param accepting
+     *            True, if the state is final.
+     */
+    void setAccepting(int state, bool accepting);
+
+    /**
+     * Add a transition taken by every byte in [low, high].
+     *
+     * @param from
+     *            The source state.
+     * @param low
+     *            First byte of the range.
+     * @param high
+     *            Last byte of the range.
+     * @param to
+     *            The target state.
+     */
+    void addTransition(int from, unsigned char low, unsigned char high, int to);
+
+    /**
+     * Add a transition that doesn't read any input.
+     *
+     * @param from
+     *            The source state.
+     * @param to
+     *            The target state.
+     */
+    void addEpsilon(int from, int to);
+
+    /**
+     * Compute the set of final states and the byte classes. It must be
+     * called after the last state or transition has been added and before
+     * the automaton is run; epsilon closures are taken on the fly by step().
+     */
+    void finalize();
+
+    /**
+     * Number of states of the automaton.
+     *
+     * @return The number of states.
+     */
+    int stateCount() const { return (int) edges.size(); }
+
+    /**
+     * Number of 64-bit words of a StateSet.
+     *
+     * @return The size of a set of states.
+     */
+    size_t setWords() const { return (edges.size() + 63) / 64; }
+
+    /**
+     * Transitions leaving a state.
+     *
+     * @param state
+     *            A state of the automaton.
+     * @return The byte-range transitions of the state.
+     */
+    const vector<Edge> &transitions(int state) const { return edges[state]; }
+
+    /**
+     * Check if a state matters to the behaviour of the sets that contain it:
+     * a state that is not final and only has epsilon transitions adds nothing
+     * once the closure has been taken.
+     *
+     * @param state
+     *            A state of the automaton.
+     * @return True, if the state has a transition on a byte or is final.
+     */
+    bool isImportant(int state) const { return !edges[state].empty() || accepting[state]; }
+
+    /**
+     * Class of every byte: two bytes share a class if no transition tells them apart.
+     *
+     * @return The class map (256 entries); valid after finalize().
+     */
+    const vector<unsigned char> &byteClasses() const { return classMap; }
+
+    /**
+     * Number of byte classes.
+     *
+     * @return The number of distinct classes; valid after finalize().
+     */
+    int classCount() const { return numClasses; }
+
+    /**
+     * The states active before any input is read (the closure of state 0).
+     *
+     * @return The initial set of states.
+     */
+    StateSet startSet() const;
+
+    /**
+     * The states reached from a set of states by reading a byte, epsilon
+     * closure included.
+     *
+     * @param from
+     *            The current set of states.
+     * @param letter
+     *            The current input.
+     * @param to
+     *            Receives the next set of states.
+     */
+    void step(const StateSet &from, unsigned char letter, StateSet &to) const;
+
+    /**
+     * Check if a set of states contains a final state.
+     *
+     * @param states
+     *            A set of states.
+     * @return True, if the set is accepting.
+     */
+    bool isAccepting(const StateSet &states) const;
+
+    /**
+     * Run the NFA on the input by bit-parallel simulation.
+     *
+     * @param inputWord
+     *            stream that contains the input word
+     * @return True, if the word is accepted by this automaton
+     */
+    bool run(const string &inputWord) const;
+
+    /**
+     * Build the automaton of a pattern (Thompson construction). The syntax is
+     * a small subset of the usual regular expressions: literal bytes, '.' (any
+     * byte), classes like [a-z_] and [^}], escapes (\n, \t, \d, \w, \s and any
+     * escaped punctuation), groups, '|', and the quantifiers *, +, ?, {m},
+     * {m,} and {m,n}. The whole input has to match the pattern. A pattern
+     * whose bounded repetitions expand to more than 2^18 states is rejected.
+     *
+     * @param pattern
+     *            The pattern.
+     * @param nfa
+     *            Receives the automaton, already finalized.
+     * @param error
+     *            If not null, receives a description of the syntax error.
+     * @return True, if the pattern is valid.
+     */
+    static bool fromPattern(const string &pattern, NFA &nfa, string *error = nullptr);
+
+private:
+    vector<vector<Edge>> edges;
+    vector<vector<int>> epsilons;
+    vector<unsigned char> accepting;
+    StateSet acceptingSet;
+    vector<unsigned char> classMap;
+    int numClasses = 0;
+};
@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include "minimize.h"
+#include "operations.h"
+
+using namespace std;
+
+/**
+ * A state space explored on demand: states are numbered from 0 as they are
+ * reached, and every automaton reads bytes through its own byte classes.
+ * The generation changes whenever the numbering is dropped, so that the
+ * nodes built on this one drop the state numbers they have cached too.
+ */
+struct LazyAutomaton::Node {
+    unsigned char classMap[256];
+    int numClasses = 0;
+    uint64_t generation = 0;
+
+    virtual ~Node() = default;
+    virtual void clear() {}
+    virtual void refresh() {}
+    virtual int startState() = 0;
+    virtual int step(int state, unsigned char letter) = 0;
+    virtual bool isAccepting(int state) = 0;
+    virtual size_t stateCount() const = 0;
+};
+
+namespace {
+
+/**
+ * An operand: a compiled table, owned or not.
+ */
+struct TableNode : LazyAutomaton::Node {
+    unique_ptr<CompiledDFA> owned;
+    DFATable table;
+
+    TableNode(const DFATable &view) : table(view) {
+        copy(table.classMap, table.classMap + 256, classMap);
+        numClasses = table.numClasses;
+    }
+
+    int startState() override { return table.startState; }
+    int step(int state, unsigned char letter) override { return table.step(state, letter); }
+    bool isAccepting(int state) override { return table.isAccepting(state); }
+    size_t stateCount() const override { return table.numStates; }
+};
+
+/**
+ * Byte classes of a node with two operands: two bytes share a class if they
+ * share a class in both operands.
+ */
+void jointClasses(LazyAutomaton::Node &node, const LazyAutomaton::Node &a, const LazyAutomaton::Node &b) {
+    map<pair<int, int>, int> classes;
+    for(int letter = 0; letter < 256; letter++) {
+        auto inserted = classes.insert(pair<pair<int, int>, int>(pair<int, int>(a.classMap[letter], b.classMap[letter]),
+                                                                 (int) classes.size()));
+        node.classMap[letter] = (unsigned char) inserted.first->second;
+    }
+    node.numClasses = (int) classes.size();
+}
+
+/**
+ * A node whose states are built on demand: the row of a state is filled in
+ * one class at a time, the first time the class is read in that state.
+ */
+struct CachedNode : LazyAutomaton::Node {
+    static constexpr int unknown = -1;
+
+    shared_ptr<LazyAutomaton::Node> a, b;
+    //Generations of the operands the cached states refer to
+    uint64_t generationA = 0, generationB = 0;
+    vector<int> transitions;
+    vector<unsigned char> accepting;
+    int start = unknown;
+
+    CachedNode(shared_ptr<LazyAutomaton::Node> first, shared_ptr<LazyAutomaton::Node> second) : a(first), b(second) {
+        jointClasses(*this, *a, *b);
+    }
+
+    virtual int initial() = 0;
+    virtual int successor(int state, unsigned char letter) = 0;
+    virtual void clearStates() = 0;
+
+    /**
+     * Drop the states of this node only.
+     */
+    void reset() {
+        transitions = vector<int>();
+        accepting = vector<unsigned char>();
+        start = unknown;
+        clearStates();
+        generation++;
+    }
+
+    void clear() override {
+        a->clear();
+        b->clear();
+        reset();
+        generationA = a->generation;
+        generationB = b->generation;
+    }
+
+    void refresh() override {
+        a->refresh();
+        b->refresh();
+        if(a->generation != generationA || b->generation != generationB) {
+            reset();
+            generationA = a->generation;
+            generationB = b->generation;
+        }
+    }
+
+    int addState(bool final) {
+        accepting.push_back(final);
+        transitions.resize(transitions.size() + numClasses, unknown);
+        return (int) accepting.size() - 1;
+    }
+
+    int startState() override {
+        if(start == unknown) start = initial();
+        return start;
+    }
+
+    int step(int state, unsigned char letter) override {
+        size_t slot = (size_t) state * numClasses + classMap[letter];
+        int target = transitions[slot];
+        if(target == unknown) {
+            //successor() may add states and move the transitions, so the slot is written afterwards
+            target = successor(state, letter);
+            transitions[slot] = target;
+        }
+        return target;
+    }
+
+    bool isAccepting(int state) override { return accepting[state] != 0; }
+    size_t stateCount() const override { return accepting.size(); }
+};
+
+struct ComplementNode : LazyAutomaton::Node {
+    shared_ptr<LazyAutomaton::Node> operand;
+
+    ComplementNode(shared_ptr<LazyAutomaton::Node> a) : operand(a) {
+        copy(operand->classMap, operand->classMap + 256, classMap);
+        numClasses = operand->numClasses;
+    }
+
+    //The states are those of the operand
+    void clear() override {
+        operand->clear();
+        generation = operand->generation;
+    }
+
+    void refresh() override {
+        operand->refresh();
+        generation = operand->generation;
+    }
+
+    //The operands are complete automata (their trap states are ordinary states), so
+    //the complement only swaps final and non-final states
+    int startState() override { return operand->startState(); }
+    int step(int state, unsigned char letter) override { return operand->step(state, letter); }
+    bool isAccepting(int state) override { return !operand->isAccepting(state); }
+    size_t stateCount() const override { return operand->stateCount(); }
+};
+
+/**
+ * Product of two automata, whose final states are given by a boolean operation.
+ */
+struct ProductNode : CachedNode {
+    enum Operation { Intersection, Union, Difference } operation;
+    vector<pair<int, int>> pairs;
+    unordered_map<uint64_t, int> index;
+
+    ProductNode(Operation op, shared_ptr<LazyAutomaton::Node> first, shared_ptr<LazyAutomaton::Node> second)
+        : CachedNode(first, second), operation(op) {}
+
+    void clearStates() override {
+        pairs = vector<pair<int, int>>();
+        index = unordered_map<uint64_t, int>();
+    }
+
+    int state(int p, int q) {
+        uint64_t key = ((uint64_t) (uint32_t) p << 32) | (uint32_t) q;
+        auto found = index.find(key);
+        if(found != index.end()) return found->second;
+        bool inA = a->isAccepting(p), inB = b->isAccepting(q);
+        bool final = operation == Intersection ? inA && inB : operation == Union ? inA || inB : inA && !inB;
+        int added = addState(final);
+        pairs.push_back(pair<int, int>(p, q));
+        index.insert(pair<uint64_t, int>(key, added));
+        return added;
+    }
+
+    int initial() override { return state(a->startState(), b->startState()); }
+
+    int successor(int s, unsigned char letter) override {
+        int p = pairs[s].first, q = pairs[s].second;
+        return state(a->step(p, letter), b->step(q, letter));
+    }
+};
+
+/**
+ * Concatenation of two automata: a state is a state of the first automaton
+ * with the set of states of the second one started after every prefix
+ * accepted by the first.
+ */
+struct ConcatenationNode : CachedNode {
+    vector<pair<int, vector<int>>> states;
+    map<pair<int, vector<int>>, int> index;
+
+    ConcatenationNode(shared_ptr<LazyAutomaton::Node> first, shared_ptr<LazyAutomaton::Node> second)
+        : CachedNode(first, second) {}
+
+    void clearStates() override {
+        states = vector<pair<int, vector<int>>>();
+        index.clear();
+    }
+
+    int state(int p, vector<int> &started) {
+        if(a->isAccepting(p)) started.push_back(b->startState());
+        sort(started.begin(), started.end());
+        started.erase(unique(started.begin(), started.end()), started.end());
+        pair<int, vector<int>> key(p, started);
+        auto found = index.find(key);
+        if(found != index.end()) return found->second;
+        bool final = any_of(started.begin(), started.end(), [&](int q) { return b->isAccepting(q); });
+        int added = addState(final);
+        states.push_back(key);
+        index.insert(pair<pair<int, vector<int>>, int>(key, added));
+        return added;
+    }
+
+    int initial() override {
+        vector<int> started;
+        return state(a->startState(), started);
+    }
+
+    int successor(int s, unsigned char letter) override {
+        //Copied, since state() may add to states
+        pair<int, vector<int>> current = states[s];
+        vector<int> started;
+        for(int q : current.second) started.push_back(b->step(q, letter));
+        return state(a->step(current.first, letter), started);
+    }
+};
+
+}
+
+/**
+ * Use an automaton of the project as an operand; it is compiled once.
+ *
+ * @param dfa
+ *            The automaton.
+ */
+LazyAutomaton::LazyAutomaton(const AbstractDFA &dfa) {
+    auto compiled = make_unique<CompiledDFA>(dfa);
+    auto leaf = make_shared<TableNode>(compiled->table());
+    leaf->owned = move(compiled);
+    node = leaf;
+}
+
+/**
+ * Use a compiled table as an operand.
+ *
+ * @param table
+ *            The table, which must outlive this automaton.
+ */
+LazyAutomaton::LazyAutomaton(const DFATable &table) : node(make_shared<TableNode>(table)) {}
+
+/**
+ * Run the automaton on the input, building the states it reaches.
+ *
+ * @param inputWord
+ *            stream that contains the input word
+ * @return True, if the word is accepted by this automaton
+ */
+bool LazyAutomaton::run(const string &inputWord) {
+    node->refresh();
+    int state = node->startState();
+    for(unsigned char letter : inputWord) state = node->step(state, letter);
+    return node->isAccepting(state);
+}
+
+/**
+ * Number of states built so far.
+ *
+ * @return The number of cached states.
+ */
+size_t LazyAutomaton::cachedStates() const {
+    return node->stateCount();
+}
+
+/**
+ * Drop the states built so far by this automaton and by its operands. The
+ * other expressions that share an operand notice the new generation of the
+ * operand at their next run and drop their states too.
+ */
+void LazyAutomaton::clearCache() {
+    node->clear();
+}
+
+/**
+ * Build every reachable state, in breadth-first order, and compile the result
+ * into a table. A non-final state that loops on itself for every byte becomes
+ * the trap state.
+ *
+ * @param minimal
+ *            True, to minimize the table.
+ * @return The compiled automaton.
+ */
+CompiledDFA LazyAutomaton::materialize(bool minimal) {
+    node->refresh();
+    int classes = node->numClasses;
+    vector<unsigned char> representative(classes);
+    for(int letter = 255; letter >= 0; letter--) representative[node->classMap[letter]] = (unsigned char) letter;
+    unordered_map<int, int> number;
+    vector<int> order;
+    order.push_back(node->startState());
+    number.insert(pair<int, int>(order[0], 0));
+    vector<int> transitions;
+    for(size_t i = 0; i < order.size(); i++) {
+        for(int letterClass = 0; letterClass < classes; letterClass++) {
+            int target = node->step(order[i], representative[letterClass]);
+            auto inserted = number.insert(pair<int, int>(target, (int) order.size()));
+            if(inserted.second) order.push_back(target);
+            transitions.push_back(inserted.first->second);
+        }
+    }
+    vector<unsigned char> accepting(order.size());
+    int trapState = -1;
+    for(size_t state = 0; state < order.size(); state++) {
+        accepting[state] = node->isAccepting(order[state]);
+        bool loops = all_of(transitions.begin() + state * classes, transitions.begin() + (state + 1) * classes,
+                            [&](int target) { return target == (int) state; });
+        if(trapState == -1 && !accepting[state] && loops) trapState = (int) state;
+    }
+    DFATable table{(int) order.size(), classes, 0, trapState, node->classMap, transitions.data(), accepting.data()};
+    return minimal ? minimize(table) : CompiledDFA(table);
+}
+
+/**
+ * Automaton accepting the words rejected by a.
+ */
+LazyAutomaton complement(const LazyAutomaton &a) {
+    return LazyAutomaton(make_shared<ComplementNode>(a.node));
+}
+
+/**
+ * Automaton accepting the words accepted by both a and b.
+ */
+LazyAutomaton intersection(const LazyAutomaton &a, const LazyAutomaton &b) {
+    return LazyAutomaton(make_shared<ProductNode>(ProductNode::Intersection, a.node, b.node));
+}
+
+/**
+ * Automaton accepting the words accepted by a or by b.
+ */
+LazyAutomaton unionOf(const LazyAutomaton &a, const LazyAutomaton &b) {
+    return LazyAutomaton(make_shared<ProductNode>(ProductNode::Union, a.node, b.node));
+}
+
+/**
+ * Automaton accepting the words accepted by a and rejected by b.
+ */
+LazyAutomaton difference(const LazyAutomaton &a, const LazyAutomaton &b) {
+    return LazyAutomaton(make_shared<ProductNode>(ProductNode::Difference, a.node, b.node));
+}
+
+/**
+ * Automaton accepting the words made of a word accepted by a followed by a
+ * word accepted by b.
+ */
+LazyAutomaton concatenation(const LazyAutomaton &a, const LazyAutomaton &b) {
+    return LazyAutomaton(make_shared<ConcatenationNode>(a.node, b.node));
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include<memory>
+#include<string>
+#include "automata.h"
+#include "compiled.h"
+
+using namespace std;
+
+/**
+ * An automaton built by combining other automata with boolean operations and
+ * concatenation, evaluated lazily: the states of the result (pairs of states
+ * of the operands, or an operand state with a set of states of the other one
+ * for a concatenation) are created only when a run reaches them, and every
+ * state and transition is cached for the following runs. Combining automata
+ * is therefore cheap, whatever the size of the full product.
+ *
+ * The cache is not bounded: its memory grows with the number of states of
+ * the product that the runs explore, which for long varied inputs can
+ * approach the size of the full product. A caller that runs many inputs
+ * bounds it by checking cachedStates() and calling clearCache() between runs.
+ *
+ * Operands are shared, not copied, so the same automaton can appear in many
+ * expressions. Automata given as a DFATable must outlive the expressions that
+ * use them. The cache makes run() non-const: an expression must not be used
+ * by concurrent threads.
+ */
+class LazyAutomaton {
+public:
+    struct Node;
+
+    /**
+     * Use an automaton of the project as an operand; it is compiled once.
+     *
+     * @param dfa
+     *            The automaton.
+     */
+    LazyAutomaton(const AbstractDFA &dfa);
+
+    /**
+     * Use a compiled table (e.g. one embedded in the binary) as an operand.
+     *
+     * @param table
+     *            The table, which must outlive this automaton.
+     */
+    LazyAutomaton(const DFATable &table);
+
+    /**
+     * Run the automaton on the input, building the states it reaches.
+     *
+     * @param inputWord
+     *            stream that contains the input word
+     * @return True, if the word is accepted by this automaton
+     */
+    bool run(const string &inputWord);
+
+    /**
+     * Number of states built so far.
+     *
+     * @return The number of cached states.
+     */
+    size_t cachedStates() const;
+
+    /**
+     * Drop every state built so far, also those of the operands, freeing
+     * their memory. The following runs build the states they reach again.
+     */
+    void clearCache();
+
+    /**
+     * Build every reachable state and compile the result into a table.
+     *
+     * @param minimal
+     *            True, to minimize the table.
+     * @return The compiled automaton.
+     */
+    CompiledDFA materialize(bool minimal = false);
+
+    /**
+     * Automaton accepting the words rejected by a.
+     */
+    friend LazyAutomaton complement(const LazyAutomaton &a);
+
+    /**
+     * Automaton accepting the words accepted by both a and b.
+     */
+    friend LazyAutomaton intersection(const LazyAutomaton &a, const LazyAutomaton &b);
+
+    /**
+     * Automaton accepting the words accepted by a or by b.
+     */
+    friend LazyAutomaton unionOf(const LazyAutomaton &a, const LazyAutomaton &b);
+
+    /**
+     * Automaton accepting the words accepted by a and rejected by b.
+     */
+    friend LazyAutomaton difference(const LazyAutomaton &a, const LazyAutomaton &b);
+
+    /**
+     * Automaton accepting the words made of a word accepted by a followed by a
+     * word accepted by b.
+     */
+    friend LazyAutomaton concatenation(const LazyAutomaton &a, const LazyAutomaton &b);
+
+private:
+    shared_ptr<Node> node;
+
+    LazyAutomaton(shared_ptr<Node> node) : node(node) {}
+};
+
+LazyAutomaton complement(const LazyAutomaton &a);
+LazyAutomaton intersection(const LazyAutomaton &a, const LazyAutomaton &b);
+LazyAutomaton unionOf(const LazyAutomaton &a, const LazyAutomaton &b);
+LazyAutomaton difference(const LazyAutomaton &a, const LazyAutomaton &b);
+LazyAutomaton concatenation(const LazyAutomaton &a, const LazyAutomaton &b);
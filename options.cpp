@@ -0,0 +1,28 @@
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include "options.h"
+
+using namespace std;
+
+/**
+ * Parse the value of a numeric command line option.
+ *
+ * @param text
+ *            The value given on the command line.
+ * @param minimum
+ *            Smallest valid value.
+ * @param maximum
+ *            Largest valid value.
+ * @param value
+ *            Receives the number.
+ * @return False, if the text is not a decimal number in [minimum, maximum].
+ */
+bool parseNumber(const char *text, uint64_t minimum, uint64_t maximum, uint64_t &value) {
+    //strtoull would also take signs and leading spaces
+    if(!isdigit((unsigned char) text[0])) return false;
+    errno = 0;
+    char *end;
+    value = strtoull(text, &end, 10);
+    return *end == '\0' && errno == 0 && value >= minimum && value <= maximum;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include<cstdint>
+
+using namespace std;
+
+/**
+ * Parse the value of a numeric command line option.
+ *
+ * @param text
+ *            The value given on the command line.
+ * @param minimum
+ *            Smallest valid value.
+ * @param maximum
+ *            Largest valid value.
+ * @param value
+ *            Receives the number.
+ * @return False, if the text is not a decimal number in [minimum, maximum].
+ */
+bool parseNumber(const char *text, uint64_t minimum, uint64_t maximum, uint64_t &value);
@@ -0,0 +1,85 @@
+#include <fstream>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "replicated.h"
+
+using namespace std;
+
+namespace {
+
+// from numaif.h, so that libnuma is not needed
+const int bindPolicy = 2;   // MPOL_BIND
+const unsigned moveFlag = 2;   // MPOL_MF_MOVE
+
+/**
+ * Bind the pages of a table to a node, before they are first touched. Only
+ * tables allocated on huge pages are page aligned, and smaller ones fit in
+ * the caches anyway.
+ *
+ * @return False, if the kernel refused the binding.
+ */
+bool bindToNode(void *memory, size_t bytes, int node) {
+    if(bytes < hugePageSize) return true;
+    if(node >= 64) return false;
+    unsigned long mask = 1UL << node;
+    return syscall(SYS_mbind, memory, bytes, bindPolicy, &mask, 64UL, moveFlag) == 0;
+}
+
+}
+
+/**
+ * Number of NUMA nodes of the machine, from the list of the online nodes
+ * (e.g. "0-1" or "0,2-3") in sysfs.
+ *
+ * @return The number of nodes, 1 if the system doesn't tell.
+ */
+int ReplicatedDFA::numaNodes() {
+    ifstream online("/sys/devices/system/node/online");
+    string list;
+    if(!getline(online, list) || list.empty()) return 1;
+    //The list is sorted, so the last number is the highest node
+    size_t last = list.find_last_of(",-");
+    return stoi(last == string::npos ? list : list.substr(last + 1)) + 1;
+}
+
+/**
+ * Copy a compiled table on every NUMA node.
+ *
+ * @param table
+ *            The table to copy.
+ * @param replicate
+ *            False, to keep a single copy anyway.
+ */
+ReplicatedDFA::ReplicatedDFA(const DFATable &table, bool replicate) : unbound(0) {
+    int nodes = replicate ? numaNodes() : 1;
+    size_t cells = (size_t) table.numStates * table.numClasses;
+    for(int node = 0; node < nodes; node++) {
+        auto replica = make_unique<Replica>();
+        replica->classMap.assign(table.classMap, table.classMap + 256);
+        //The transitions are allocated, bound and only then copied: the first touch places the pages
+        replica->transitions.reserve(cells);
+        if(nodes > 1 && !bindToNode(replica->transitions.data(), cells * sizeof(int), node)) unbound++;
+        replica->transitions.assign(table.transitions, table.transitions + cells);
+        replica->accepting.assign(table.accepting, table.accepting + table.numStates);
+        replica->table = DFATable{table.numStates, table.numClasses, table.startState, table.trapState,
+                                  replica->classMap.data(), replica->transitions.data(), replica->accepting.data()};
+        replicas.push_back(move(replica));
+    }
+}
+
+/**
+ * The copy on the node of the calling thread. The node is asked to the kernel
+ * only once per thread.
+ *
+ * @return The local table.
+ */
+const DFATable &ReplicatedDFA::local() const {
+    if(replicas.size() == 1) return replicas[0]->table;
+    thread_local int node = -1;
+    if(node == -1) {
+        unsigned cpu = 0, current = 0;
+        node = syscall(SYS_getcpu, &cpu, &current, nullptr) == 0 ? (int) current : 0;
+    }
+    return replicas[(size_t) node < replicas.size() ? node : 0]->table;
+}
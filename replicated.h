@@ -0,0 +1,70 @@
+#pragma once
+
+#include<memory>
+#include<vector>
+#include "compiled.h"
+#include "hugepages.h"
+
+using namespace std;
+
+/**
+ * Read-only copies of a compiled DFA, one per NUMA node, so that the threads
+ * of every socket read the transitions from local memory. Every copy is
+ * allocated like a CompiledDFA (on huge pages if large) and its pages are
+ * bound to its node. On a machine with a single node there is one copy.
+ */
+class ReplicatedDFA {
+    struct Replica {
+        vector<unsigned char, HugePageAllocator<unsigned char>> classMap;
+        vector<int, HugePageAllocator<int>> transitions;
+        vector<unsigned char, HugePageAllocator<unsigned char>> accepting;
+        DFATable table;
+    };
+
+    vector<unique_ptr<Replica>> replicas;
+    /**
+     * @brief unbound represents the number of copies whose pages could not be bound to their node
+     */
+    int unbound;
+public:
+    /**
+     * Copy a compiled table on every NUMA node.
+     *
+     * @param table
+     *            The table to copy.
+     * @param replicate
+     *            False, to keep a single copy anyway.
+     */
+    ReplicatedDFA(const DFATable &table, bool replicate = true);
+
+    /**
+     * The copy on the node of the calling thread. The node is looked up the
+     * first time a thread calls it, so a thread that moves to another node
+     * keeps reading its first copy.
+     *
+     * @return The local table.
+     */
+    const DFATable &local() const;
+
+    /**
+     * Number of copies of the table.
+     *
+     * @return The number of replicas.
+     */
+    int replicaCount() const { return (int) replicas.size(); }
+
+    /**
+     * Number of copies whose pages could not be bound to their node, e.g.
+     * because the kernel has no NUMA support.
+     *
+     * @return The number of unbound replicas.
+     */
+    int unboundCount() const { return unbound; }
+
+    /**
+     * Number of NUMA nodes of the machine.
+     *
+     * @return The number of nodes, 1 if the system doesn't tell.
+     */
+    static int numaNodes();
+};
@@ -0,0 +1,37 @@
+#include <iostream>
+#include <string>
+#include "results.h"
+
+using namespace std;
+
+/**
+ * Print the rows of a columnar result file written by main --results or by
+ * corpus run --results, one per line: file ID, pattern ID, verdict and the
+ * end offsets of the matches. A corrupt or truncated block stops the dump
+ * with exit status 1.
+ *   result_dump resultfile
+ */
+int main(int argc, char* argv[]) {
+    if(argc != 2) {
+        cout << "Usage: result_dump resultfile" << endl;
+        return 1;
+    }
+    ResultReader reader;
+    if(!reader.open(argv[1])) {
+        cout << "Invalid result file " << argv[1] << endl;
+        return 1;
+    }
+    ResultColumns columns;
+    while(reader.next(columns)) {
+        for(size_t row = 0; row < columns.rows(); row++) {
+            cout << columns.fileIds[row] << ' ' << columns.patternIds[row] << ' ' << (int) columns.verdicts[row];
+            for(uint64_t i = columns.offsetStart[row]; i < columns.offsetStart[row + 1]; i++) cout << ' ' << columns.offsets[i];
+            cout << '\n';
+        }
+    }
+    if(reader.error()) {
+        cout << "Corrupt result file " << argv[1] << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "results.h"
+
+using namespace std;
+
+namespace {
+
+const char resultMagic[8] = {'L', 'R', 'E', 'S', 'U', 'L', 'T', '1'};
+
+/**
+ * Header of a block: the number of rows and the size of every column, in
+ * the order of ResultBlock. The columns follow it.
+ */
+struct BlockHeader {
+    uint32_t rows;
+    uint32_t columnBytes[5];
+};
+
+void putVarint(string &column, uint64_t value) {
+    for(; value >= 0x80; value >>= 7) column.push_back((char) (value | 0x80));
+    column.push_back((char) value);
+}
+
+/**
+ * Decode a varint.
+ *
+ * @return False, if the column ends before the varint.
+ */
+bool getVarint(const char *&position, const char *end, uint64_t &value) {
+    value = 0;
+    for(int shift = 0; position < end && shift < 64; shift += 7) {
+        unsigned char byte = (unsigned char) *position++;
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if(byte < 0x80) return true;
+    }
+    return false;
+}
+
+}
+
+/**
+ * Append a row, encoding it into every column.
+ *
+ * @param fileId
+ *            The input.
+ * @param patternId
+ *            The automaton.
+ * @param verdict
+ *            True, if the input is accepted.
+ * @param offsets
+ *            The end offsets of the matches, in increasing order.
+ */
+void ResultBlock::add(uint64_t fileId, uint32_t patternId, bool verdict, const vector<uint64_t> &offsets) {
+    //The file IDs may go backwards (e.g. from several workers), hence the zigzag encoding
+    int64_t delta = (int64_t) (fileId - lastFile);
+    putVarint(fileColumn, ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63));
+    lastFile = fileId;
+    putVarint(patternColumn, patternId);
+    if(rows % 8 == 0) verdictColumn.push_back(0);
+    if(verdict) verdictColumn.back() |= (char) (1 << (rows % 8));
+    putVarint(countColumn, offsets.size());
+    uint64_t previous = 0;
+    for(uint64_t offset : offsets) {
+        putVarint(offsetColumn, offset - previous);
+        previous = offset;
+    }
+    rows++;
+}
+
+void ResultBlock::clear() {
+    rows = 0;
+    lastFile = 0;
+    fileColumn.clear();
+    patternColumn.clear();
+    verdictColumn.clear();
+    countColumn.clear();
+    offsetColumn.clear();
+}
+
+ResultWriter::~ResultWriter() { close(); }
+
+/**
+ * Create the file and write its header; blocks are then appended.
+ *
+ * @param path
+ *            Destination file.
+ * @return True, if the file has been created.
+ */
+bool ResultWriter::open(const string &path) {
+    close();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if(fd < 0) return false;
+    if(::write(fd, resultMagic, sizeof(resultMagic)) != (ssize_t) sizeof(resultMagic)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Encode the rows as a block: the header, then the columns.
+ *
+ * @return The bytes of the block, empty if there are no rows.
+ */
+string ResultBlock::encode() const {
+    if(empty()) return string();
+    BlockHeader header{rows, {(uint32_t) fileColumn.size(), (uint32_t) patternColumn.size(), (uint32_t) verdictColumn.size(),
+                              (uint32_t) countColumn.size(), (uint32_t) offsetColumn.size()}};
+    string buffer;
+    buffer.reserve(sizeof(header) + bytes());
+    buffer.append((const char *) &header, sizeof(header));
+    buffer += fileColumn;
+    buffer += patternColumn;
+    buffer += verdictColumn;
+    buffer += countColumn;
+    buffer += offsetColumn;
+    return buffer;
+}
+
+/**
+ * Write a block with its header in a single write() and clear it.
+ *
+ * @param block
+ *            The block.
+ * @return True, if the block has been written.
+ */
+bool ResultWriter::write(ResultBlock &block) {
+    if(block.empty()) return true;
+    string buffer = block.encode();
+    block.clear();
+    return writeEncoded(buffer);
+}
+
+/**
+ * Write encoded blocks in a single write().
+ *
+ * @param blocks
+ *            The bytes of the blocks.
+ * @return True, if the blocks have been written.
+ */
+bool ResultWriter::writeEncoded(const string &blocks) {
+    lock_guard<mutex> lock(writeMutex);
+    if(fd < 0) return false;
+    //A regular file takes the whole buffer at once; the loop only guards against short writes
+    for(size_t written = 0; written < blocks.size();) {
+        ssize_t result = ::write(fd, blocks.data() + written, blocks.size() - written);
+        if(result <= 0) return false;
+        written += (size_t) result;
+    }
+    return true;
+}
+
+void ResultWriter::close() {
+    lock_guard<mutex> lock(writeMutex);
+    if(fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+/**
+ * Open a result file and check its header.
+ *
+ * @param path
+ *            The result file.
+ * @return True, if the file is a result file.
+ */
+bool ResultReader::open(const string &path) {
+    in.open(path, ios::binary);
+    in.seekg(0, ios::end);
+    streamoff size = in.tellg();
+    in.seekg(0);
+    char magic[8];
+    if(size < (streamoff) sizeof(magic) || !in.read(magic, sizeof(magic)) || memcmp(magic, resultMagic, sizeof(resultMagic)) != 0) return false;
+    remaining = (uint64_t) size - sizeof(magic);
+    return true;
+}
+
+/**
+ * Decode the next block.
+ *
+ * @param columns
+ *            Receives the rows of the block.
+ * @return False, at the end of the file or if the block is corrupt (see error()).
+ */
+bool ResultReader::next(ResultColumns &columns) {
+    if(remaining == 0) return false;
+    //Every return before the whole block is decoded is a corrupt or truncated block
+    corrupt = true;
+    BlockHeader header;
+    if(remaining < sizeof(header) || !in.read((char *) &header, sizeof(header))) return false;
+    remaining -= sizeof(header);
+    string column[5];
+    for(int i = 0; i < 5; i++) {
+        //A corrupt size would otherwise allocate up to 4 GB before the read fails
+        if(header.columnBytes[i] > remaining) return false;
+        remaining -= header.columnBytes[i];
+        column[i].resize(header.columnBytes[i]);
+        if(!in.read(column[i].data(), (streamsize) column[i].size())) return false;
+    }
+    if(column[2].size() != (header.rows + 7) / 8) return false;
+    columns.fileIds.clear();
+    columns.patternIds.clear();
+    columns.verdicts.clear();
+    columns.offsetStart.assign(1, 0);
+    columns.offsets.clear();
+    const char *files = column[0].data(), *patterns = column[1].data(), *counts = column[3].data(), *offsets = column[4].data();
+    uint64_t fileId = 0;
+    for(uint32_t row = 0; row < header.rows; row++) {
+        uint64_t zigzag, patternId, count;
+        if(!getVarint(files, column[0].data() + column[0].size(), zigzag) ||
+           !getVarint(patterns, column[1].data() + column[1].size(), patternId) ||
+           !getVarint(counts, column[3].data() + column[3].size(), count)) return false;
+        fileId += (uint64_t) ((int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1));
+        columns.fileIds.push_back(fileId);
+        columns.patternIds.push_back((uint32_t) patternId);
+        columns.verdicts.push_back((column[2][row / 8] >> (row % 8)) & 1);
+        uint64_t offset = 0;
+        for(uint64_t i = 0; i < count; i++) {
+            uint64_t delta;
+            if(!getVarint(offsets, column[4].data() + column[4].size(), delta)) return false;
+            offset += delta;
+            columns.offsets.push_back(offset);
+        }
+        columns.offsetStart.push_back(columns.offsets.size());
+    }
+    corrupt = false;
+    return true;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include<cstdint>
+#include<fstream>
+#include<mutex>
+#include<string>
+#include<vector>
+
+using namespace std;
+
+/**
+ * @brief resultBlockBytes represents the encoded size at which a result block should be written
+ */
+const size_t resultBlockBytes = 1 << 20;
+
+/**
+ * Buffer of result rows in columnar form, one per thread (or process). A row
+ * is a verdict of an automaton on an input, with the end offsets of its
+ * matches; the columns are encoded as they are filled:
+ *   - file IDs: difference from the previous row, zigzag varint
+ *   - pattern IDs: varint
+ *   - verdicts: bitmap, one bit per row
+ *   - offset counts: varint, one per row
+ *   - offsets: difference from the previous offset of the same row, varint
+ */
+class ResultBlock {
+    uint32_t rows = 0;
+    uint64_t lastFile = 0;
+    string fileColumn;
+    string patternColumn;
+    string verdictColumn;
+    string countColumn;
+    string offsetColumn;
+public:
+    /**
+     * Append a row.
+     *
+     * @param fileId
+     *            The input.
+     * @param patternId
+     *            The automaton.
+     * @param verdict
+     *            True, if the input is accepted.
+     * @param offsets
+     *            The end offsets of the matches, in increasing order.
+     */
+    void add(uint64_t fileId, uint32_t patternId, bool verdict, const vector<uint64_t> &offsets = vector<uint64_t>());
+
+    /**
+     * Size of the encoded rows in bytes.
+     */
+    size_t bytes() const {
+        return fileColumn.size() + patternColumn.size() + verdictColumn.size() + countColumn.size() + offsetColumn.size();
+    }
+
+    /**
+     * Check if the block is large enough to be written.
+     */
+    bool full() const { return bytes() >= resultBlockBytes; }
+
+    bool empty() const { return rows == 0; }
+
+    /**
+     * Remove every row.
+     */
+    void clear();
+
+    /**
+     * Encode the rows as a block of a result file, with its header; an empty
+     * block is encoded as nothing.
+     *
+     * @return The bytes of the block.
+     */
+    string encode() const;
+};
+
+/**
+ * Writes result blocks to a file. A block is written with one write() on a
+ * file opened in append mode, so threads (through the lock) and processes
+ * that inherited the writer (through O_APPEND) can share it: blocks never
+ * interleave, and every row carries its file ID.
+ */
+class ResultWriter {
+    int fd = -1;
+    mutex writeMutex;
+public:
+    ResultWriter() = default;
+    ~ResultWriter();
+
+    ResultWriter(const ResultWriter &) = delete;
+    ResultWriter &operator=(const ResultWriter &) = delete;
+
+    /**
+     * Create the file (replacing an existing one) and write its header.
+     *
+     * @param path
+     *            Destination file.
+     * @return True, if the file has been created.
+     */
+    bool open(const string &path);
+
+    bool isOpen() const { return fd >= 0; }
+
+    /**
+     * Write a block and clear it. An empty block is not written.
+     *
+     * @param block
+     *            The block.
+     * @return True, if the block has been written.
+     */
+    bool write(ResultBlock &block);
+
+    /**
+     * Write blocks encoded by ResultBlock::encode() (e.g. in another
+     * process), in a single write().
+     *
+     * @param blocks
+     *            The bytes of the blocks.
+     * @return True, if the blocks have been written.
+     */
+    bool writeEncoded(const string &blocks);
+
+    /**
+     * Close the file.
+     */
+    void close();
+};
+
+/**
+ * Decoded columns of a result block.
+ */
+struct ResultColumns {
+    vector<uint64_t> fileIds;
+    vector<uint32_t> patternIds;
+    vector<unsigned char> verdicts;
+    /**
+     * @brief offsetStart represents where the offsets of every row start in offsets (one more entry than rows)
+     */
+    vector<uint64_t> offsetStart;
+    vector<uint64_t> offsets;
+
+    size_t rows() const { return fileIds.size(); }
+};
+
+/**
+ * Reads a result file written by ResultWriter, one block at a time.
+ */
+class ResultReader {
+    ifstream in;
+    /**
+     * @brief remaining represents the number of bytes of the file not read yet
+     */
+    uint64_t remaining = 0;
+    /**
+     * @brief corrupt represents whether the last block could not be decoded
+     */
+    bool corrupt = false;
+public:
+    /**
+     * Open a result file.
+     *
+     * @param path
+     *            The result file.
+     * @return True, if the file is a result file.
+     */
+    bool open(const string &path);
+
+    /**
+     * Decode the next block.
+     *
+     * @param columns
+     *            Receives the rows of the block.
+     * @return False, at the end of the file or if the block is corrupt (see error()).
+     */
+    bool next(ResultColumns &columns);
+
+    /**
+     * Check if reading stopped on a corrupt or truncated block rather than at
+     * the end of the file.
+     *
+     * @return True, if the last call of next() found a corrupt block.
+     */
+    bool error() const { return corrupt; }
+};
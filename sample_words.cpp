@@ -0,0 +1,71 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "embedded.h"
+#include "options.h"
+#include "sampling.h"
+
+using namespace std;
+
+/**
+ * Count the words of a given length accepted by an embedded automaton and
+ * write random samples of them, one per file, as inputs for benchmarks and
+ * stress tests.
+ *   sample_words [--near-miss] [--seed n] automaton length [count directory]
+ * With --near-miss the samples are rejected words one byte away from an
+ * accepted word. The files are named sample-0.txt, sample-1.txt, ... The
+ * length is at most 4096.
+ */
+int main(int argc, char* argv[]) {
+    bool nearMiss = false;
+    uint64_t seed = 1;
+    int argi = 1;
+    bool validOptions = true;
+    while(validOptions && argi < argc && string(argv[argi]).rfind("--", 0) == 0) {
+        string option(argv[argi]);
+        if(option == "--near-miss") {
+            nearMiss = true;
+            argi++;
+        } else if(option == "--seed" && argi + 1 < argc) {
+            validOptions = parseNumber(argv[argi + 1], 0, UINT64_MAX, seed);
+            argi += 2;
+        } else {
+            break;
+        }
+    }
+    // the counts of every length up to the given one are kept, and they grow with the length: it is bounded
+    uint64_t length = 0, samples = 0;
+    validOptions = validOptions && (argc - argi == 2 || argc - argi == 4) && parseNumber(argv[argi + 1], 0, 4096, length) &&
+                   (argc - argi == 2 || parseNumber(argv[argi + 2], 0, UINT32_MAX, samples));
+    if(!validOptions) {
+        cout << "Usage: sample_words [--near-miss] [--seed n] automaton length [count directory]" << endl;
+        return 1;
+    }
+    const DFATable *table = findEmbeddedDFA(argv[argi]);
+    if(table == nullptr) {
+        cout << "Unknown automaton " << argv[argi] << endl;
+        return 1;
+    }
+    WordSampler sampler(*table, length);
+    cout << "Accepted words of length " << length << ": " << sampler.count(length).toString() << endl;
+    if(argc - argi == 2) return 0;
+
+    string directory = argv[argi + 3];
+    mt19937_64 generator(seed);
+    string word;
+    for(uint64_t i = 0; i < samples; i++) {
+        bool found = nearMiss ? sampler.sampleNearMiss(length, generator, word) : sampler.sample(length, generator, word);
+        if(!found) {
+            cout << "No " << (nearMiss ? "near-miss" : "accepted") << " word of length " << length << endl;
+            return 1;
+        }
+        string fileName = directory + "/sample-" + to_string(i) + ".txt";
+        ofstream outputFile(fileName, ios::binary);
+        outputFile << word;
+        if(outputFile.fail()) {
+            cout << "Error while writing file " << fileName << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include "sampling.h"
+
+using namespace std;
+
+BigCount::BigCount(uint64_t value) {
+    for(; value != 0; value >>= 32) limbs.push_back((uint32_t) value);
+}
+
+void BigCount::trim() {
+    while(!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+}
+
+size_t BigCount::bitLength() const {
+    if(limbs.empty()) return 0;
+    return (limbs.size() - 1) * 32 + (32 - __builtin_clz(limbs.back()));
+}
+
+BigCount &BigCount::operator+=(const BigCount &other) {
+    if(limbs.size() < other.limbs.size()) limbs.resize(other.limbs.size(), 0);
+    uint64_t carry = 0;
+    for(size_t i = 0; i < limbs.size(); i++) {
+        uint64_t sum = carry + limbs[i] + (i < other.limbs.size() ? other.limbs[i] : 0);
+        limbs[i] = (uint32_t) sum;
+        carry = sum >> 32;
+    }
+    if(carry != 0) limbs.push_back((uint32_t) carry);
+    return *this;
+}
+
+BigCount &BigCount::operator-=(const BigCount &other) {
+    int64_t borrow = 0;
+    for(size_t i = 0; i < limbs.size(); i++) {
+        int64_t difference = (int64_t) limbs[i] - borrow - (i < other.limbs.size() ? other.limbs[i] : 0);
+        borrow = difference < 0 ? 1 : 0;
+        limbs[i] = (uint32_t) (difference + (borrow << 32));
+    }
+    trim();
+    return *this;
+}
+
+BigCount BigCount::operator*(uint32_t factor) const {
+    BigCount product;
+    uint64_t carry = 0;
+    for(uint32_t limb : limbs) {
+        uint64_t value = (uint64_t) limb * factor + carry;
+        product.limbs.push_back((uint32_t) value);
+        carry = value >> 32;
+    }
+    if(carry != 0) product.limbs.push_back((uint32_t) carry);
+    product.trim();
+    return product;
+}
+
+bool BigCount::operator<(const BigCount &other) const {
+    if(limbs.size() != other.limbs.size()) return limbs.size() < other.limbs.size();
+    return lexicographical_compare(limbs.rbegin(), limbs.rend(), other.limbs.rbegin(), other.limbs.rend());
+}
+
+/**
+ * Uniformly distributed number in [0, bound): random numbers with as many bits
+ * as the bound are drawn until one is smaller (less than two draws on average).
+ */
+BigCount BigCount::random(const BigCount &bound, mt19937_64 &generator) {
+    size_t bits = bound.bitLength();
+    BigCount value;
+    do {
+        value.limbs.assign((bits + 31) / 32, 0);
+        for(uint32_t &limb : value.limbs) limb = (uint32_t) generator();
+        if(bits % 32 != 0) value.limbs.back() &= (uint32_t(1) << (bits % 32)) - 1;
+        value.trim();
+    } while(!(value < bound));
+    return value;
+}
+
+string BigCount::toString() const {
+    if(limbs.empty()) return "0";
+    vector<uint32_t> quotient = limbs;
+    vector<uint32_t> groups;
+    //Repeated division by 10^9 gives nine decimal digits at a time, least significant first
+    while(!quotient.empty()) {
+        uint64_t remainder = 0;
+        for(size_t i = quotient.size(); i-- > 0;) {
+            uint64_t value = (remainder << 32) | quotient[i];
+            quotient[i] = (uint32_t) (value / 1000000000);
+            remainder = value % 1000000000;
+        }
+        groups.push_back((uint32_t) remainder);
+        while(!quotient.empty() && quotient.back() == 0) quotient.pop_back();
+    }
+    string digits = to_string(groups.back());
+    for(size_t i = groups.size() - 1; i-- > 0;) {
+        string group = to_string(groups[i]);
+        digits += string(9 - group.length(), '0') + group;
+    }
+    return digits;
+}
+
+/**
+ * Count the accepted words of every length up to maxLength: the words of
+ * length n from a state are the words of length n - 1 from each successor,
+ * once for every byte of the class that leads there.
+ *
+ * @param table
+ *            The automaton, which must outlive the sampler.
+ * @param maxLength
+ *            The longest words that will be counted or sampled.
+ */
+WordSampler::WordSampler(const DFATable &table, size_t maxLength) : table(table), counts(maxLength + 1) {
+    vector<uint32_t> classSize(table.numClasses, 0);
+    for(int letter = 0; letter < 256; letter++) classSize[table.classMap[letter]]++;
+    counts[0].resize(table.numStates);
+    for(int state = 0; state < table.numStates; state++) counts[0][state] = BigCount(table.isAccepting(state) ? 1 : 0);
+    for(size_t length = 1; length <= maxLength; length++) {
+        counts[length].resize(table.numStates);
+        for(int state = 0; state < table.numStates; state++) {
+            if(state == table.trapState) continue;
+            for(int letterClass = 0; letterClass < table.numClasses; letterClass++) {
+                const BigCount &suffixes = counts[length - 1][table.transitions[(size_t) state * table.numClasses + letterClass]];
+                if(!suffixes.isZero()) counts[length][state] += suffixes * classSize[letterClass];
+            }
+        }
+    }
+}
+
+/**
+ * Draw an accepted word of a given length uniformly at random: a random rank
+ * among the accepted words is chosen, and the bytes are chosen one at a time
+ * by skipping the words that continue with a smaller byte.
+ *
+ * @param length
+ *            A length up to maxLength.
+ * @param generator
+ *            The source of randomness.
+ * @param word
+ *            Receives the word.
+ * @return False, if no word of that length is accepted.
+ */
+bool WordSampler::sample(size_t length, mt19937_64 &generator, string &word) const {
+    if(count(length).isZero()) return false;
+    BigCount rank = BigCount::random(count(length), generator);
+    word.clear();
+    int state = table.startState;
+    for(size_t remaining = length; remaining > 0; remaining--) {
+        for(int letter = 0; letter < 256; letter++) {
+            int target = table.step(state, (unsigned char) letter);
+            const BigCount &words = counts[remaining - 1][target];
+            if(rank < words) {
+                word.push_back((char) letter);
+                state = target;
+                break;
+            }
+            rank -= words;
+        }
+    }
+    return true;
+}
+
+/**
+ * Draw a rejected word of a given length that differs from an accepted word
+ * in a single byte: accepted words are drawn and one random byte is replaced
+ * until the result is rejected, up to a fixed number of attempts.
+ *
+ * @param length
+ *            A length up to maxLength.
+ * @param generator
+ *            The source of randomness.
+ * @param word
+ *            Receives the word.
+ * @return False, if no such word was found.
+ */
+bool WordSampler::sampleNearMiss(size_t length, mt19937_64 &generator, string &word) const {
+    if(length == 0) return false;
+    for(int attempt = 0; attempt < 256; attempt++) {
+        if(!sample(length, generator, word)) return false;
+        size_t position = generator() % length;
+        char replacement = (char) (generator() % 256);
+        if(replacement == word[position]) continue;
+        word[position] = replacement;
+        if(!table.run(word)) return true;
+    }
+    return false;
+}
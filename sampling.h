@@ -0,0 +1,114 @@
+#pragma once
+
+#include<cstdint>
+#include<random>
+#include<string>
+#include<vector>
+#include "compiled.h"
+
+using namespace std;
+
+/**
+ * Non-negative integer of arbitrary size, enough for counting the words of an
+ * automaton: the number of words of length n grows like 256^n.
+ */
+class BigCount {
+    /**
+     * @brief limbs represents the digits in base 2^32, least significant first, without leading zeros
+     */
+    vector<uint32_t> limbs;
+
+    void trim();
+public:
+    BigCount(uint64_t value = 0);
+
+    bool isZero() const { return limbs.empty(); }
+
+    /**
+     * Number of bits needed to write the number.
+     */
+    size_t bitLength() const;
+
+    BigCount &operator+=(const BigCount &other);
+
+    /**
+     * Subtract a number that is not larger than this one.
+     */
+    BigCount &operator-=(const BigCount &other);
+
+    BigCount operator*(uint32_t factor) const;
+
+    bool operator<(const BigCount &other) const;
+
+    /**
+     * Uniformly distributed number in [0, bound), for bound > 0.
+     */
+    static BigCount random(const BigCount &bound, mt19937_64 &generator);
+
+    /**
+     * Decimal representation.
+     */
+    string toString() const;
+};
+
+/**
+ * Counts the words of every length accepted by a compiled DFA, by dynamic
+ * programming over the lengths, and draws accepted words of a given length
+ * uniformly at random. Every state keeps the number of accepted words of each
+ * length that start from it, so a random word is built one byte at a time,
+ * each byte chosen with a probability proportional to the number of
+ * accepted completions.
+ */
+class WordSampler {
+    DFATable table;
+    /**
+     * @brief counts represents, for every length up to the maximum, the accepted words of that length from every state
+     */
+    vector<vector<BigCount>> counts;
+public:
+    /**
+     * Count the accepted words of every length up to maxLength.
+     *
+     * @param table
+     *            The automaton, which must outlive the sampler.
+     * @param maxLength
+     *            The longest words that will be counted or sampled.
+     */
+    WordSampler(const DFATable &table, size_t maxLength);
+
+    /**
+     * Number of accepted words of a given length.
+     *
+     * @param length
+     *            A length up to maxLength.
+     * @return The number of words.
+     */
+    const BigCount &count(size_t length) const { return counts[length][table.startState]; }
+
+    /**
+     * Draw an accepted word of a given length uniformly at random.
+     *
+     * @param length
+     *            A length up to maxLength.
+     * @param generator
+     *            The source of randomness.
+     * @param word
+     *            Receives the word.
+     * @return False, if no word of that length is accepted.
+     */
+    bool sample(size_t length, mt19937_64 &generator, string &word) const;
+
+    /**
+     * Draw a rejected word of a given length that differs from an accepted
+     * word in a single byte, to exercise the paths that almost accept.
+     *
+     * @param length
+     *            A length up to maxLength.
+     * @param generator
+     *            The source of randomness.
+     * @param word
+     *            Receives the word.
+     * @return False, if no such word was found.
+     */
+    bool sampleNearMiss(size_t length, mt19937_64 &generator, string &word) const;
+};
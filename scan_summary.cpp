@@ -0,0 +1,105 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "embedded.h"
+#include "options.h"
+#include "summary.h"
+
+using namespace std;
+
+/**
+ * @brief readBlock represents the number of bytes read and summarized at a time
+ */
+const size_t readBlock = 1 << 20;
+
+/**
+ * Produce, merge and read summaries of chunks of an input scanned with an
+ * embedded automaton, so that a large input can be split across machines and
+ * the results combined exactly.
+ *   scan_summary summarize automaton inputfile summaryfile [offset length]
+ *   scan_summary merge summaryfile... outputfile
+ *   scan_summary report automaton summaryfile
+ * The chunk is the whole input file, or length bytes from offset. The
+ * summaries given to merge must be of adjacent chunks, in input order; the
+ * report prints the verdict and the number of matches of the merged input.
+ */
+int main(int argc, char* argv[]) {
+    string command = argc > 1 ? argv[1] : "";
+    // the whole input file, unless a chunk is given
+    uint64_t offset = 0, remaining = UINT64_MAX;
+    if(command == "summarize" && (argc == 5 || (argc == 7 && parseNumber(argv[5], 0, INT64_MAX, offset) &&
+                                                parseNumber(argv[6], 0, UINT64_MAX, remaining)))) {
+        const DFATable *table = findEmbeddedDFA(argv[2]);
+        if(table == nullptr) {
+            cout << "Unknown automaton " << argv[2] << endl;
+            return 1;
+        }
+        ifstream inputFile(argv[3], ios::binary);
+        inputFile.seekg((streamoff) offset);
+        if(inputFile.fail()) {
+            cout << "Error while reading file " << argv[3] << endl;
+            return 1;
+        }
+        // the chunk is read one block at a time and the blocks are merged, so it never has to fit in memory
+        ScanSummary summary(*table);
+        string block(readBlock, '\0');
+        while(remaining > 0 && inputFile) {
+            inputFile.read(block.data(), (streamsize) min<uint64_t>(remaining, readBlock));
+            size_t read = (size_t) inputFile.gcount();
+            summary.append(ScanSummary::summarize(*table, string_view(block.data(), read)));
+            remaining -= read;
+        }
+        if(argc == 7 && remaining > 0) {
+            cout << "File too short: " << argv[3] << endl;
+            return 1;
+        }
+        if(!summary.save(argv[4])) {
+            cout << "Error while writing file " << argv[4] << endl;
+            return 1;
+        }
+        return 0;
+    }
+    if(command == "merge" && argc >= 4) {
+        ScanSummary merged;
+        for(int i = 2; i < argc - 1; i++) {
+            ScanSummary next;
+            if(!next.load(argv[i])) {
+                cout << "Invalid summary file " << argv[i] << endl;
+                return 1;
+            }
+            if(i == 2) {
+                merged = move(next);
+            } else if(!merged.append(next)) {
+                cout << "Summary of a different automaton: " << argv[i] << endl;
+                return 1;
+            }
+        }
+        if(!merged.save(argv[argc - 1])) {
+            cout << "Error while writing file " << argv[argc - 1] << endl;
+            return 1;
+        }
+        return 0;
+    }
+    if(command == "report" && argc == 4) {
+        const DFATable *table = findEmbeddedDFA(argv[2]);
+        if(table == nullptr) {
+            cout << "Unknown automaton " << argv[2] << endl;
+            return 1;
+        }
+        ScanSummary summary;
+        if(!summary.load(argv[3])) {
+            cout << "Invalid summary file " << argv[3] << endl;
+            return 1;
+        }
+        if(!summary.isOf(*table)) {
+            cout << "Summary of a different automaton: " << argv[3] << endl;
+            return 1;
+        }
+        cout << "Bytes: " << summary.bytes() << endl;
+        cout << "Accepted: " << summary.accepted(*table) << endl;
+        cout << "Matches: " << summary.matchCount(*table) << endl;
+        return 0;
+    }
+    cout << "Usage: scan_summary summarize automaton inputfile summaryfile [offset length] | scan_summary merge summaryfile... outputfile | scan_summary report automaton summaryfile" << endl;
+    return 1;
+}
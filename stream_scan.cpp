@@ -0,0 +1,96 @@
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include "checkpoint.h"
+#include "embedded.h"
+#include "options.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief stopRequested represents whether SIGTERM or SIGINT has been received
+ */
+atomic<bool> stopRequested(false);
+
+void requestStop(int) {
+    stopRequested.store(true);
+}
+
+}
+
+/**
+ * Scan a very large file with embedded automata in one streaming pass and
+ * print, for each, the verdict and the number of accepted prefixes.
+ *   stream_scan [--checkpoint file [--interval bytes] [--resume]] inputfile automaton...
+ * With --checkpoint the progress is saved every interval bytes (1 GiB by
+ * default) and when the scan is interrupted by SIGTERM or SIGINT; --resume
+ * continues from the saved progress instead of from the first byte. The
+ * checkpoint file is removed when the scan completes.
+ */
+int main(int argc, char* argv[]) {
+    string checkpointPath;
+    uint64_t interval = uint64_t(1) << 30;
+    bool resume = false;
+    int argi = 1;
+    bool validOptions = true;
+    while(validOptions && argi < argc && string(argv[argi]).rfind("--", 0) == 0) {
+        string option(argv[argi]);
+        if(option == "--checkpoint" && argi + 1 < argc) {
+            checkpointPath = argv[argi + 1];
+            argi += 2;
+        } else if(option == "--interval" && argi + 1 < argc) {
+            validOptions = parseNumber(argv[argi + 1], 1, UINT64_MAX, interval);
+            argi += 2;
+        } else if(option == "--resume") {
+            resume = true;
+            argi++;
+        } else {
+            break;
+        }
+    }
+    if(!validOptions || argc - argi < 2 || (resume && checkpointPath.empty())) {
+        cout << "Usage: stream_scan [--checkpoint file [--interval bytes] [--resume]] inputfile automaton..." << endl;
+        return 1;
+    }
+    string fileName = argv[argi];
+    vector<DFATable> tables;
+    for(int i = argi + 1; i < argc; i++) {
+        const DFATable *table = findEmbeddedDFA(argv[i]);
+        if(table == nullptr) {
+            cout << "Unknown automaton " << argv[i] << endl;
+            return 1;
+        }
+        tables.push_back(*table);
+    }
+
+    ScanCheckpoint progress;
+    if(resume) {
+        if(!progress.load(checkpointPath) || !progress.belongsTo(tables, fileName)) {
+            cout << "Invalid checkpoint " << checkpointPath << " for " << fileName << endl;
+            return 1;
+        }
+        cout << "Resuming at byte " << progress.offset << endl;
+    } else if(!progress.start(tables, fileName)) {
+        cout << "Error while reading file " << fileName << endl;
+        return 1;
+    }
+    signal(SIGTERM, requestStop);
+    signal(SIGINT, requestStop);
+    if(!streamScan(tables, progress, checkpointPath, interval, &stopRequested)) {
+        cout << "Error while scanning file " << fileName << endl;
+        return 1;
+    }
+    if(stopRequested.load()) {
+        cout << "Stopped at byte " << progress.offset << (checkpointPath.empty() ? "" : ", resume with --resume") << endl;
+        return 1;
+    }
+    if(!checkpointPath.empty()) remove(checkpointPath.c_str());
+    cout << "Bytes: " << progress.offset << endl;
+    for(size_t i = 0; i < tables.size(); i++) {
+        cout << argv[argi + 1 + i] << ": " << tables[i].isAccepting(progress.states[i]) << " (matches: " << progress.matches[i] << ")" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,225 @@
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "subset.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * A set of NFA states as the sorted list of their numbers: the canonical key
+ * of a DFA state, smaller than a bit vector when the NFA is large.
+ */
+typedef vector<uint32_t> StateList;
+
+/**
+ * The important states of a set, the key of its DFA state.
+ *
+ * @param states
+ *            Receives the sorted list of the states of the set that are important.
+ */
+void importantStates(const NFA &nfa, const NFA::StateSet &set, StateList &states) {
+    states.clear();
+    for(size_t word = 0; word < set.size(); word++) {
+        for(uint64_t bits = set[word]; bits != 0; bits &= bits - 1) {
+            uint32_t state = (uint32_t) (word * 64 + __builtin_ctzll(bits));
+            if(nfa.isImportant((int) state)) states.push_back(state);
+        }
+    }
+}
+
+/**
+ * A DFA state: its important NFA states and, once processed, its transitions.
+ * The other states of the set are not needed to step or to accept.
+ * Entries never move, so workers can keep pointers to them.
+ */
+struct Entry {
+    StateList states;
+    vector<int> row;
+    bool accepting = false;
+};
+
+struct ListHash {
+    size_t operator()(const StateList *states) const {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for(uint32_t state : *states) hash = (hash ^ state) * 0x100000001b3ULL;
+        return (size_t) (hash ^ (hash >> 29));
+    }
+};
+
+struct ListEqual {
+    bool operator()(const StateList *a, const StateList *b) const { return *a == *b; }
+};
+
+const int shardBits = 6;
+const int shardCount = 1 << shardBits;
+
+/**
+ * Shared state of the workers of the parallel subset construction. A state
+ * is numbered (index in its shard << shardBits) | shard.
+ */
+class SubsetBuilder {
+    struct Shard {
+        mutex lock;
+        unordered_map<const StateList *, int, ListHash, ListEqual> index;
+        vector<unique_ptr<Entry>> entries;
+    };
+
+    struct Queue {
+        mutex lock;
+        deque<Entry *> work;
+    };
+
+    const NFA &nfa;
+    size_t maxStates;
+    Shard shards[shardCount];
+    vector<unique_ptr<Queue>> queues;
+    vector<unsigned char> representative;
+    atomic<size_t> stateCount{0};
+    // states added but not processed yet: the construction is over when no state is pending
+    atomic<size_t> pending{0};
+    atomic<bool> overflow{false};
+
+public:
+    SubsetBuilder(const NFA &nfa, unsigned threads, size_t maxStates) : nfa(nfa), maxStates(maxStates) {
+        for(unsigned i = 0; i < threads; i++) queues.push_back(make_unique<Queue>());
+        //Any byte of a class stands for the whole class
+        representative.assign(nfa.classCount(), 0);
+        for(int letter = 255; letter >= 0; letter--) representative[nfa.byteClasses()[letter]] = (unsigned char) letter;
+    }
+
+    bool overflowed() const { return overflow; }
+
+    Entry *entry(int id) { return shards[id & (shardCount - 1)].entries[id >> shardBits].get(); }
+
+    /**
+     * Find a set of states, or add it and queue it on the worker's queue.
+     *
+     * @return The number of the state, or -1 if there are too many states.
+     */
+    int intern(StateList &states, unsigned worker) {
+        size_t hash = ListHash()(&states);
+        Shard &shard = shards[(hash >> 7) & (shardCount - 1)];
+        Entry *added;
+        int id;
+        {
+            lock_guard<mutex> guard(shard.lock);
+            auto found = shard.index.find(&states);
+            if(found != shard.index.end()) return found->second;
+            if(stateCount++ >= maxStates) {
+                overflow = true;
+                return -1;
+            }
+            id = (int) ((shard.entries.size() << shardBits) | (size_t) (&shard - shards));
+            shard.entries.push_back(make_unique<Entry>());
+            added = shard.entries.back().get();
+            added->states.swap(states);
+            shard.index.insert(pair<const StateList *, int>(&added->states, id));
+        }
+        pending++;
+        lock_guard<mutex> guard(queues[worker]->lock);
+        queues[worker]->work.push_back(added);
+        return id;
+    }
+
+    /**
+     * Next state to process: the newest one of the worker, or the oldest one of another worker.
+     */
+    Entry *take(unsigned worker) {
+        for(size_t i = 0; i < queues.size(); i++) {
+            Queue &queue = *queues[(worker + i) % queues.size()];
+            lock_guard<mutex> guard(queue.lock);
+            if(queue.work.empty()) continue;
+            Entry *next;
+            if(i == 0) {
+                next = queue.work.back();
+                queue.work.pop_back();
+            } else {
+                next = queue.work.front();
+                queue.work.pop_front();
+            }
+            return next;
+        }
+        return nullptr;
+    }
+
+    void work(unsigned worker) {
+        NFA::StateSet from(nfa.setWords(), 0), to;
+        StateList states;
+        while(!overflow) {
+            Entry *current = take(worker);
+            if(current == nullptr) {
+                if(pending == 0) return;
+                this_thread::yield();
+                continue;
+            }
+            for(uint32_t state : current->states) from[state / 64] |= uint64_t(1) << (state % 64);
+            current->accepting = nfa.isAccepting(from);
+            current->row.resize(nfa.classCount());
+            for(int letterClass = 0; letterClass < nfa.classCount(); letterClass++) {
+                nfa.step(from, representative[letterClass], to);
+                importantStates(nfa, to, states);
+                current->row[letterClass] = intern(states, worker);
+            }
+            for(uint32_t state : current->states) from[state / 64] = 0;
+            //Only now, after its successors have been queued
+            pending--;
+        }
+    }
+};
+
+}
+
+/**
+ * Determinize an NFA with the subset construction, on several threads.
+ *
+ * @param nfa
+ *            A finalized NFA.
+ * @param threads
+ *            Number of worker threads, or 0 for one per hardware thread.
+ * @param maxStates
+ *            Largest number of DFA states built before giving up.
+ * @return The compiled DFA, or nullptr if it would have more than maxStates states.
+ */
+unique_ptr<CompiledDFA> determinize(const NFA &nfa, unsigned threads, size_t maxStates) {
+    if(threads == 0) threads = max(1u, thread::hardware_concurrency());
+    SubsetBuilder builder(nfa, threads, maxStates);
+    NFA::StateSet startSet = nfa.startSet();
+    StateList start;
+    importantStates(nfa, startSet, start);
+    int startId = builder.intern(start, 0);
+    vector<thread> workers;
+    for(unsigned worker = 1; worker < threads; worker++) {
+        workers.emplace_back(&SubsetBuilder::work, &builder, worker);
+    }
+    builder.work(0);
+    for(thread &worker : workers) worker.join();
+    if(builder.overflowed()) return nullptr;
+
+    //Breadth-first renumbering from the initial state
+    int classes = nfa.classCount();
+    unordered_map<int, int> number;
+    vector<Entry *> order;
+    number.insert(pair<int, int>(startId, 0));
+    order.push_back(builder.entry(startId));
+    for(size_t i = 0; i < order.size(); i++) {
+        for(int target : order[i]->row) {
+            if(number.insert(pair<int, int>(target, (int) order.size())).second) order.push_back(builder.entry(target));
+        }
+    }
+    vector<int> transitions((size_t) order.size() * classes);
+    vector<unsigned char> accepting(order.size());
+    int trapState = -1;
+    for(size_t state = 0; state < order.size(); state++) {
+        for(int letterClass = 0; letterClass < classes; letterClass++) {
+            transitions[state * classes + letterClass] = number[order[state]->row[letterClass]];
+        }
+        accepting[state] = order[state]->accepting;
+        if(order[state]->states.empty()) trapState = (int) state;
+    }
+    DFATable table{(int) order.size(), classes, 0, trapState, nfa.byteClasses().data(), transitions.data(), accepting.data()};
+    return make_unique<CompiledDFA>(table);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include<cstddef>
+#include<memory>
+#include "compiled.h"
+#include "nfa.h"
+
+using namespace std;
+
+/**
+ * Determinize an NFA with the subset construction, on several threads.
+ *
+ * Every DFA state is a set of NFA states, keyed by its important states
+ * only (those with a transition on a byte, and the final ones): sets that
+ * differ in states that only have epsilon transitions step and accept alike,
+ * so they are the same DFA state. The key is stored once as a sorted list of
+ * state numbers (hash-consing) in a hash map split into shards, each with its
+ * own lock. Every thread owns a queue of states whose transitions are still
+ * to be computed: it works on its newest states and, when its queue is empty,
+ * steals the oldest states of the other threads. At the end the states are
+ * renumbered in breadth-first order from the initial state, so the table is
+ * the same whatever the number of threads and the interleaving.
+ *
+ * The set without important states (the empty set among them), if
+ * reachable, becomes the trap state.
+ *
+ * @param nfa
+ *            A finalized NFA.
+ * @param threads
+ *            Number of worker threads, or 0 for one per hardware thread.
+ * @param maxStates
+ *            Largest number of DFA states built before giving up.
+ * @return The compiled DFA, or nullptr if it would have more than maxStates states.
+ */
+unique_ptr<CompiledDFA> determinize(const NFA &nfa, unsigned threads = 0, size_t maxStates = 1 << 20);
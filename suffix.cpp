@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "suffix.h"
+
+using namespace std;
+
+namespace {
+
+const char indexMagic[8] = {'L', 'S', 'U', 'F', 'A', 'U', 'T', '1'};
+
+/**
+ * Fixed-size header of an index file. The arrays follow, each one starting at
+ * a multiple of 8 bytes: edgeStart, edgeTargets, occurrences, edgeLetters.
+ */
+struct IndexHeader {
+    char magic[8];
+    uint32_t numStates;
+    uint32_t reserved;
+    uint64_t numEdges;
+    uint64_t length;
+};
+
+size_t align8(size_t offset) { return (offset + 7) & ~size_t(7); }
+
+/**
+ * Offsets of the arrays of an index file.
+ */
+struct IndexLayout {
+    size_t edgeStart, edgeTargets, occurrences, edgeLetters, total;
+
+    IndexLayout(uint32_t numStates, uint64_t numEdges) {
+        edgeStart = align8(sizeof(IndexHeader));
+        edgeTargets = align8(edgeStart + (size_t(numStates) + 1) * sizeof(uint32_t));
+        occurrences = align8(edgeTargets + numEdges * sizeof(uint32_t));
+        edgeLetters = align8(occurrences + size_t(numStates) * sizeof(uint32_t));
+        total = edgeLetters + numEdges;
+    }
+};
+
+/**
+ * State of the automaton while it is being built; the edges are kept as a
+ * small unsorted list because most states have very few of them.
+ */
+struct BuildState {
+    uint32_t len;
+    int64_t link;
+    bool clone;
+    vector<pair<unsigned char, uint32_t>> next;
+
+    pair<unsigned char, uint32_t> *find(unsigned char letter) {
+        for(auto &edge : next) {
+            if(edge.first == letter) return &edge;
+        }
+        return nullptr;
+    }
+};
+
+}
+
+SuffixAutomaton::SuffixAutomaton() : numStates(0), numEdges(0), length(0), edgeStart(nullptr), edgeLetters(nullptr),
+                                     edgeTargets(nullptr), occurrences(nullptr), mapping(nullptr), mappingSize(0) {}
+
+SuffixAutomaton::~SuffixAutomaton() { clear(); }
+
+/**
+ * Release the storage of the current index.
+ */
+void SuffixAutomaton::clear() {
+    if(mapping != nullptr) munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+    ownedEdgeStart.clear();
+    ownedEdgeLetters.clear();
+    ownedEdgeTargets.clear();
+    ownedOccurrences.clear();
+    numStates = 0;
+    numEdges = 0;
+    length = 0;
+    edgeStart = nullptr;
+    edgeLetters = nullptr;
+    edgeTargets = nullptr;
+    occurrences = nullptr;
+}
+
+/**
+ * Build the automaton of a text with the online construction of Blumer et al.
+ *
+ * @param text
+ *            The text to index.
+ * @return False, if the text is longer than maxTextLength.
+ */
+bool SuffixAutomaton::build(const string &text) {
+    if(text.length() > maxTextLength) return false;
+    clear();
+    vector<BuildState> states;
+    states.reserve(2 * text.length() + 1);
+    states.push_back(BuildState{0, -1, false, {}});
+    uint32_t last = 0;
+    for(unsigned char letter : text) {
+        //The new state stands for the whole prefix read so far
+        uint32_t cur = (uint32_t) states.size();
+        states.push_back(BuildState{states[last].len + 1, 0, false, {}});
+        int64_t p = last;
+        while(p != -1 && states[p].find(letter) == nullptr) {
+            states[p].next.push_back(pair<unsigned char, uint32_t>(letter, cur));
+            p = states[p].link;
+        }
+        if(p != -1) {
+            uint32_t q = states[p].find(letter)->second;
+            if(states[p].len + 1 == states[q].len) {
+                states[cur].link = q;
+            } else {
+                //q also stands for longer words, so the words of length len(p)+1 are split into a clone
+                uint32_t clone = (uint32_t) states.size();
+                BuildState copy = states[q];
+                copy.len = states[p].len + 1;
+                copy.clone = true;
+                states.push_back(std::move(copy));
+                while(p != -1) {
+                    pair<unsigned char, uint32_t> *edge = states[p].find(letter);
+                    if(edge == nullptr || edge->second != q) break;
+                    edge->second = clone;
+                    p = states[p].link;
+                }
+                states[q].link = clone;
+                states[cur].link = clone;
+            }
+        }
+        last = cur;
+    }
+
+    numStates = (uint32_t) states.size();
+    length = text.length();
+    //Every non-cloned state ends exactly one prefix; the counts are summed up along the suffix links,
+    //from the longest states to the shortest ones (counting sort on len)
+    ownedOccurrences.assign(numStates, 0);
+    vector<uint32_t> byLength(length + 2, 0), order(numStates);
+    for(uint32_t s = 0; s < numStates; s++) {
+        if(s != initialState && !states[s].clone) ownedOccurrences[s] = 1;
+        byLength[states[s].len + 1]++;
+    }
+    for(size_t l = 1; l < byLength.size(); l++) byLength[l] += byLength[l - 1];
+    for(uint32_t s = 0; s < numStates; s++) order[byLength[states[s].len]++] = s;
+    for(uint32_t i = numStates; i-- > 1;) {
+        uint32_t s = order[i];
+        ownedOccurrences[states[s].link] += ownedOccurrences[s];
+    }
+    ownedOccurrences[initialState] = (uint32_t)(length + 1);
+
+    //The edges of every state are sorted by letter and packed one state after the other
+    ownedEdgeStart.assign(size_t(numStates) + 1, 0);
+    for(uint32_t s = 0; s < numStates; s++) {
+        ownedEdgeStart[s + 1] = ownedEdgeStart[s] + (uint32_t) states[s].next.size();
+    }
+    numEdges = ownedEdgeStart[numStates];
+    ownedEdgeLetters.resize(numEdges);
+    ownedEdgeTargets.resize(numEdges);
+    for(uint32_t s = 0; s < numStates; s++) {
+        vector<pair<unsigned char, uint32_t>> &next = states[s].next;
+        sort(next.begin(), next.end());
+        for(size_t e = 0; e < next.size(); e++) {
+            ownedEdgeLetters[ownedEdgeStart[s] + e] = next[e].first;
+            ownedEdgeTargets[ownedEdgeStart[s] + e] = next[e].second;
+        }
+        vector<pair<unsigned char, uint32_t>>().swap(next);
+    }
+    edgeStart = ownedEdgeStart.data();
+    edgeLetters = ownedEdgeLetters.data();
+    edgeTargets = ownedEdgeTargets.data();
+    occurrences = ownedOccurrences.data();
+    return true;
+}
+
+/**
+ * Write the index to a file that can be mapped by open().
+ *
+ * @param path
+ *            Destination file.
+ * @return True, if the file has been written.
+ */
+bool SuffixAutomaton::save(const string &path) const {
+    if(edgeStart == nullptr) return false;
+    IndexLayout layout(numStates, numEdges);
+    IndexHeader header;
+    memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.numStates = numStates;
+    header.reserved = 0;
+    header.numEdges = numEdges;
+    header.length = length;
+    ofstream out(path, ios::binary);
+    if(out.fail()) return false;
+    //Zero bytes are written between the arrays to keep every offset aligned
+    auto writeAt = [&out](size_t offset, const void *data, size_t size) {
+        static const char padding[8] = {0};
+        out.write(padding, (streamsize)(offset - (size_t) out.tellp()));
+        out.write((const char *) data, (streamsize) size);
+    };
+    out.write((const char *) &header, sizeof(header));
+    writeAt(layout.edgeStart, edgeStart, (size_t(numStates) + 1) * sizeof(uint32_t));
+    writeAt(layout.edgeTargets, edgeTargets, numEdges * sizeof(uint32_t));
+    writeAt(layout.occurrences, occurrences, size_t(numStates) * sizeof(uint32_t));
+    writeAt(layout.edgeLetters, edgeLetters, numEdges);
+    return !out.fail();
+}
+
+/**
+ * Map an index written by save(). The sizes in the header and the edge arrays
+ * are checked, so that a corrupt or hostile file is rejected instead of
+ * being read out of bounds.
+ *
+ * @param path
+ *            The index file.
+ * @return True, if the file is a valid index.
+ */
+bool SuffixAutomaton::open(const string &path) {
+    clear();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat info;
+    void *data = MAP_FAILED;
+    if(fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(IndexHeader)) {
+        data = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if(data == MAP_FAILED) return false;
+    mapping = data;
+    mappingSize = (size_t) info.st_size;
+
+    //The sizes are bounded by the file before the layout multiplies them, so that a crafted header cannot overflow
+    const IndexHeader *header = (const IndexHeader *) data;
+    if(memcmp(header->magic, indexMagic, sizeof(indexMagic)) != 0 || header->numStates == 0 ||
+       header->numStates > mappingSize / sizeof(uint32_t) || header->numEdges > mappingSize || header->length > maxTextLength) {
+        clear();
+        return false;
+    }
+    IndexLayout layout(header->numStates, header->numEdges);
+    if(layout.total > mappingSize) {
+        clear();
+        return false;
+    }
+    const char *base = (const char *) data;
+    numStates = header->numStates;
+    numEdges = header->numEdges;
+    length = header->length;
+    edgeStart = (const uint32_t *)(base + layout.edgeStart);
+    edgeTargets = (const uint32_t *)(base + layout.edgeTargets);
+    occurrences = (const uint32_t *)(base + layout.occurrences);
+    edgeLetters = (const unsigned char *)(base + layout.edgeLetters);
+    //step() reads the edges of a state between edgeStart[state] and edgeStart[state + 1] and follows their targets
+    bool valid = edgeStart[0] == 0 && edgeStart[numStates] == numEdges && is_sorted(edgeStart, edgeStart + numStates + 1);
+    for(uint32_t s = 0; valid && s < numStates; s++) {
+        for(uint32_t e = edgeStart[s]; valid && e < edgeStart[s + 1]; e++) {
+            valid = edgeTargets[e] < numStates && (e == edgeStart[s] || edgeLetters[e - 1] < edgeLetters[e]);
+        }
+    }
+    if(!valid) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Successor of a state for a given letter.
+ *
+ * @param state
+ *            The current state, or trapState.
+ * @param letter
+ *            The current input.
+ * @return The next state, or trapState if there is no edge.
+ */
+uint32_t SuffixAutomaton::step(uint32_t state, unsigned char letter) const {
+    if(state == trapState || state >= numStates) return trapState;
+    const unsigned char *first = edgeLetters + edgeStart[state];
+    const unsigned char *last = edgeLetters + edgeStart[state + 1];
+    const unsigned char *edge = lower_bound(first, last, letter);
+    if(edge == last || *edge != letter) return trapState;
+    return edgeTargets[edge - edgeLetters];
+}
+
+/**
+ * Check if the pattern occurs in the text.
+ *
+ * @param pattern
+ *            The substring to look for.
+ * @return True, if the pattern is a substring of the text.
+ */
+bool SuffixAutomaton::contains(const string &pattern) const {
+    return countOccurrences(pattern) > 0;
+}
+
+/**
+ * Number of (possibly overlapping) occurrences of the pattern in the text.
+ *
+ * @param pattern
+ *            The substring to look for.
+ * @return The number of occurrences.
+ */
+uint64_t SuffixAutomaton::countOccurrences(const string &pattern) const {
+    if(numStates == 0) return 0;
+    uint32_t state = initialState;
+    for(unsigned char letter : pattern) {
+        state = step(state, letter);
+        if(state == trapState) return 0;
+    }
+    return occurrences[state];
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include<cstdint>
+#include<string>
+#include<vector>
+
+using namespace std;
+
+/**
+ * Suffix automaton of a text: the minimal DFA recognizing every substring of
+ * the text. Once built, "does this substring occur?" and "how many times?"
+ * are answered in O(pattern length), independently of the size of the text.
+ *
+ * The edges are stored in compact form (CSR: for every state a sorted run of
+ * letters and targets), and the whole index can be saved to a file and mapped
+ * back with mmap, so a large index is loaded without parsing or copying.
+ * Texts up to 1 GiB are supported.
+ */
+class SuffixAutomaton {
+public:
+    /**
+     * @brief initialState represents the state reached by the empty word
+     */
+    static const uint32_t initialState = 0;
+    /**
+     * @brief trapState represents the state reached by a word that is not a substring
+     */
+    static const uint32_t trapState = 0xffffffffu;
+    /**
+     * @brief maxTextLength represents the length of the longest text that can be indexed
+     */
+    static const uint64_t maxTextLength = uint64_t(1) << 30;
+
+    SuffixAutomaton();
+    ~SuffixAutomaton();
+
+    SuffixAutomaton(const SuffixAutomaton &) = delete;
+    SuffixAutomaton &operator=(const SuffixAutomaton &) = delete;
+
+    /**
+     * Build the automaton of a text with the online construction of Blumer et
+     * al., in linear time. Any previous content is discarded.
+     *
+     * @param text
+     *            The text to index.
+     * @return False, if the text is longer than maxTextLength.
+     */
+    bool build(const string &text);
+
+    /**
+     * Write the index to a file that can be mapped by open().
+     *
+     * @param path
+     *            Destination file.
+     * @return True, if the file has been written.
+     */
+    bool save(const string &path) const;
+
+    /**
+     * Map an index written by save(). The file stays mapped until the object
+     * is destroyed or another index is built or opened.
+     *
+     * @param path
+     *            The index file.
+     * @return True, if the file is a valid index.
+     */
+    bool open(const string &path);
+
+    /**
+     * Successor of a state for a given letter (binary search among the edges
+     * of the state).
+     *
+     * @param state
+     *            The current state, or trapState.
+     * @param letter
+     *            The current input.
+     * @return The next state, or trapState if there is no edge.
+     */
+    uint32_t step(uint32_t state, unsigned char letter) const;
+
+    /**
+     * Check if the pattern occurs in the text.
+     *
+     * @param pattern
+     *            The substring to look for.
+     * @return True, if the pattern is a substring of the text.
+     */
+    bool contains(const string &pattern) const;
+
+    /**
+     * Number of (possibly overlapping) occurrences of the pattern in the text.
+     * The empty pattern occurs at every position, i.e. length + 1 times.
+     *
+     * @param pattern
+     *            The substring to look for.
+     * @return The number of occurrences.
+     */
+    uint64_t countOccurrences(const string &pattern) const;
+
+    /**
+     * Number of states of the automaton.
+     *
+     * @return At most 2 * length of the text.
+     */
+    uint32_t stateCount() const { return numStates; }
+
+    /**
+     * Number of edges of the automaton.
+     *
+     * @return At most 3 * length of the text.
+     */
+    uint64_t edgeCount() const { return numEdges; }
+
+    /**
+     * Length of the indexed text.
+     *
+     * @return The number of bytes of the text.
+     */
+    uint64_t textLength() const { return length; }
+
+private:
+    void clear();
+
+    uint32_t numStates;
+    uint64_t numEdges;
+    uint64_t length;
+    /**
+     * @brief edgeStart represents, for every state, the index of its first edge (numStates + 1 entries)
+     */
+    const uint32_t *edgeStart;
+    /**
+     * @brief edgeLetters represents the letter of every edge, sorted within a state
+     */
+    const unsigned char *edgeLetters;
+    /**
+     * @brief edgeTargets represents the target state of every edge
+     */
+    const uint32_t *edgeTargets;
+    /**
+     * @brief occurrences represents, for every state, how many times its words occur in the text
+     */
+    const uint32_t *occurrences;
+
+    //Storage of a built index
+    vector<uint32_t> ownedEdgeStart;
+    vector<unsigned char> ownedEdgeLetters;
+    vector<uint32_t> ownedEdgeTargets;
+    vector<uint32_t> ownedOccurrences;
+    //Storage of a mapped index
+    void *mapping;
+    size_t mappingSize;
+};
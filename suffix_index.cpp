@@ -0,0 +1,56 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "suffix.h"
+
+using namespace std;
+
+/**
+ * Build a substring index of a text, or query an existing one.
+ *   suffix_index build textfile indexfile
+ *   suffix_index query indexfile [pattern...]
+ * Without patterns on the command line, the query reads one pattern per line
+ * from the standard input. For every pattern the number of occurrences is printed.
+ */
+int main(int argc, char* argv[]) {
+    string command = argc > 1 ? argv[1] : "";
+    if(command == "build" && argc == 4) {
+        ifstream inputFile(argv[2], ios::binary);
+        if(inputFile.fail()){
+            cout << "Error while reading file " << argv[2] << endl;
+            return 1;
+        }
+        string text((istreambuf_iterator<char>(inputFile)), (istreambuf_iterator<char>()));
+        SuffixAutomaton index;
+        if(!index.build(text)){
+            cout << "Text too long: " << argv[2] << endl;
+            return 1;
+        }
+        if(!index.save(argv[3])){
+            cout << "Error while writing file " << argv[3] << endl;
+            return 1;
+        }
+        cout << "States: " << index.stateCount() << ", edges: " << index.edgeCount() << endl;
+        return 0;
+    }
+    if(command == "query" && argc >= 3) {
+        SuffixAutomaton index;
+        if(!index.open(argv[2])){
+            cout << "Invalid index file " << argv[2] << endl;
+            return 1;
+        }
+        if(argc > 3) {
+            for(int i = 3; i < argc; i++) {
+                cout << argv[i] << ": " << index.countOccurrences(argv[i]) << endl;
+            }
+        } else {
+            string pattern;
+            while(getline(cin, pattern)) {
+                cout << pattern << ": " << index.countOccurrences(pattern) << endl;
+            }
+        }
+        return 0;
+    }
+    cout << "Usage: suffix_index build textfile indexfile | suffix_index query indexfile [pattern...]" << endl;
+    return 1;
+}
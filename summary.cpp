@@ -0,0 +1,200 @@
+#include <cstring>
+#include <fstream>
+#include "summary.h"
+
+using namespace std;
+
+namespace {
+
+const char summaryMagic[8] = {'L', 'S', 'C', 'A', 'N', 'S', 'M', '1'};
+
+/**
+ * Fixed-size header of a summary file, followed by the transfer function
+ * (numStates uint32) and the match counts (numStates uint64).
+ */
+struct SummaryHeader {
+    char magic[8];
+    uint32_t numStates;
+    uint32_t reserved;
+    uint64_t fingerprint;
+    uint64_t length;
+};
+
+/**
+ * @brief laneBlock represents the number of bytes scanned by every lane before lanes in the same state are merged
+ */
+const size_t laneBlock = 256;
+
+void hashBytes(uint64_t &hash, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *) data;
+    for(size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 1099511628211ULL;
+}
+
+}
+
+/**
+ * Hash of the transition table of an automaton (FNV-1a over its arrays).
+ *
+ * @param table
+ *            The automaton.
+ * @return The fingerprint.
+ */
+uint64_t ScanSummary::fingerprintOf(const DFATable &table) {
+    uint64_t hash = 14695981039346656037ULL;
+    int shape[3] = {table.numStates, table.numClasses, table.startState};
+    hashBytes(hash, shape, sizeof(shape));
+    hashBytes(hash, table.classMap, 256);
+    hashBytes(hash, table.transitions, (size_t) table.numStates * table.numClasses * sizeof(int));
+    hashBytes(hash, table.accepting, (size_t) table.numStates);
+    return hash;
+}
+
+/**
+ * Summary of the empty chunk: every state stays where it is, without matches.
+ *
+ * @param table
+ *            The automaton.
+ */
+ScanSummary::ScanSummary(const DFATable &table)
+    : fingerprint(fingerprintOf(table)), transfer(table.numStates), matches(table.numStates, 0) {
+    for(int state = 0; state < table.numStates; state++) transfer[state] = (uint32_t) state;
+}
+
+/**
+ * Summarize a chunk by running the automaton from every state at once. The
+ * runs are lanes; runs that reach the same state continue together, so after
+ * a few bytes (as soon as the lanes synchronize, e.g. in the trap state) the
+ * chunk is scanned by few lanes. A start state keeps the lane it follows and
+ * the difference between its own match count and the count of that lane.
+ *
+ * @param table
+ *            The automaton.
+ * @param chunk
+ *            The bytes of the chunk.
+ * @return The summary.
+ */
+ScanSummary ScanSummary::summarize(const DFATable &table, string_view chunk) {
+    ScanSummary summary(table);
+    int numStates = table.numStates;
+    vector<int> laneState(numStates);
+    vector<uint64_t> laneMatches(numStates, 0);
+    vector<uint32_t> laneOf(numStates);
+    for(int state = 0; state < numStates; state++) {
+        laneState[state] = state;
+        laneOf[state] = (uint32_t) state;
+    }
+    //The differences are kept in the summary until the end: counts are unsigned, so they wrap around but the sums are exact
+    vector<int> owner(numStates, -1);
+    vector<uint32_t> merged(numStates);
+    vector<uint64_t> difference(numStates);
+    for(size_t position = 0; position < chunk.length(); position += laneBlock) {
+        string_view block = chunk.substr(position, laneBlock);
+        for(size_t lane = 0; lane < laneState.size(); lane++) {
+            int state = laneState[lane];
+            uint64_t found = 0;
+            for(unsigned char letter : block) {
+                state = table.step(state, letter);
+                found += table.accepting[state];
+            }
+            laneState[lane] = state;
+            laneMatches[lane] += found;
+        }
+        if(laneState.size() == 1) continue;
+        //Lanes in the same state are merged into the first of them, the others are moved down
+        size_t lanes = 0;
+        for(size_t lane = 0; lane < laneState.size(); lane++) {
+            int &first = owner[laneState[lane]];
+            if(first == -1) {
+                first = (int) lanes;
+                laneState[lanes] = laneState[lane];
+                laneMatches[lanes] = laneMatches[lane];
+                difference[lane] = 0;
+                lanes++;
+            } else {
+                difference[lane] = laneMatches[lane] - laneMatches[first];
+            }
+            merged[lane] = (uint32_t) first;
+        }
+        for(size_t lane = 0; lane < lanes; lane++) owner[laneState[lane]] = -1;
+        if(lanes == laneState.size()) continue;
+        for(int state = 0; state < numStates; state++) {
+            summary.matches[state] += difference[laneOf[state]];
+            laneOf[state] = merged[laneOf[state]];
+        }
+        laneState.resize(lanes);
+        laneMatches.resize(lanes);
+    }
+    for(int state = 0; state < numStates; state++) {
+        summary.transfer[state] = (uint32_t) laneState[laneOf[state]];
+        summary.matches[state] += laneMatches[laneOf[state]];
+    }
+    summary.length = chunk.length();
+    return summary;
+}
+
+/**
+ * Extend this summary with the summary of the chunk that follows it: from
+ * every state, the next chunk starts where this one ends.
+ *
+ * @param next
+ *            The summary of the next chunk.
+ * @return False, if the summaries are of different automata.
+ */
+bool ScanSummary::append(const ScanSummary &next) {
+    if(fingerprint != next.fingerprint || transfer.size() != next.transfer.size()) return false;
+    for(size_t state = 0; state < transfer.size(); state++) {
+        uint32_t middle = transfer[state];
+        transfer[state] = next.transfer[middle];
+        matches[state] += next.matches[middle];
+    }
+    length += next.length;
+    return true;
+}
+
+/**
+ * Write the summary to a file.
+ *
+ * @param path
+ *            Destination file.
+ * @return True, if the file has been written.
+ */
+bool ScanSummary::save(const string &path) const {
+    SummaryHeader header;
+    memcpy(header.magic, summaryMagic, sizeof(summaryMagic));
+    header.numStates = (uint32_t) transfer.size();
+    header.reserved = 0;
+    header.fingerprint = fingerprint;
+    header.length = length;
+    ofstream out(path, ios::binary);
+    if(out.fail()) return false;
+    out.write((const char *) &header, sizeof(header));
+    out.write((const char *) transfer.data(), (streamsize) (transfer.size() * sizeof(uint32_t)));
+    out.write((const char *) matches.data(), (streamsize) (matches.size() * sizeof(uint64_t)));
+    return !out.fail();
+}
+
+/**
+ * Read a summary written by save().
+ *
+ * @param path
+ *            The summary file.
+ * @return True, if the file is a valid summary.
+ */
+bool ScanSummary::load(const string &path) {
+    ifstream in(path, ios::binary);
+    SummaryHeader header;
+    if(!in.read((char *) &header, sizeof(header)) || memcmp(header.magic, summaryMagic, sizeof(summaryMagic)) != 0) return false;
+    vector<uint32_t> loadedTransfer(header.numStates);
+    vector<uint64_t> loadedMatches(header.numStates);
+    in.read((char *) loadedTransfer.data(), (streamsize) (loadedTransfer.size() * sizeof(uint32_t)));
+    in.read((char *) loadedMatches.data(), (streamsize) (loadedMatches.size() * sizeof(uint64_t)));
+    if(in.fail()) return false;
+    for(uint32_t target : loadedTransfer) {
+        if(target >= header.numStates) return false;
+    }
+    fingerprint = header.fingerprint;
+    length = header.length;
+    transfer = move(loadedTransfer);
+    matches = move(loadedMatches);
+    return true;
+}
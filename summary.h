@@ -0,0 +1,134 @@
+#pragma once
+
+#include<cstdint>
+#include<string>
+#include<string_view>
+#include<vector>
+#include "compiled.h"
+
+using namespace std;
+
+/**
+ * Summary of the scan of a chunk of a larger input, for splitting the input
+ * across processes or machines and combining the results exactly.
+ *
+ * The state in which a chunk starts is only known once the chunks before it
+ * are scanned, so the summary covers every possible start state: the state
+ * reached at the end of the chunk (which also carries the partial matches
+ * that span the boundary into the next chunk) and the number of matches
+ * inside the chunk, i.e. of its non-empty prefixes after which the automaton
+ * is in an accepting state. Two summaries of adjacent chunks are merged by
+ * composing them, an associative operation, so the chunks can be summarized
+ * in any order and reduced in any tree shape as long as each merge keeps
+ * them in input order.
+ */
+class ScanSummary {
+    /**
+     * @brief fingerprint represents a hash of the automaton, so that summaries of different automata are not merged
+     */
+    uint64_t fingerprint = 0;
+    /**
+     * @brief length represents the number of bytes summarized
+     */
+    uint64_t length = 0;
+    /**
+     * @brief transfer represents, for every start state, the state reached at the end of the chunk
+     */
+    vector<uint32_t> transfer;
+    /**
+     * @brief matches represents, for every start state, the number of matches inside the chunk
+     */
+    vector<uint64_t> matches;
+public:
+    /**
+     * Hash of the transition table of an automaton.
+     *
+     * @param table
+     *            The automaton.
+     * @return The fingerprint.
+     */
+    static uint64_t fingerprintOf(const DFATable &table);
+
+    /**
+     * Empty summary, to be filled by load().
+     */
+    ScanSummary() = default;
+
+    /**
+     * Summary of the empty chunk, the neutral element of append().
+     *
+     * @param table
+     *            The automaton.
+     */
+    explicit ScanSummary(const DFATable &table);
+
+    /**
+     * Summarize a chunk.
+     *
+     * @param table
+     *            The automaton.
+     * @param chunk
+     *            The bytes of the chunk.
+     * @return The summary.
+     */
+    static ScanSummary summarize(const DFATable &table, string_view chunk);
+
+    /**
+     * Extend this summary with the summary of the chunk that follows it.
+     *
+     * @param next
+     *            The summary of the next chunk.
+     * @return False, if the summaries are of different automata.
+     */
+    bool append(const ScanSummary &next);
+
+    /**
+     * Number of bytes summarized.
+     */
+    uint64_t bytes() const { return length; }
+
+    /**
+     * Check if the summarized input, scanned from the start state, is accepted.
+     *
+     * @param table
+     *            The automaton of the summary.
+     * @return True, if the input is accepted.
+     */
+    bool accepted(const DFATable &table) const { return table.isAccepting((int) transfer[table.startState]); }
+
+    /**
+     * Number of matches in the summarized input, scanned from the start state.
+     *
+     * @param table
+     *            The automaton of the summary.
+     * @return The number of matches.
+     */
+    uint64_t matchCount(const DFATable &table) const { return matches[table.startState]; }
+
+    /**
+     * Check if this summary has been made with an automaton.
+     *
+     * @param table
+     *            The automaton.
+     * @return True, if the fingerprints are the same.
+     */
+    bool isOf(const DFATable &table) const { return fingerprint == fingerprintOf(table) && transfer.size() == (size_t) table.numStates; }
+
+    /**
+     * Write the summary to a file.
+     *
+     * @param path
+     *            Destination file.
+     * @return True, if the file has been written.
+     */
+    bool save(const string &path) const;
+
+    /**
+     * Read a summary written by save().
+     *
+     * @param path
+     *            The summary file.
+     * @return True, if the file is a valid summary.
+     */
+    bool load(const string &path);
+};
@@ -0,0 +1,46 @@
+#include <random>
+#include "check.h"
+#include "embedded.h"
+
+using namespace std;
+
+/**
+ * runBatch gives every input the verdict of run, for any number of inputs
+ * (fewer or more than the lanes), empty and long inputs, and every lane
+ * count and prefetch distance, including no prefetch.
+ */
+int main() {
+    mt19937_64 generator(7);
+    const char *pieces[] = {"//", "\n", "{", "}", "(*", "*)", "x", "é", " "};
+    vector<string> words(300);
+    for(size_t i = 0; i < words.size(); i++) {
+        size_t length = i % 50 == 0 ? 0 : generator() % (i % 7 == 0 ? 400 : 12);
+        //Every third word is a comment, whose body has no delimiter
+        for(size_t piece = 0; piece < length; piece++) words[i] += pieces[i % 3 == 0 ? 6 + generator() % 3 : generator() % 9];
+        if(i % 3 == 0) words[i] = i % 2 == 0 ? "{" + words[i] + "}" : "//" + words[i] + "\n";
+        if(i % 5 == 1) words[i] = "repeat";
+    }
+    vector<string_view> inputs(words.begin(), words.end());
+    for(const char *name : {"comment", "comment-utf8", "repeat"}) {
+        const DFATable &table = *findEmbeddedDFA(name);
+        vector<unsigned char> expected(words.size());
+        for(size_t i = 0; i < words.size(); i++) expected[i] = table.run(words[i]);
+        for(unsigned lanes : {1u, 2u, 5u, 16u, 64u}) {
+            for(unsigned distance : {0u, 1u, lanes / 2, lanes - 1}) {
+                if(distance >= lanes && distance != 0) continue;
+                BatchOptions options;
+                options.lanes = lanes;
+                options.prefetchDistance = distance;
+                for(size_t count : {(size_t) 0, (size_t) 1, (size_t) 3, (size_t) 63, words.size()}) {
+                    vector<unsigned char> results(count + 1, 9);
+                    runBatch(table, inputs.data(), count, results.data(), options);
+                    bool agree = results[count] == 9;
+                    for(size_t i = 0; i < count; i++) agree = agree && results[i] == expected[i];
+                    check(agree, string(name) + " with " + to_string(lanes) + " lanes, distance " + to_string(distance)
+                                     + " and " + to_string(count) + " inputs");
+                }
+            }
+        }
+    }
+    return testResult();
+}
@@ -0,0 +1,52 @@
+#include "bounded.h"
+#include "check.h"
+#include "embedded.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Length of the text of a comment (without its delimiters), or -1 if the
+ * input is not a comment.
+ */
+int64_t commentText(const string &input) {
+    size_t n = input.length();
+    if(n >= 3 && input.compare(0, 2, "//") == 0) return input.find('\n') == n - 1 ? (int64_t) n - 3 : -1;
+    if(n >= 2 && input[0] == '{') return input.find('}') == n - 1 ? (int64_t) n - 2 : -1;
+    if(n >= 4 && input.compare(0, 2, "(*") == 0) return input.find("*)", 2) == n - 2 ? (int64_t) n - 4 : -1;
+    return -1;
+}
+
+}
+
+/**
+ * The comment automaton with its body states counted accepts exactly the
+ * comments whose text length is within the bounds, on every word of up to 6
+ * letters over the letters that matter to it. The '*' of a (* *) comment
+ * counts only once it turns out not to close the comment.
+ */
+int main() {
+    const DFATable &comment = *findEmbeddedDFA("comment");
+    pair<uint32_t, uint32_t> bounds[] = {{0, BoundedDFA::unbounded}, {0, 0}, {1, 2}, {2, 3}, {3, BoundedDFA::unbounded}};
+    const string letters = "/\n{}(*)a";
+    string input;
+    for(auto &bound : bounds) {
+        BoundedDFA bounded(comment, {CommentDFA::lineBodyState, CommentDFA::braceBodyState, CommentDFA::parenBodyState},
+                           bound.first, bound.second);
+        string name = " with bounds " + to_string(bound.first) + ", " + to_string(bound.second);
+        for(int length = 0; length <= 6; length++) {
+            size_t words = 1;
+            for(int i = 0; i < length; i++) words *= letters.length();
+            for(size_t word = 0; word < words; word++) {
+                input.clear();
+                for(size_t rest = word, i = 0; i < (size_t) length; i++, rest /= letters.length()) input.push_back(letters[rest % letters.length()]);
+                int64_t text = commentText(input);
+                bool expected = text >= (int64_t) bound.first && (bound.second == BoundedDFA::unbounded || text <= (int64_t) bound.second);
+                //The description is only built for a failure: there are millions of words
+                if(bounded.run(input) != expected) check(false, input + name);
+            }
+        }
+    }
+    return testResult();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include<iostream>
+#include<string>
+
+using namespace std;
+
+/**
+ * @brief failures represents the number of failed checks of the test program
+ */
+inline int failures = 0;
+
+/**
+ * Record a check of a test program, printing it if it fails.
+ *
+ * @param condition
+ *            The checked property.
+ * @param what
+ *            Description of the check.
+ */
+inline void check(bool condition, const string &what) {
+    if(!condition) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+/**
+ * Exit status of a test program: 0 if every check passed.
+ */
+inline int testResult() {
+    if(failures == 0) cout << "OK" << endl;
+    return failures == 0 ? 0 : 1;
+}
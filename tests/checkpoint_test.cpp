@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <random>
+#include <sys/stat.h>
+#include "check.h"
+#include "checkpoint.h"
+#include "embedded.h"
+
+using namespace std;
+
+/**
+ * A scan resumed from a checkpoint with the progress of a scan of the first
+ * part of a file ends with the states and the match counts of a scan of the
+ * whole file; a checkpoint is saved without leaving its temporary file, is
+ * rejected for other automata, another file, a file that has been truncated
+ * or rewritten since the scan started, or an offset beyond the end of the
+ * file, and is not loaded once truncated.
+ */
+int main() {
+    vector<DFATable> tables{*findEmbeddedDFA("comment"), *findEmbeddedDFA("identifier"), *findEmbeddedDFA("repeat")};
+    mt19937_64 generator(5);
+    const char *pieces[] = {"//", "\n", "{", "}", "(*", "*)", "x", "repeat", " "};
+    string input;
+    while(input.length() < 1500000) input += pieces[generator() % 9];
+    const char *inputPath = "checkpoint_test.input", *firstPath = "checkpoint_test.first", *checkpointPath = "checkpoint_test.checkpoint";
+
+    ofstream(inputPath, ios::binary) << input;
+    ScanCheckpoint whole;
+    check(whole.start(tables, inputPath), "start the whole scan");
+    check(streamScan(tables, whole, "", 1 << 20), "whole scan");
+    check(whole.offset == input.length(), "whole scan offset");
+
+    //The first part of the input, in a file of its own, is scanned; its progress becomes a checkpoint of the whole file
+    ofstream(firstPath, ios::binary) << input.substr(0, 600000);
+    ScanCheckpoint first;
+    check(first.start(tables, firstPath) && streamScan(tables, first, "", 1 << 16), "scan of the first part");
+    ScanCheckpoint interrupted;
+    check(interrupted.start(tables, inputPath), "start the interrupted scan");
+    interrupted.offset = first.offset;
+    interrupted.states = first.states;
+    interrupted.matches = first.matches;
+    check(interrupted.save(checkpointPath), "save the checkpoint");
+    ScanCheckpoint resumed;
+    check(resumed.load(checkpointPath) && resumed.belongsTo(tables, inputPath), "load the checkpoint");
+    check(resumed.offset == 600000 && resumed.fileSize == input.length(), "checkpoint offset and file size");
+    check(streamScan(tables, resumed, checkpointPath, 1 << 16), "resumed scan");
+    check(resumed.offset == whole.offset && resumed.states == whole.states && resumed.matches == whole.matches, "resumed scan result");
+    check(!ifstream(string(checkpointPath) + ".tmp"), "no temporary file left");
+
+    vector<DFATable> others{tables[1], tables[0], tables[2]};
+    check(!resumed.belongsTo(others, inputPath) && !resumed.belongsTo(tables, "other.input"), "checkpoint of another scan");
+    ScanCheckpoint beyond = interrupted;
+    beyond.offset = input.length() + 1;
+    check(!beyond.belongsTo(tables, inputPath) && !streamScan(tables, beyond, "", 1 << 16), "offset beyond the end of the file");
+
+    //The same bytes written again, with another modification time
+    struct stat info;
+    check(stat(inputPath, &info) == 0, "stat the input");
+    struct timespec times[2] = {info.st_atim, info.st_mtim};
+    times[1].tv_sec--;
+    check(utimensat(AT_FDCWD, inputPath, times, 0) == 0, "change the modification time");
+    check(!interrupted.belongsTo(tables, inputPath) && !streamScan(tables, interrupted, "", 1 << 16), "rewritten file");
+    check(interrupted.start(tables, inputPath) && interrupted.belongsTo(tables, inputPath), "start again after the rewrite");
+    ofstream(inputPath, ios::binary) << input.substr(0, 700000);
+    check(!interrupted.belongsTo(tables, inputPath), "truncated file");
+
+    ifstream saved(checkpointPath, ios::binary);
+    string bytes((istreambuf_iterator<char>(saved)), istreambuf_iterator<char>());
+    ofstream(checkpointPath, ios::binary).write(bytes.data(), (streamsize) bytes.length() - 1);
+    check(!ScanCheckpoint().load(checkpointPath), "truncated checkpoint");
+    remove(inputPath);
+    remove(firstPath);
+    remove(checkpointPath);
+    return testResult();
+}
@@ -0,0 +1,47 @@
+#include "check.h"
+#include "compiled.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Reference recognizer of the three kinds of comments, written directly from
+ * their definition.
+ */
+bool isComment(const string &input) {
+    size_t n = input.length();
+    if(n >= 3 && input.compare(0, 2, "//") == 0) return input.find('\n') == n - 1;
+    if(n >= 2 && input[0] == '{') return input.find('}') == n - 1;
+    if(n >= 4 && input.compare(0, 2, "(*") == 0) return input.find("*)", 2) == n - 2;
+    return false;
+}
+
+}
+
+/**
+ * CommentDFA, with its self-loops as default transitions, and its compiled
+ * table accept exactly the comments, on every word of up to 6 letters over
+ * the letters that matter to it.
+ */
+int main() {
+    CommentDFA dfa;
+    CompiledDFA compiled(dfa);
+    DFATable table = compiled.table();
+    check(table.numStates == 9 && table.trapState == 8, "8 states and the trap");
+    const string letters = "/\n{}(*)a";
+    string input;
+    for(int length = 0; length <= 6; length++) {
+        size_t words = 1;
+        for(int i = 0; i < length; i++) words *= letters.length();
+        for(size_t word = 0; word < words; word++) {
+            input.clear();
+            for(size_t rest = word, i = 0; i < (size_t) length; i++, rest /= letters.length()) input.push_back(letters[rest % letters.length()]);
+            bool expected = isComment(input);
+            check(dfa.run(input) == expected, "CommentDFA on " + input);
+            check(table.run(input) == expected, "compiled CommentDFA on " + input);
+        }
+    }
+    for(const char *comment : {"// any \xff byte\n", "{ \x01\x80 }", "(* ** *)"}) check(dfa.run(comment), string("accepts ") + comment);
+    return testResult();
+}
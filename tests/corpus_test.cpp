@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <fstream>
+#include "check.h"
+#include "corpus.h"
+#include "embedded.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Write a file made of 64-bit words after the 8 byte magic of a corpus.
+ */
+void writeWords(const char *path, const string &magic, const vector<uint64_t> &words) {
+    ofstream out(path, ios::binary);
+    out << magic;
+    out.write((const char *) words.data(), (streamsize) (words.size() * sizeof(uint64_t)));
+}
+
+}
+
+/**
+ * A packed corpus is read back with the same inputs and every verdict of
+ * runCorpus is the verdict of run; an empty corpus is valid, while a
+ * truncated file and crafted headers whose sizes overflow or point past the
+ * end are rejected.
+ */
+int main() {
+    const char *path = "corpus_test.corpus";
+    vector<string> inputs{"{ x }", "", "// line\n", "(* *)", "x", string(1000, '{'), "{}"};
+    CorpusWriter writer;
+    check(writer.open(path), "open the writer");
+    for(const string &input : inputs) check(writer.add(input), "add an input");
+    check(writer.close(), "close the writer");
+
+    PackedCorpus corpus;
+    check(corpus.open(path) && corpus.size() == inputs.size(), "open the corpus");
+    uint64_t bytes = 0;
+    for(size_t i = 0; i < inputs.size() && i < corpus.size(); i++) {
+        check(corpus[i] == inputs[i], "input " + to_string(i));
+        bytes += inputs[i].length();
+    }
+    check(corpus.bytes() == bytes, "bytes");
+    const DFATable &table = *findEmbeddedDFA("comment");
+    for(unsigned threads : {1u, 3u, 16u}) {
+        vector<unsigned char> results(corpus.size());
+        runCorpus(table, corpus, results.data(), threads);
+        for(size_t i = 0; i < results.size(); i++) check(results[i] == table.run(inputs[i]), "verdict of input " + to_string(i));
+    }
+
+    ifstream packed(path, ios::binary);
+    string file((istreambuf_iterator<char>(packed)), istreambuf_iterator<char>());
+    string magic = file.substr(0, 8);
+    ofstream(path, ios::binary).write(file.data(), (streamsize) file.length() - 8);
+    check(!corpus.open(path), "truncated corpus");
+    //Header words: count, dataBytes, offsetsStart, then the offsets
+    writeWords(path, magic, {0, 0, 32, 0});
+    check(corpus.open(path) && corpus.size() == 0 && corpus.bytes() == 0, "empty corpus");
+    writeWords(path, "LCORPUS0", {0, 0, 32, 0});
+    check(!corpus.open(path), "wrong magic");
+    uint64_t wrapping = ~(uint64_t) 0 - 31 + 8;
+    writeWords(path, magic, {1, wrapping, 32, 0, wrapping});
+    check(!corpus.open(path), "data size that overflows");
+    writeWords(path, magic, {1, 8, 32, 0, 8});
+    check(!corpus.open(path), "offsets inside the data");
+    writeWords(path, magic, {1000, 0, 32, 0});
+    check(!corpus.open(path), "more inputs than offsets");
+    remove(path);
+    return testResult();
+}
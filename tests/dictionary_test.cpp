@@ -0,0 +1,32 @@
+#include <algorithm>
+#include "check.h"
+#include "compiled.h"
+#include "dictionary.h"
+
+using namespace std;
+
+/**
+ * The dictionary DFA accepts exactly its words, also once compiled into a
+ * table, and its IDs are the positions of the words in byte order.
+ */
+int main() {
+    vector<string> words = {"repeat", "until", "begin", "end", "", "re", "\xc3\xa9t\xc3\xa9", "end", "begins"};
+    DictionaryDFA dictionary(words);
+    CompiledDFA compiled(dictionary);
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+    check(dictionary.size() == words.size(), "size counts the distinct words");
+    for(size_t id = 0; id < words.size(); id++) {
+        check(dictionary.run(words[id]), "run accepts " + words[id]);
+        check(compiled.run(words[id]), "compiled table accepts " + words[id]);
+        check(dictionary.rank(words[id]) == (int64_t) id, "rank of " + words[id]);
+        check(dictionary.word(id) == words[id], "word " + to_string(id));
+    }
+    for(const char *other : {"r", "rep", "repeats", "beg", "und", "x", "\xc3\xa9"}) {
+        check(!dictionary.run(other), "run rejects " + string(other));
+        check(!compiled.run(other), "compiled table rejects " + string(other));
+        check(dictionary.rank(other) == DictionaryDFA::notFound, "rank of " + string(other));
+    }
+    check(dictionary.word(words.size()).empty(), "word out of range");
+    return testResult();
+}
@@ -0,0 +1,39 @@
+#include <cstring>
+#include <memory>
+#include "check.h"
+#include "embedded.h"
+#include "equivalence.h"
+
+using namespace std;
+
+/**
+ * The tables compiled into the binary are sorted by name, found by name, and
+ * accept the same words as the automata they were generated from.
+ */
+int main() {
+    for(int i = 1; i < embeddedAutomataCount; i++) {
+        check(strcmp(embeddedAutomata[i - 1].name, embeddedAutomata[i].name) < 0, "sorted by name");
+    }
+    check(findEmbeddedDFA("missing") == nullptr && findEmbeddedDFA("") == nullptr, "unknown names");
+    pair<const char *, unique_ptr<AbstractDFA>> sources[] = {
+        {"repeat", make_unique<WordDFA>("repeat")},
+        {"comment", make_unique<CommentDFA>(false)},
+        {"comment-utf8", make_unique<CommentDFA>(true)},
+        {"identifier", make_unique<IdentifierDFA>(false)},
+        {"identifier-utf8", make_unique<IdentifierDFA>(true)},
+    };
+    check(embeddedAutomataCount == 5, "every declaration is embedded");
+    for(auto &source : sources) {
+        const DFATable *table = findEmbeddedDFA(source.first);
+        check(table != nullptr, string("find ") + source.first);
+        if(table == nullptr) continue;
+        CompiledDFA compiled(*source.second);
+        string counterexample;
+        check(equivalent(*table, compiled.table(), &counterexample),
+              string(source.first) + " is its source automaton, not on \"" + counterexample + "\"");
+        for(const char *input : {"repeat", "{ x }", "(* a *)", "// b\n", "x_1", "\xc3\xa9t\xc3\xa9", "{ \xc0\xaf }"}) {
+            check(table->run(input) == source.second->run(input), string(source.first) + " on " + input);
+        }
+    }
+    return testResult();
+}
@@ -0,0 +1,70 @@
+#include "check.h"
+#include "equivalence.h"
+#include "subset.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Length of the shortest word over {a, b, c} of up to 6 letters accepted by
+ * a and rejected by b (or, with both, accepted by exactly one), or -1.
+ */
+int shortestDifference(const NFA &a, const NFA &b, bool both) {
+    string input;
+    for(int length = 0; length <= 6; length++) {
+        size_t words = 1;
+        for(int i = 0; i < length; i++) words *= 3;
+        for(size_t word = 0; word < words; word++) {
+            input.clear();
+            for(size_t rest = word, i = 0; i < (size_t) length; i++, rest /= 3) input.push_back("abc"[rest % 3]);
+            bool inA = a.run(input), inB = b.run(input);
+            if(both ? inA != inB : inA && !inB) return length;
+        }
+    }
+    return -1;
+}
+
+}
+
+/**
+ * Equivalence and inclusion agree with a brute-force search over short words,
+ * and the counterexamples are shortest words with the right verdicts; the
+ * inclusion in an NFA gives the same answers as the inclusion in its DFA.
+ */
+int main() {
+    const char *patterns[] = {"(a|b)*abb", "(a|b)*a(a|b)(a|b)", "a*", "(aa)*", "a*b*", "(a|b)*", "(ab|a)*", "a(ba)*b?|()",
+                              "(a*b*)*", "[ab]*", "c", "(a|b)*abb|c"};
+    size_t count = sizeof(patterns) / sizeof(patterns[0]);
+    vector<NFA> nfas(count);
+    vector<unique_ptr<CompiledDFA>> tables;
+    for(size_t i = 0; i < count; i++) {
+        check(NFA::fromPattern(patterns[i], nfas[i], nullptr), string("parse ") + patterns[i]);
+        tables.push_back(determinize(nfas[i], 1));
+    }
+    for(size_t i = 0; i < count; i++) {
+        for(size_t j = 0; j < count; j++) {
+            string pair = string(patterns[i]) + " and " + patterns[j], counterexample;
+            DFATable a = tables[i]->table(), b = tables[j]->table();
+            int difference = shortestDifference(nfas[i], nfas[j], true);
+            check(equivalent(a, b, &counterexample) == (difference == -1), "equivalence of " + pair);
+            if(difference != -1) {
+                check((int) counterexample.length() == difference && a.run(counterexample) != b.run(counterexample),
+                      "shortest counterexample to the equivalence of " + pair);
+            }
+            int missing = shortestDifference(nfas[i], nfas[j], false);
+            check(isIncluded(a, b, &counterexample) == (missing == -1), "inclusion of " + pair);
+            if(missing != -1) {
+                check((int) counterexample.length() == missing && a.run(counterexample) && !b.run(counterexample),
+                      "shortest counterexample to the inclusion of " + pair);
+            }
+            string nfaCounterexample;
+            check(isIncluded(a, nfas[j], &nfaCounterexample) == (missing == -1), "inclusion of " + pair + " in the NFA");
+            if(missing != -1) {
+                check((int) nfaCounterexample.length() == missing && a.run(nfaCounterexample) && !nfas[j].run(nfaCounterexample),
+                      "shortest counterexample to the inclusion of " + pair + " in the NFA");
+            }
+        }
+    }
+    return testResult();
+}
@@ -0,0 +1,63 @@
+#include <cmath>
+#include <sstream>
+#include <thread>
+#include "check.h"
+#include "histogram.h"
+
+using namespace std;
+
+/**
+ * Every value falls in a bucket whose bounds contain it and are within the
+ * precision of the histogram, percentiles are exact up to that precision, the
+ * shards of many threads add up, and a snapshot survives being written, read
+ * back and added to another histogram.
+ */
+int main() {
+    for(uint64_t value = 0; value < 100000; value += 1 + value / 50) {
+        int index = LatencyHistogram::bucketIndex(value);
+        uint64_t low = LatencyHistogram::bucketLowerBound(index), high = LatencyHistogram::bucketUpperBound(index);
+        check(low <= value && value <= high, "bucket of " + to_string(value) + " contains it");
+        check(high - low <= low / (1 << LatencyHistogram::subBucketBits), "bucket of " + to_string(value) + " is narrow");
+        if(value > 0) check(LatencyHistogram::bucketIndex(value - 1) <= index, "buckets grow with " + to_string(value));
+    }
+    check(LatencyHistogram::bucketIndex(UINT64_MAX) == LatencyHistogram::bucketCount - 1, "last bucket");
+
+    LatencyHistogram latency("test");
+    vector<thread> threads;
+    for(int t = 0; t < 8; t++) {
+        threads.emplace_back([&latency, t]() {
+            for(uint64_t value = 1 + t; value <= 10000; value += 8) latency.record(value);
+        });
+    }
+    for(thread &worker : threads) worker.join();
+    HistogramSnapshot snapshot = latency.snapshot();
+    check(snapshot.totalCount == 10000 && snapshot.maxValue == 10000, "every value recorded");
+    check(snapshot.mean() == 5000.5, "mean");
+    for(double quantile : {0.5, 0.9, 0.99, 0.999}) {
+        double exact = quantile * 10000, error = fabs((double) snapshot.percentile(quantile) - exact) / exact;
+        check(error <= 1.0 / (1 << LatencyHistogram::subBucketBits), "percentile " + to_string(quantile));
+    }
+    check(snapshot.percentile(1.0) == 10000, "p100 is the largest value");
+
+    //What a worker sends: the values recorded since a baseline, added to the parent's histogram
+    HistogramSnapshot baseline = latency.snapshot();
+    latency.record(1000000);
+    HistogramSnapshot recorded = latency.snapshot();
+    recorded.subtract(baseline);
+    stringstream wire;
+    recorded.write(wire);
+    HistogramSnapshot received;
+    check(received.read(wire) && received.totalCount == 1 && received.sum == 1000000, "snapshot read back");
+    LatencyHistogram merged("merged");
+    merged.record(5);
+    merged.add(received);
+    HistogramSnapshot total = merged.snapshot();
+    check(total.totalCount == 2 && total.maxValue == 1000000 && total.percentile(0.5) == 5, "snapshot added");
+    stringstream corrupt("3 10 5 1 7 2");
+    check(!received.read(corrupt), "counts that don't add up are rejected");
+
+    stringstream summary;
+    printLatencySummary(summary, merged);
+    check(summary.str().find("count=2 ") != string::npos, "summary");
+    return testResult();
+}
@@ -0,0 +1,54 @@
+#include "check.h"
+#include "lexer.h"
+
+using namespace std;
+
+/**
+ * Identifiers get dense IDs that survive the growth of the table, the hash
+ * computed a byte at a time is the one of the whole identifier, and the lexer
+ * interns identifiers and recognizes keywords while it splits the input.
+ */
+int main() {
+    InternTable table;
+    check(table.find("x") == InternTable::noId, "empty table");
+    for(uint32_t i = 0; i < 100000; i++) check(table.intern("name" + to_string(i)) == i, "dense ID " + to_string(i));
+    check(table.size() == 100000, "size");
+    for(uint32_t i = 0; i < 100000; i += 997) {
+        string name = "name" + to_string(i);
+        check(table.intern(name) == i && table.find(name) == i && table.name(i) == name, "ID of " + name + " after growth");
+    }
+    check(table.find("name100000") == InternTable::noId, "find doesn't add");
+    uint64_t hash = InternTable::hashSeed;
+    for(unsigned char letter : string("\xc3\xa9l\xc3\xa8ve")) hash = InternTable::hashStep(hash, letter);
+    check(hash == InternTable::hash("\xc3\xa9l\xc3\xa8ve"), "hash a byte at a time");
+
+    InternTable identifiers;
+    Lexer lexer(identifiers);
+    string input = "repeat x1 := x1 + 42 (* loop *) until \xc3\xa9t\xc3\xa9 = x1 \xff";
+    vector<Token> tokens;
+    check(lexer.tokenize(input, tokens), "tokenize");
+    vector<TokenKind> kinds = {TokenKind::Keyword, TokenKind::Identifier, TokenKind::Punctuation, TokenKind::Punctuation,
+                               TokenKind::Identifier, TokenKind::Punctuation, TokenKind::Number, TokenKind::Comment,
+                               TokenKind::Keyword, TokenKind::Identifier, TokenKind::Punctuation, TokenKind::Identifier,
+                               TokenKind::Unknown};
+    check(tokens.size() == kinds.size(), "token count");
+    for(size_t i = 0; i < tokens.size() && i < kinds.size(); i++) check(tokens[i].kind == kinds[i], "kind of token " + to_string(i));
+    if(tokens.size() == kinds.size()) {
+        check(tokens[1].id == tokens[4].id && tokens[4].id == tokens[11].id, "same identifier, same ID");
+        check(identifiers.size() == 2 && identifiers.name(tokens[9].id) == "\xc3\xa9t\xc3\xa9", "UTF-8 identifier interned");
+        check(lexer.keyword(tokens[0].id) == "repeat" && lexer.keyword(tokens[8].id) == "until", "keyword IDs");
+        check(input.substr(tokens[7].offset, tokens[7].length) == "(* loop *)", "comment token");
+    }
+
+    //Unclosed comment openers are punctuation, and the comments after them are still found
+    check(lexer.tokenize("{ a (* b *) c { // d", tokens) && tokens.size() == 8, "tokens after unclosed openers");
+    if(tokens.size() == 8) {
+        check(tokens[0].kind == TokenKind::Punctuation && tokens[2].kind == TokenKind::Comment && tokens[4].kind == TokenKind::Punctuation,
+              "unclosed { is punctuation");
+        check(tokens[6].kind == TokenKind::Punctuation && tokens[7].kind == TokenKind::Identifier, "unclosed // is punctuation");
+    }
+    //Many unclosed openers would take quadratic time if every one was scanned to the end
+    string unclosed(100000, '{');
+    check(lexer.tokenize(unclosed + "x", tokens) && tokens.size() == 100001, "many unclosed comments");
+    return testResult();
+}
@@ -0,0 +1,59 @@
+#include <random>
+#include <regex>
+#include "check.h"
+#include "lazy.h"
+
+using namespace std;
+
+/**
+ * The lazy DFA agrees with std::regex over many runs that share one cache,
+ * with a cache large enough to keep every state and with one small enough to
+ * be flushed and to fall back to the NFA; a thrashing run falls back, goes
+ * back to the DFA and falls back again. Nested bounded repetitions that
+ * would expand to too many states are rejected.
+ */
+int main() {
+    const char *patterns[] = {"(a|b)*a(a|b){6}", "[a-c]*abc", "(ab|ba)+c?", "a{2,4}b*"};
+    mt19937_64 generator(7);
+    for(const char *pattern : patterns) {
+        NFA nfa;
+        check(NFA::fromPattern(pattern, nfa, nullptr), string("parse ") + pattern);
+        regex reference(pattern, regex::extended);
+        LazyDFA::Options tiny;
+        tiny.cacheBytes = 2048;
+        tiny.fallbackBytes = 16;
+        LazyDFA roomy(nfa), small(nfa, tiny);
+        for(int run = 0; run < 2000; run++) {
+            string input;
+            size_t length = generator() % 40;
+            for(size_t i = 0; i < length; i++) input.push_back("abc"[generator() % 3]);
+            bool expected = regex_match(input, reference);
+            check(roomy.run(input) == expected, string(pattern) + " on " + input);
+            check(small.run(input) == expected, string(pattern) + " on " + input + " with a small cache");
+        }
+        //Short runs over a cache that holds every state never look like thrashing
+        check(roomy.stats().cacheFlushes == 0 && roomy.stats().fallbacks == 0, string(pattern) + " without flushes");
+    }
+
+    //Random a/b text visits a new state of (a|b)*a(a|b){6} at almost every byte, so a small cache thrashes
+    NFA thrashing;
+    check(NFA::fromPattern("(a|b)*a(a|b){6}", thrashing, nullptr), "parse the thrashing pattern");
+    LazyDFA::Options tiny;
+    tiny.cacheBytes = 2048;
+    tiny.fallbackBytes = 64;
+    LazyDFA lazy(thrashing, tiny);
+    string input;
+    for(int i = 0; i < 20000; i++) input.push_back("ab"[generator() % 2]);
+    check(lazy.run(input) == (input[input.length() - 7] == 'a'), "verdict of the thrashing run");
+    const LazyDFA::Stats &stats = lazy.stats();
+    check(stats.cacheFlushes > 0, "the small cache is flushed");
+    check(stats.fallbacks > 1 && stats.nfaBytes > 0, "the run falls back to the NFA");
+    //A fallback only starts from the DFA, so a second one means the DFA was tried again after the first
+    check(stats.dfaBytes + stats.nfaBytes == input.length() && stats.nfaBytes <= stats.fallbacks * (tiny.fallbackBytes + 1),
+          "the DFA is retried after every fallback");
+
+    string error;
+    check(!NFA::fromPattern("(a{1000}){1000}", thrashing, &error) && !error.empty(), "nested repetitions too large");
+    check(NFA::fromPattern("(a{30}){30}", thrashing, nullptr) && thrashing.run(string(900, 'a')), "nested repetitions");
+    return testResult();
+}
@@ -0,0 +1,52 @@
+#include <fstream>
+#include <sstream>
+#include "check.h"
+#include "metrics.h"
+
+using namespace std;
+
+/**
+ * Metrics are found again by name and labels, written in the Prometheus text
+ * format (also as a textfile), and counter deltas written by a process are
+ * added by another one.
+ */
+int main() {
+    Counter &runs = Metrics::counter("test_runs_total", "Runs.", "engine=\"table\"");
+    check(&runs == &Metrics::counter("test_runs_total", "Runs.", "engine=\"table\""), "same counter for the same labels");
+    check(&runs != &Metrics::counter("test_runs_total", "Runs.", "engine=\"lazy\""), "other labels, other counter");
+    runs.add(3);
+    Metrics::gauge("test_depth", "Depth.").set(2.5);
+    LatencyHistogram latency("test");
+    for(uint64_t value = 1; value <= 100; value++) latency.record(value * 1000);
+    Metrics::addHistogram("test_latency_seconds", "Latency.", latency);
+
+    stringstream out;
+    Metrics::write(out);
+    string text = out.str();
+    check(text.find("# HELP test_runs_total Runs.\n# TYPE test_runs_total counter\n") != string::npos, "counter header");
+    check(text.find("test_runs_total{engine=\"table\"} 3\n") != string::npos, "counter sample");
+    check(text.find("test_runs_total{engine=\"lazy\"} 0\n") != string::npos, "counter created at lookup");
+    check(text.find("# TYPE test_depth gauge\ntest_depth 2.5\n") != string::npos, "gauge");
+    check(text.find("# TYPE test_latency_seconds summary\n") != string::npos, "summary header");
+    check(text.find("test_latency_seconds_count 100\n") != string::npos, "summary count");
+    check(text.find("test_latency_seconds{quantile=\"0.5\"}") != string::npos, "summary quantile");
+    check(text.find("process_resident_memory_bytes") != string::npos, "process memory");
+
+    check(Metrics::writeTextfile("metrics_test.prom"), "textfile written");
+    ifstream textfile("metrics_test.prom");
+    string firstLine;
+    check(getline(textfile, firstLine) && firstLine.rfind("# HELP ", 0) == 0, "textfile contents");
+
+    //A worker's deltas: only what grew, including counters the parent doesn't know yet
+    Metrics::CounterValues baseline = Metrics::counterValues();
+    runs.add(2);
+    Metrics::counter("test_new_total", "New.").add(7);
+    stringstream deltas;
+    Metrics::writeCounterDeltas(deltas, baseline);
+    check(deltas.str() == "test_new_total\t\t7\tNew.\ntest_runs_total\tengine=\"table\"\t2\tRuns.\n\n", "deltas");
+    check(Metrics::addCounterDeltas(deltas), "deltas read back");
+    check(runs.get() == 7 && Metrics::counter("test_new_total", "New.").get() == 14, "deltas added");
+    stringstream corrupt("test_runs_total\t\t-1\tRuns.\n\n");
+    check(!Metrics::addCounterDeltas(corrupt), "negative delta rejected");
+    return testResult();
+}
@@ -0,0 +1,49 @@
+#include <random>
+#include "check.h"
+#include "equivalence.h"
+#include "minimize.h"
+#include "subset.h"
+
+using namespace std;
+
+/**
+ * Minimization keeps the language of random DFAs, gives the same table on 1
+ * and 4 threads, and leaves no two equivalent states; a minimal DFA is not
+ * changed any further.
+ */
+int main() {
+    mt19937_64 generator(3);
+    unsigned char classMap[256];
+    for(int letter = 0; letter < 256; letter++) classMap[letter] = (unsigned char) (letter % 3);
+    for(int round = 0; round < 40; round++) {
+        int states = 2 + (int) (generator() % 40), classes = 3;
+        vector<int> transitions((size_t) states * classes);
+        vector<unsigned char> accepting(states);
+        for(int &target : transitions) target = (int) (generator() % states);
+        for(unsigned char &final : accepting) final = generator() % 3 == 0;
+        DFATable table{states, classes, 0, -1, classMap, transitions.data(), accepting.data()};
+        string name = "random DFA " + to_string(round);
+        CompiledDFA single = minimize(table, 1), parallel = minimize(table, 4);
+        DFATable minimal = single.table(), other = parallel.table();
+        bool same = minimal.numStates == other.numStates && minimal.startState == other.startState;
+        for(int i = 0; same && i < minimal.numStates * classes; i++) same = minimal.transitions[i] == other.transitions[i];
+        check(same, name + ": same table on 1 and 4 threads");
+        check(minimal.numStates <= states && equivalent(table, minimal), name + ": same language");
+        //Two different states of a minimal DFA always have a word that tells them apart
+        for(int a = 0; a < minimal.numStates; a++) {
+            for(int b = a + 1; b < minimal.numStates; b++) {
+                DFATable fromA = minimal, fromB = minimal;
+                fromA.startState = a;
+                fromB.startState = b;
+                if(equivalent(fromA, fromB)) check(false, name + ": states " + to_string(a) + " and " + to_string(b) + " are equivalent");
+            }
+        }
+        check(minimize(minimal, 2).table().numStates == minimal.numStates, name + ": minimal already");
+    }
+    NFA nfa;
+    NFA::fromPattern("(a|b)*abb", nfa, nullptr);
+    unique_ptr<CompiledDFA> determinized = determinize(nfa, 1);
+    //The four states of the textbook automaton, and the trap for the other bytes
+    check(minimize(determinized->table()).table().numStates == 5, "(a|b)*abb has 5 states");
+    return testResult();
+}
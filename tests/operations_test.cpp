@@ -0,0 +1,68 @@
+#include "check.h"
+#include "equivalence.h"
+#include "operations.h"
+#include "subset.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Compile a pattern; the table is kept in tables so it outlives the expressions.
+ */
+DFATable compile(const string &pattern, vector<unique_ptr<CompiledDFA>> &tables) {
+    NFA nfa;
+    NFA::fromPattern(pattern, nfa, nullptr);
+    tables.push_back(determinize(nfa, 1));
+    return tables.back()->table();
+}
+
+}
+
+/**
+ * Every operation agrees with the boolean combination of its operands on
+ * every word up to 7 letters over {a, b, c}, and the materialized products
+ * have the language of a pattern written by hand for them. Clearing the
+ * cache of an operand shared by another expression keeps both correct.
+ */
+int main() {
+    vector<unique_ptr<CompiledDFA>> tables;
+    // words ending with a, and words starting with a
+    DFATable endsA = compile("[abc]*a", tables), startsA = compile("a[abc]*", tables);
+    LazyAutomaton a(endsA), b(startsA), wordDFA(WordDFA("cab"));
+    LazyAutomaton notA = complement(a), both = intersection(a, b), either = unionOf(a, b), onlyA = difference(a, b);
+    LazyAutomaton joined = concatenation(a, b), withWord = unionOf(intersection(notA, wordDFA), concatenation(wordDFA, b));
+    string input;
+    for(int length = 0; length <= 7; length++) {
+        size_t words = 1;
+        for(int i = 0; i < length; i++) words *= 3;
+        for(size_t word = 0; word < words; word++) {
+            input.clear();
+            for(size_t rest = word, i = 0; i < (size_t) length; i++, rest /= 3) input.push_back("abc"[rest % 3]);
+            bool inA = endsA.run(input), inB = startsA.run(input), isWord = input == "cab";
+            bool split = false;
+            for(size_t i = 0; i <= input.length(); i++) split = split || (endsA.run(input.substr(0, i)) && startsA.run(input.substr(i)));
+            check(notA.run(input) == !inA, "complement on " + input);
+            check(both.run(input) == (inA && inB), "intersection on " + input);
+            check(either.run(input) == (inA || inB), "union on " + input);
+            check(onlyA.run(input) == (inA && !inB), "difference on " + input);
+            check(joined.run(input) == split, "concatenation on " + input);
+            check(withWord.run(input) == (isWord || input.rfind("caba", 0) == 0), "expression with a WordDFA on " + input);
+        }
+    }
+    LazyAutomaton nested = unionOf(both, wordDFA);
+    check(nested.run("aba") && nested.run("cab") && !nested.run("ab"), "expression on a shared operand");
+    check(both.cachedStates() > 0, "states of the shared operand");
+    both.clearCache();
+    check(both.cachedStates() == 0, "cache cleared");
+    check(nested.run("aba") && nested.run("cab") && !nested.run("ab") && !nested.run("bca"), "expression after clearing its operand");
+    check(both.run("acba") && !both.run("acb"), "operand after clearing its cache");
+    string counterexample;
+    check(equivalent(both.materialize().table(), compile("a|a[abc]*a", tables), &counterexample),
+          "intersection is a|a[abc]*a, not on \"" + counterexample + "\"");
+    check(equivalent(onlyA.materialize(true).table(), compile("[bc][abc]*a", tables), &counterexample),
+          "difference is [bc][abc]*a, not on \"" + counterexample + "\"");
+    check(equivalent(joined.materialize(true).table(), compile("[abc]*aa[abc]*", tables), &counterexample),
+          "concatenation is [abc]*aa[abc]*, not on \"" + counterexample + "\"");
+    return testResult();
+}
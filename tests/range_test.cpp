@@ -0,0 +1,67 @@
+#include "check.h"
+#include "compiled.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Automaton built in the test through the protected model: from state 0,
+ * 'x' has a transition of its own, the digits and then [0-z] are ranges, the
+ * vowels a set, every other byte the default transition. State 1 is final.
+ */
+class ModelDFA : public AbstractDFA {
+public:
+    ModelDFA() : AbstractDFA(5) {
+        transitionF.insert(pair<tpair, int>(tpair(0, 'x'), 1));
+        addRangeTransition(0, '0', '9', 2);
+        tset vowels;
+        for(char vowel : string("aeiou")) vowels.set((unsigned char) vowel);
+        addSetTransition(0, vowels, 1);
+        addRangeTransition(0, '0', 'z', 3);
+        addRangeTransition(0, 0x80, 0xff, 1);
+        defaultF.insert(pair<int, int>(0, 4));
+        defaultF.insert(pair<int, int>(2, 1));
+        finalStates.push_back(1);
+    }
+};
+
+/**
+ * The same model over 16-bit symbols, where a range spans more than a byte.
+ */
+class WideDFA : public TokenDFA {
+public:
+    WideDFA() : TokenDFA(2) {
+        addRangeTransition(0, 300, 40000, 1);
+        finalStates.push_back(1);
+    }
+};
+
+}
+
+/**
+ * Transitions on single letters win over ranges, the first range added wins
+ * over the later ones, and the default transition only takes the letters no
+ * range contains; the compiled table follows the same rules for every byte.
+ */
+int main() {
+    ModelDFA dfa;
+    CompiledDFA compiled(dfa);
+    DFATable table = compiled.table();
+    for(int letter = 0; letter < 256; letter++) {
+        string input(1, (char) letter);
+        bool vowel = string("aeiou").find((char) letter) != string::npos;
+        bool expected = letter == 'x' || vowel || letter >= 0x80;
+        check(dfa.run(input) == expected, "letter " + to_string(letter));
+        check(table.run(input) == expected, "compiled letter " + to_string(letter));
+        //A digit goes to state 2, whose default transition leads to the final state
+        bool digit = letter >= '0' && letter <= '9';
+        check(dfa.run(input + "?") == digit, "letter " + to_string(letter) + " then ?");
+        check(table.run(input + "?") == digit, "compiled letter " + to_string(letter) + " then ?");
+    }
+    WideDFA wide;
+    for(uint16_t symbol : {uint16_t(299), uint16_t(300), uint16_t(20000), uint16_t(40000), uint16_t(40001), uint16_t(65535)}) {
+        check(wide.run(vector<uint16_t>{symbol}) == (symbol >= 300 && symbol <= 40000), "symbol " + to_string(symbol));
+    }
+    return testResult();
+}
@@ -0,0 +1,51 @@
+#include <cstdint>
+#include <thread>
+#include "check.h"
+#include "replicated.h"
+
+using namespace std;
+
+/**
+ * Tables allocated on huge pages are usable and 2 MB aligned, and every
+ * thread reads from its replica of a large table the same transitions as
+ * from the original.
+ */
+int main() {
+    vector<int, HugePageAllocator<int>> large(hugePageSize);
+    check((uintptr_t) large.data() % hugePageSize == 0, "large table aligned to 2 MB");
+    for(size_t i = 0; i < large.size(); i++) large[i] = (int) i;
+    check(large.back() == (int) hugePageSize - 1, "large table usable");
+    vector<int, HugePageAllocator<int>> small(1000, 7);
+    check(small[999] == 7, "small table usable");
+
+    //A table of 2100 states by 256 classes is larger than a huge page
+    int states = 2100, classes = 256;
+    vector<unsigned char> classMap(256), accepting(states);
+    vector<int> transitions((size_t) states * classes);
+    for(int letter = 0; letter < 256; letter++) classMap[letter] = (unsigned char) letter;
+    for(size_t cell = 0; cell < transitions.size(); cell++) transitions[cell] = (int) ((cell * 2654435761u) % states);
+    for(int state = 0; state < states; state += 3) accepting[state] = 1;
+    DFATable table{states, classes, 0, -1, classMap.data(), transitions.data(), accepting.data()};
+
+    for(bool replicate : {false, true}) {
+        ReplicatedDFA replicated(table, replicate);
+        check(replicated.replicaCount() == (replicate ? ReplicatedDFA::numaNodes() : 1), "replica count");
+        check(replicated.unboundCount() == 0 || replicated.replicaCount() > 1, "single copy never bound");
+        vector<unsigned char> same(4, 0);
+        auto compare = [&](unsigned worker) {
+            string input;
+            for(int i = 0; i < 300; i++) input.push_back((char) (i * 37 + worker));
+            const DFATable &local = replicated.local();
+            bool agree = &local == &replicated.local() && local.numStates == states;
+            for(size_t length = 0; length <= input.length(); length += 7) {
+                agree = agree && local.run(input.substr(0, length)) == table.run(input.substr(0, length));
+            }
+            same[worker] = agree;
+        };
+        vector<thread> workers;
+        for(unsigned worker = 0; worker < 4; worker++) workers.emplace_back(compare, worker);
+        for(thread &worker : workers) worker.join();
+        for(unsigned worker = 0; worker < 4; worker++) check(same[worker], "replica read by thread " + to_string(worker));
+    }
+    return testResult();
+}
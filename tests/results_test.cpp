@@ -0,0 +1,91 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include "check.h"
+#include "results.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Read every block of a result file.
+ *
+ * @param corrupt
+ *            Set to true if the reading stopped on a corrupt block.
+ * @return The number of blocks read, or -1 if the file could not be opened.
+ */
+int readAll(const char *path, ResultColumns &all, bool &corrupt) {
+    ResultReader reader;
+    if(!reader.open(path)) return -1;
+    ResultColumns columns;
+    int blocks = 0;
+    for(; reader.next(columns); blocks++) {
+        for(size_t row = 0; row < columns.rows(); row++) {
+            all.fileIds.push_back(columns.fileIds[row]);
+            all.patternIds.push_back(columns.patternIds[row]);
+            all.verdicts.push_back(columns.verdicts[row]);
+            all.offsets.insert(all.offsets.end(), columns.offsets.begin() + (ptrdiff_t) columns.offsetStart[row],
+                               columns.offsets.begin() + (ptrdiff_t) columns.offsetStart[row + 1]);
+            all.offsetStart.push_back(all.offsets.size());
+        }
+    }
+    corrupt = reader.error();
+    return blocks;
+}
+
+}
+
+/**
+ * Rows written in several blocks, with file IDs that go back and forth and
+ * with match offsets, are read back unchanged; a truncated file stops at its
+ * last whole block with an error, and a block header that announces more
+ * bytes than the file holds is rejected without allocating them.
+ */
+int main() {
+    const char *path = "results_test.results";
+    ResultWriter writer;
+    check(writer.open(path), "open the writer");
+    ResultBlock block;
+    check(block.encode().empty(), "empty block");
+    vector<vector<uint64_t>> offsets{{}, {3}, {1, 2, 1000000}, {uint64_t(1) << 40}};
+    for(uint64_t row = 0; row < 1000; row++) {
+        uint64_t fileId = row % 2 == 0 ? row : 5000000000 - row;
+        block.add(fileId, (uint32_t) (row % 300), row % 3 == 0, offsets[row % 4]);
+        if(row % 400 == 399) check(writer.write(block) && block.empty(), "write a block");
+    }
+    check(writer.write(block), "write the last block");
+    writer.close();
+
+    ResultColumns all;
+    all.offsetStart.assign(1, 0);
+    bool corrupt = true;
+    check(readAll(path, all, corrupt) == 3 && all.rows() == 1000 && !corrupt, "read the blocks");
+    bool same = all.rows() == 1000;
+    for(uint64_t row = 0; same && row < 1000; row++) {
+        vector<uint64_t> rowOffsets(all.offsets.begin() + (ptrdiff_t) all.offsetStart[row], all.offsets.begin() + (ptrdiff_t) all.offsetStart[row + 1]);
+        same = all.fileIds[row] == (row % 2 == 0 ? row : 5000000000 - row) && all.patternIds[row] == row % 300 &&
+               all.verdicts[row] == (row % 3 == 0) && rowOffsets == offsets[row % 4];
+    }
+    check(same, "rows read back");
+
+    ifstream written(path, ios::binary);
+    string file((istreambuf_iterator<char>(written)), istreambuf_iterator<char>());
+    ofstream(path, ios::binary).write(file.data(), (streamsize) file.length() - 1);
+    ResultColumns truncated;
+    truncated.offsetStart.assign(1, 0);
+    check(readAll(path, truncated, corrupt) == 2 && truncated.rows() == 800 && corrupt, "truncated file");
+
+    //A header of 1 row whose first column is announced as 4 GB
+    string oversized = file.substr(0, 8);
+    uint32_t header[6] = {1, UINT32_MAX, 1, 1, 1, 0};
+    oversized.append((const char *) header, sizeof(header));
+    oversized.append(16, '\0');
+    ofstream(path, ios::binary) << oversized;
+    ResultColumns none;
+    check(readAll(path, none, corrupt) == 0 && corrupt, "oversized column");
+    ofstream(path, ios::binary) << "LRESULT";
+    check(readAll(path, none, corrupt) == -1, "file shorter than the magic");
+    remove(path);
+    return testResult();
+}
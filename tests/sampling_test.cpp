@@ -0,0 +1,64 @@
+#include <map>
+#include "check.h"
+#include "sampling.h"
+#include "subset.h"
+
+using namespace std;
+
+/**
+ * BigCount agrees with 64-bit arithmetic and prints large powers correctly;
+ * the sampler counts the accepted words of every length like a brute-force
+ * enumeration, draws accepted words of the requested length with every word
+ * about equally often, and near misses are rejected.
+ */
+int main() {
+    mt19937_64 generator(42);
+    for(int i = 0; i < 1000; i++) {
+        uint64_t a = generator() >> 2, b = generator() >> 2;
+        uint32_t factor = (uint32_t) (generator() >> 34);
+        BigCount x(a), y(b);
+        check((BigCount(a) += y).toString() == to_string(a + b), "sum of " + to_string(a) + " and " + to_string(b));
+        check((BigCount(max(a, b)) -= BigCount(min(a, b))).toString() == to_string(max(a, b) - min(a, b)), "difference of " + to_string(a) + " and " + to_string(b));
+        check((BigCount(a >> 32) * factor).toString() == to_string((a >> 32) * factor), "product of " + to_string(a >> 32));
+        check((x < y) == (a < b), "comparison of " + to_string(a) + " and " + to_string(b));
+        check(x.bitLength() == (a == 0 ? 0 : 64 - (size_t) __builtin_clzll(a)), "bit length of " + to_string(a));
+    }
+    BigCount power(1);
+    for(int i = 0; i < 10; i++) power = power * 256;
+    check(power.toString() == "1208925819614629174706176", "256^10");
+    check(power.bitLength() == 81, "bit length of 256^10");
+    check((power -= BigCount(1)).toString() == "1208925819614629174706175", "256^10 - 1");
+    check(BigCount().isZero() && BigCount().toString() == "0", "zero");
+    for(int i = 0; i < 100; i++) check(BigCount::random(power, generator) < power, "random number below the bound");
+
+    NFA nfa;
+    check(NFA::fromPattern("(a|b)*abb|c", nfa, nullptr), "parse");
+    unique_ptr<CompiledDFA> compiled = determinize(nfa, 1);
+    DFATable table = compiled->table();
+    WordSampler sampler(table, 8);
+    string word;
+    for(size_t length = 0; length <= 8; length++) {
+        uint64_t expected = length == 1 ? 1 : 0;
+        for(uint64_t bits = 0; length >= 3 && bits < (1ULL << length); bits++) {
+            word.clear();
+            for(size_t i = 0; i < length; i++) word.push_back(bits >> i & 1 ? 'b' : 'a');
+            if(table.run(word)) expected++;
+        }
+        check(sampler.count(length).toString() == to_string(expected), "count of length " + to_string(length));
+        check(sampler.sample(length, generator, word) == (expected != 0), "sample of length " + to_string(length));
+    }
+
+    //The 8 accepted words of length 6 should each be drawn about 1/8 of the times
+    map<string, int> drawn;
+    for(int i = 0; i < 8000; i++) {
+        check(sampler.sample(6, generator, word) && word.length() == 6 && table.run(word), "accepted sample");
+        drawn[word]++;
+    }
+    check(drawn.size() == 8, "every word of length 6 is drawn");
+    for(auto &entry : drawn) check(entry.second > 800 && entry.second < 1200, "frequency of " + entry.first);
+
+    for(int i = 0; i < 100; i++) {
+        check(sampler.sampleNearMiss(6, generator, word) && word.length() == 6 && !table.run(word), "near miss");
+    }
+    return testResult();
+}
@@ -0,0 +1,41 @@
+#include "check.h"
+#include "subset.h"
+
+using namespace std;
+
+/**
+ * The DFA built by the subset construction accepts the same words as its NFA,
+ * on every word up to 7 letters over {a, b, c}, and it is the same table
+ * whatever the number of threads. Sets that only differ in states without
+ * byte transitions are one DFA state.
+ */
+int main() {
+    const char *patterns[] = {"(a|b)*abb", "(ab)*", "a(b|c)*a?", "((a|b)(a|b|c)){2,3}", "[^a]*a[^a]*", "(a*b*)*c"};
+    for(const char *pattern : patterns) {
+        NFA nfa;
+        check(NFA::fromPattern(pattern, nfa, nullptr), string("parse ") + pattern);
+        unique_ptr<CompiledDFA> single = determinize(nfa, 1), parallel = determinize(nfa, 4);
+        check(single && parallel, string("determinize ") + pattern);
+        if(!single || !parallel) continue;
+        DFATable table = single->table(), other = parallel->table();
+        bool same = table.numStates == other.numStates && table.trapState == other.trapState;
+        for(int i = 0; same && i < table.numStates * table.numClasses; i++) same = table.transitions[i] == other.transitions[i];
+        check(same, string("same table on 1 and 4 threads for ") + pattern);
+        string input;
+        for(int length = 0; length <= 7; length++) {
+            size_t words = 1;
+            for(int i = 0; i < length; i++) words *= 3;
+            for(size_t word = 0; word < words; word++) {
+                input.clear();
+                for(size_t rest = word, i = 0; i < (size_t) length; i++, rest /= 3) input.push_back("abc"[rest % 3]);
+                check(table.run(input) == nfa.run(input), string(pattern) + " on " + input);
+            }
+        }
+    }
+    //Start, after a, and the trap: the closure reached after "ab" has the same important states as the start
+    NFA nfa;
+    NFA::fromPattern("(ab)*", nfa, nullptr);
+    unique_ptr<CompiledDFA> table = determinize(nfa, 1);
+    check(table && table->table().numStates == 3, "(ab)* has 3 states");
+    return testResult();
+}
@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include "check.h"
+#include "suffix.h"
+
+using namespace std;
+
+namespace {
+
+uint64_t occurrences(const string &text, const string &pattern) {
+    uint64_t count = 0;
+    for(size_t at = text.find(pattern); at != string::npos; at = text.find(pattern, at + 1)) count++;
+    return count;
+}
+
+}
+
+/**
+ * The suffix automaton answers like a brute-force search for every pattern of
+ * up to 5 letters, within the 2n - 1 state bound, also after being saved and
+ * mapped again; a truncated index is rejected.
+ */
+int main() {
+    mt19937_64 generator(11);
+    string text;
+    for(int i = 0; i < 3000; i++) text.push_back("abc"[generator() % 3]);
+    SuffixAutomaton index;
+    check(index.build(text), "build");
+    check(index.textLength() == text.length() && index.stateCount() <= 2 * text.length() - 1, "state bound");
+    check(index.save("suffix_test.idx"), "save");
+    SuffixAutomaton mapped;
+    check(mapped.open("suffix_test.idx"), "open");
+    check(mapped.stateCount() == index.stateCount() && mapped.edgeCount() == index.edgeCount(), "same index after open");
+    string pattern;
+    for(int length = 0; length <= 5; length++) {
+        size_t patterns = 1;
+        for(int i = 0; i < length; i++) patterns *= 4;
+        for(size_t word = 0; word < patterns; word++) {
+            pattern.clear();
+            for(size_t rest = word, i = 0; i < (size_t) length; i++, rest /= 4) pattern.push_back("abcd"[rest % 4]);
+            uint64_t expected = length == 0 ? text.length() + 1 : occurrences(text, pattern);
+            check(index.contains(pattern) == (expected > 0), "contains " + pattern);
+            check(index.countOccurrences(pattern) == expected, "occurrences of " + pattern);
+            check(mapped.countOccurrences(pattern) == expected, "occurrences of " + pattern + " in the mapped index");
+        }
+    }
+    //A prefix of the file is not an index
+    ifstream whole("suffix_test.idx", ios::binary);
+    string bytes((istreambuf_iterator<char>(whole)), istreambuf_iterator<char>());
+    ofstream("suffix_test.idx", ios::binary | ios::trunc).write(bytes.data(), (streamsize) (bytes.size() / 2));
+    SuffixAutomaton truncated;
+    check(!truncated.open("suffix_test.idx"), "truncated index rejected");
+
+    //Crafted copies of a small index: the header is 32 bytes, then edgeStart (numStates + 1 entries) and edgeTargets
+    SuffixAutomaton small;
+    check(small.build("abcab") && small.save("suffix_test.idx"), "save a small index");
+    ifstream smallFile("suffix_test.idx", ios::binary);
+    string original((istreambuf_iterator<char>(smallFile)), istreambuf_iterator<char>());
+    size_t edgeStartAt = 32, edgeTargetsAt = (32 + (small.stateCount() + 1) * 4 + 7) / 8 * 8;
+    auto crafted = [&](size_t offset, const void *value, size_t size) {
+        string bytes = original;
+        bytes.replace(offset, size, (const char *) value, size);
+        ofstream("suffix_test.idx", ios::binary | ios::trunc) << bytes;
+        SuffixAutomaton index;
+        return index.open("suffix_test.idx");
+    };
+    uint32_t zero = 0, huge = 0xfffffff0u, states = small.stateCount();
+    uint64_t wrappingEdges = (uint64_t(1) << 62) + 1;
+    check(crafted(0, &zero, 0), "unchanged small index");
+    check(!crafted(16, &wrappingEdges, 8), "edge count that overflows rejected");
+    check(!crafted(edgeStartAt + 4 * states, &huge, 4), "last edge start beyond the edges rejected");
+    check(!crafted(edgeStartAt + 4, &huge, 4), "decreasing edge starts rejected");
+    check(!crafted(edgeTargetsAt, &states, 4), "edge target beyond the states rejected");
+    remove("suffix_test.idx");
+    return testResult();
+}
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include "check.h"
+#include "embedded.h"
+#include "summary.h"
+
+using namespace std;
+
+/**
+ * Summaries of the chunks of an input, merged in input order from the left
+ * or as a balanced tree, give the verdict and the number of matches of a
+ * scan of the whole input; summaries of different automata are not merged,
+ * and a saved summary is loaded back while a truncated file is rejected.
+ */
+int main() {
+    mt19937_64 generator(3);
+    const char *pieces[] = {"//", "\n", "{", "}", "(*", "*)", "x", "repeat", " "};
+    string input;
+    for(int i = 0; i < 400; i++) input += pieces[generator() % 9];
+    for(const char *name : {"comment", "identifier", "repeat"}) {
+        const DFATable &table = *findEmbeddedDFA(name);
+        vector<uint64_t> ends;
+        bool accepted = table.acceptedPrefixes(input, ends);
+        for(size_t chunks : {1, 2, 3, 7, 64}) {
+            //Random cut points, possibly giving empty chunks
+            vector<size_t> cuts{0, input.length()};
+            for(size_t i = 1; i < chunks; i++) cuts.push_back(generator() % (input.length() + 1));
+            sort(cuts.begin(), cuts.end());
+            vector<ScanSummary> summaries;
+            for(size_t i = 0; i + 1 < cuts.size(); i++) {
+                summaries.push_back(ScanSummary::summarize(table, string_view(input).substr(cuts[i], cuts[i + 1] - cuts[i])));
+            }
+            ScanSummary left(table);
+            for(const ScanSummary &summary : summaries) check(left.append(summary), "append");
+            while(summaries.size() > 1) {
+                vector<ScanSummary> merged;
+                for(size_t i = 0; i < summaries.size(); i += 2) {
+                    merged.push_back(summaries[i]);
+                    if(i + 1 < summaries.size()) merged.back().append(summaries[i + 1]);
+                }
+                summaries.swap(merged);
+            }
+            string what = string(name) + " in " + to_string(chunks) + " chunks";
+            for(const ScanSummary *summary : {&left, &summaries[0]}) {
+                check(summary->bytes() == input.length(), "bytes of " + what);
+                check(summary->accepted(table) == accepted, "verdict of " + what);
+                check(summary->matchCount(table) == ends.size(), "matches of " + what);
+            }
+        }
+    }
+
+    const DFATable &comment = *findEmbeddedDFA("comment"), &repeat = *findEmbeddedDFA("repeat");
+    ScanSummary summary = ScanSummary::summarize(comment, "{ x }");
+    check(!summary.append(ScanSummary::summarize(repeat, "repeat")), "summaries of different automata");
+    check(summary.isOf(comment) && !summary.isOf(repeat), "isOf");
+
+    const char *path = "summary_test.summary";
+    ScanSummary loaded;
+    check(summary.save(path) && loaded.load(path), "save and load");
+    check(loaded.isOf(comment) && loaded.bytes() == 5 && loaded.accepted(comment) && loaded.matchCount(comment) == 1, "loaded summary");
+    ifstream saved(path, ios::binary);
+    string bytes((istreambuf_iterator<char>(saved)), istreambuf_iterator<char>());
+    ofstream(path, ios::binary).write(bytes.data(), (streamsize) bytes.length() - 1);
+    check(!ScanSummary().load(path), "truncated summary");
+    remove(path);
+    return testResult();
+}
@@ -0,0 +1,47 @@
+#include "check.h"
+#include "lexer.h"
+
+using namespace std;
+
+namespace {
+
+vector<uint16_t> symbolsOf(Lexer &lexer, const char *input) {
+    vector<Token> tokens;
+    check(lexer.tokenize(input, tokens), string("tokenize ") + input);
+    return tokenSymbols(tokens);
+}
+
+}
+
+/**
+ * Token symbols keep punctuation, keywords and the other kinds apart, and the
+ * repeat ... until automaton runs on them: keywords inside comments or
+ * identifiers that merely start with a keyword don't count.
+ */
+int main() {
+    InternTable identifiers;
+    Lexer lexer(identifiers);
+    vector<uint16_t> symbols = symbolsOf(lexer, "repeat ; x 1 (* c *) \xff");
+    vector<uint16_t> expected = {(uint16_t) (keywordSymbolBase + lexer.keywordId("repeat")), ';',
+                                 (uint16_t) (kindSymbolBase + (uint16_t) TokenKind::Identifier),
+                                 (uint16_t) (kindSymbolBase + (uint16_t) TokenKind::Number),
+                                 (uint16_t) (kindSymbolBase + (uint16_t) TokenKind::Comment),
+                                 (uint16_t) (kindSymbolBase + (uint16_t) TokenKind::Unknown)};
+    check(symbols == expected, "token symbols");
+
+    RepeatUntilDFA repeatUntil(lexer);
+    pair<const char *, bool> programs[] = {
+        {"repeat x := x + 1 until x > 10", true},
+        {"begin repeat until end", true},
+        {"repeat repeat until", true},
+        {"until x repeat", false},
+        {"repeat x := 1", false},
+        {"(* repeat *) x until", false},
+        {"repeatx until", false},
+        {"", false},
+    };
+    for(auto &program : programs) {
+        check(repeatUntil.run(symbolsOf(lexer, program.first)) == program.second, string("REPEAT-UNTIL on ") + program.first);
+    }
+    return testResult();
+}
@@ -0,0 +1,43 @@
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "check.h"
+#include "trace.h"
+
+using namespace std;
+
+/**
+ * Spans are only recorded once tracing is enabled, and the dump is Chrome
+ * trace-event JSON with one complete event per span, the names escaped and
+ * the threads named.
+ */
+int main() {
+    {
+        TraceSpan span("before", "test");
+    }
+    check(!Tracer::isEnabled() && !Tracer::dump(), "tracing starts disabled");
+    Tracer::enable("trace_test.json");
+    Tracer::setThreadName("main");
+    {
+        TraceSpan outer("read ", "file \"a\".txt", "io");
+        TraceSpan inner("scan", "scan");
+    }
+    thread other([]() {
+        Tracer::setThreadName("worker");
+        TraceSpan span("other thread", "scan");
+    });
+    other.join();
+    check(Tracer::dump(), "dump");
+    ifstream in("trace_test.json");
+    stringstream contents;
+    contents << in.rdbuf();
+    string json = contents.str();
+    check(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0) == 0, "trace-event header");
+    check(json.find("before") == string::npos, "no span recorded before enable");
+    check(json.find("{\"name\":\"read file \\\"a\\\".txt\",\"cat\":\"io\",\"ph\":\"X\"") != string::npos, "name joined and escaped");
+    check(json.find("{\"name\":\"scan\",\"cat\":\"scan\",\"ph\":\"X\"") != string::npos, "nested span");
+    check(json.find("\"other thread\"") != string::npos, "span of another thread");
+    check(json.find("\"args\":{\"name\":\"worker\"}") != string::npos, "thread name");
+    check(json.size() > 4 && json.compare(json.size() - 4, 4, "\n]}\n") == 0, "trace closed");
+    return testResult();
+}
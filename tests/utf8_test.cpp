@@ -0,0 +1,94 @@
+#include <random>
+#include "check.h"
+#include "compiled.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Automaton whose state 0 reads one code point of [low, high] into the final
+ * state 1.
+ */
+class CodePointDFA : public AbstractDFA {
+public:
+    CodePointDFA(uint32_t low, uint32_t high) : AbstractDFA(2) {
+        addCodePointTransition(0, low, high, 1);
+        finalStates.push_back(1);
+    }
+};
+
+/**
+ * Strict decoder: the code point encoded by the whole input, or -1 if the
+ * input is not exactly one valid UTF-8 sequence (no overlong forms, no
+ * surrogates, nothing above U+10FFFF).
+ */
+int64_t decode(const unsigned char *bytes, size_t length) {
+    static const uint32_t minimum[5] = {0, 0, 0x80, 0x800, 0x10000};
+    size_t expected = bytes[0] < 0x80 ? 1 : bytes[0] >= 0xc0 && bytes[0] < 0xe0 ? 2 : bytes[0] >= 0xe0 && bytes[0] < 0xf0 ? 3
+                    : bytes[0] >= 0xf0 && bytes[0] < 0xf8 ? 4 : 0;
+    if(expected == 0 || expected != length) return -1;
+    uint32_t codePoint = length == 1 ? bytes[0] : bytes[0] & (0x7f >> length);
+    for(size_t i = 1; i < length; i++) {
+        if((bytes[i] & 0xc0) != 0x80) return -1;
+        codePoint = codePoint << 6 | (bytes[i] & 0x3f);
+    }
+    if(codePoint < minimum[length] || codePoint > 0x10ffff || (codePoint >= 0xd800 && codePoint <= 0xdfff)) return -1;
+    return codePoint;
+}
+
+bool accepts(const DFATable &table, const unsigned char *bytes, size_t length) {
+    int state = table.startState;
+    for(size_t i = 0; i < length; i++) state = table.step(state, bytes[i]);
+    return table.isAccepting(state);
+}
+
+}
+
+/**
+ * A code point range compiled into byte transitions accepts exactly the
+ * UTF-8 encodings of the code points in the range: every sequence of up to
+ * 2 bytes is checked, every 3-byte sequence with a 3-byte lead, and many
+ * random 3- and 4-byte sequences.
+ */
+int main() {
+    pair<uint32_t, uint32_t> ranges[] = {{0, 0x10ffff}, {0x41, 0x5a}, {0x80, 0x7ff}, {0x7f, 0x800}, {0x4e00, 0x9fff},
+                                         {0xd000, 0xe000}, {0xffff, 0x10000}, {0x10400, 0x10ffff}};
+    mt19937_64 generator(5);
+    for(auto &range : ranges) {
+        CodePointDFA dfa(range.first, range.second);
+        CompiledDFA compiled(dfa);
+        DFATable table = compiled.table();
+        string name = "[" + to_string(range.first) + ", " + to_string(range.second) + "]";
+        size_t failed = 0;
+        unsigned char bytes[4];
+        for(uint32_t value = 0; value < 0x10000 + 0x100000; value++) {
+            //The 3-byte sequences start at 0x10000, with the leads 0xe0 to 0xef
+            size_t length = value < 0x100 ? 1 : value < 0x10000 ? 2 : 3;
+            uint32_t sequence = length == 3 ? value - 0x10000 + 0xe00000 : value;
+            for(size_t i = 0; i < length; i++) bytes[i] = (unsigned char) (sequence >> (8 * (length - 1 - i)));
+            int64_t codePoint = decode(bytes, length);
+            bool expected = codePoint >= range.first && codePoint <= range.second;
+            if(accepts(table, bytes, length) != expected) failed++;
+        }
+        for(int sample = 0; sample < 100000; sample++) {
+            uint64_t random = generator();
+            //Half of the samples have the shape of a 4-byte sequence, so many of them are valid
+            if(sample % 2 == 0) random = 0x808080f0 | (random & 0x3f3f3f07);
+            for(size_t i = 0; i < 4; i++) bytes[i] = (unsigned char) (random >> (8 * i));
+            size_t length = 3 + sample % 4 / 2;
+            int64_t codePoint = decode(bytes, length);
+            bool expected = codePoint >= range.first && codePoint <= range.second;
+            //The model itself is checked on the samples only, it is slower than the table
+            if(accepts(table, bytes, length) != expected || dfa.run(string((const char *) bytes, length)) != expected) failed++;
+        }
+        check(failed == 0, name + " on " + to_string(failed) + " sequences");
+    }
+    CommentDFA utf8Comment(true);
+    check(utf8Comment.run("{ \xc3\xa9t\xc3\xa9 \xf0\x9f\x98\x80 }"), "valid UTF-8 comment");
+    check(!utf8Comment.run("{ \xc0\xaf }") && !utf8Comment.run("{ \xed\xa0\x80 }") && !utf8Comment.run("{ \xc3 }"),
+          "overlong, surrogate and truncated sequences");
+    IdentifierDFA unicodeIdentifier(true);
+    check(unicodeIdentifier.run("\xc3\xa9t\xc3\xa9_1") && !unicodeIdentifier.run("1\xc3\xa9"), "Unicode identifiers");
+    return testResult();
+}
@@ -0,0 +1,193 @@
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include "trace.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Events recorded by a single thread. Buffers are owned by the registry, so the
+ * events of a thread survive the thread itself until the trace is dumped.
+ */
+struct ThreadBuffer {
+    int tid;
+    string threadName;
+    vector<TraceEvent> events;
+};
+
+atomic<bool> enabled(false);
+string outputFile;
+chrono::steady_clock::time_point epoch;
+mutex registryMutex;
+vector<unique_ptr<ThreadBuffer>> registry;
+thread_local ThreadBuffer *localBuffer = nullptr;
+
+/**
+ * Return the buffer of the calling thread, registering it the first time.
+ */
+ThreadBuffer *threadBuffer() {
+    if(localBuffer == nullptr){
+        lock_guard<mutex> lock(registryMutex);
+        registry.push_back(make_unique<ThreadBuffer>());
+        localBuffer = registry.back().get();
+        localBuffer->tid = (int) registry.size();
+    }
+    return localBuffer;
+}
+
+/**
+ * Write a string as a JSON string literal.
+ */
+void writeJsonString(ostream &out, const string &text) {
+    out << '"';
+    for(unsigned char c : text){
+        switch(c){
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if(c < 0x20){
+                    const char *hex = "0123456789abcdef";
+                    out << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+                }else{
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+}
+
+void dumpAtExit() { Tracer::dump(); }
+
+}
+
+/**
+ * Enable tracing. The collected events are written to the given file at exit.
+ *
+ * @param outputPath
+ *            Path of the JSON file that will contain the trace.
+ */
+void Tracer::enable(const string &outputPath) {
+    if(enabled.exchange(true)) return;
+    outputFile = outputPath;
+    epoch = chrono::steady_clock::now();
+    atexit(dumpAtExit);
+}
+
+/**
+ * Check if tracing has been enabled.
+ *
+ * @return True, if spans are currently being recorded.
+ */
+bool Tracer::isEnabled() { return enabled.load(memory_order_relaxed); }
+
+/**
+ * Microseconds elapsed since tracing was enabled.
+ *
+ * @return The current trace timestamp.
+ */
+long long Tracer::nowMicros() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+/**
+ * Append a completed span to the buffer of the calling thread.
+ *
+ * @param event
+ *            The span to record.
+ */
+void Tracer::record(TraceEvent event) {
+    if(!isEnabled()) return;
+    threadBuffer()->events.push_back(std::move(event));
+}
+
+/**
+ * Give a readable name to the calling thread in the trace viewer.
+ *
+ * @param name
+ *            The name of the thread.
+ */
+void Tracer::setThreadName(const string &name) {
+    if(!isEnabled()) return;
+    threadBuffer()->threadName = name;
+}
+
+/**
+ * Write all the buffered events to the output file, one "X" event per span
+ * plus a "thread_name" metadata event for every named thread.
+ *
+ * @return True, if the trace file has been written successfully.
+ */
+bool Tracer::dump() {
+    if(!isEnabled()) return false;
+    ofstream out(outputFile);
+    if(out.fail()) return false;
+    lock_guard<mutex> lock(registryMutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for(auto &buffer : registry){
+        if(!buffer->threadName.empty()){
+            out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"args\":{\"name\":";
+            writeJsonString(out, buffer->threadName);
+            out << "}}";
+            first = false;
+        }
+        for(auto &event : buffer->events){
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"cat\":";
+            writeJsonString(out, event.category);
+            out << ",\"ph\":\"X\",\"ts\":" << event.startMicros << ",\"dur\":" << event.durationMicros
+                << ",\"pid\":1,\"tid\":" << buffer->tid << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    return !out.fail();
+}
+
+/**
+ * Open a new span.
+ *
+ * @param spanName
+ *            Label of the span.
+ * @param spanCategory
+ *            Pipeline stage of the span.
+ */
+TraceSpan::TraceSpan(string_view spanName, string_view spanCategory) : TraceSpan(spanName, string_view(), spanCategory) {}
+
+/**
+ * Open a new span whose label is made of two parts; they are only joined if
+ * tracing is enabled.
+ *
+ * @param namePrefix
+ *            First part of the label.
+ * @param nameDetail
+ *            Second part of the label.
+ * @param spanCategory
+ *            Pipeline stage of the span.
+ */
+TraceSpan::TraceSpan(string_view namePrefix, string_view nameDetail, string_view spanCategory)
+    : start(0), active(Tracer::isEnabled()) {
+    if(active){
+        name.reserve(namePrefix.length() + nameDetail.length());
+        name.append(namePrefix).append(nameDetail);
+        category = spanCategory;
+        start = Tracer::nowMicros();
+    }
+}
+
+/**
+ * Close the span and record it.
+ */
+TraceSpan::~TraceSpan() {
+    if(active){
+        Tracer::record(TraceEvent{std::move(name), std::move(category), start, Tracer::nowMicros() - start});
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include<chrono>
+#include<string>
+#include<string_view>
+#include<vector>
+
+using namespace std;
+
+/**
+ * A completed span, exported as a Chrome trace-event "complete" event (ph = "X").
+ */
+struct TraceEvent {
+    /**
+     * @brief name represents the label of the span shown in the trace viewer
+     */
+    string name;
+    /**
+     * @brief category represents the pipeline stage the span belongs to (e.g. "io", "scan")
+     */
+    string category;
+    /**
+     * @brief startMicros represents the start of the span, in microseconds since tracing was enabled
+     */
+    long long startMicros;
+    /**
+     * @brief durationMicros represents the length of the span in microseconds
+     */
+    long long durationMicros;
+};
+
+/**
+ * Collects spans into per-thread buffers and writes them as Chrome trace-event
+ * JSON (loadable in Perfetto or chrome://tracing) when the program exits.
+ * Tracing is disabled until enable() is called, in which case recording a span
+ * costs only a flag check.
+ */
+class Tracer {
+public:
+    /**
+     * Enable tracing. The collected events are written to the given file at exit.
+     *
+     * @param outputPath
+     *            Path of the JSON file that will contain the trace.
+     */
+    static void enable(const string &outputPath);
+
+    /**
+     * Check if tracing has been enabled.
+     *
+     * @return True, if spans are currently being recorded.
+     */
+    static bool isEnabled();
+
+    /**
+     * Microseconds elapsed since tracing was enabled.
+     *
+     * @return The current trace timestamp.
+     */
+    static long long nowMicros();
+
+    /**
+     * Append a completed span to the buffer of the calling thread. No lock is
+     * taken except the first time a thread records a span.
+     *
+     * @param event
+     *            The span to record.
+     */
+    static void record(TraceEvent event);
+
+    /**
+     * Give a readable name to the calling thread in the trace viewer.
+     *
+     * @param name
+     *            The name of the thread (e.g. "reader", "scanner").
+     */
+    static void setThreadName(const string &name);
+
+    /**
+     * Write all the buffered events to the output file. It is registered with
+     * atexit() by enable(), so it normally doesn't need to be called directly.
+     *
+     * @return True, if the trace file has been written successfully.
+     */
+    static bool dump();
+};
+
+/**
+ * Scoped span: the span starts when the object is constructed and is recorded
+ * when the object goes out of scope. The name is only copied (or put
+ * together from its parts) if tracing is enabled, so a disabled span does
+ * not allocate.
+ */
+class TraceSpan {
+    string name;
+    string category;
+    long long start;
+    bool active;
+public:
+    /**
+     * Open a new span.
+     *
+     * @param spanName
+     *            Label of the span.
+     * @param spanCategory
+     *            Pipeline stage of the span.
+     */
+    TraceSpan(string_view spanName, string_view spanCategory);
+
+    /**
+     * Open a new span whose label is made of two parts, e.g. a stage and the
+     * file it works on.
+     *
+     * @param namePrefix
+     *            First part of the label.
+     * @param nameDetail
+     *            Second part of the label, appended to the first one.
+     * @param spanCategory
+     *            Pipeline stage of the span.
+     */
+    TraceSpan(string_view namePrefix, string_view nameDetail, string_view spanCategory);
+
+    /**
+     * Close the span and record it.
+     */
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+};
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "workers.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief ringBytes represents the capacity of the result ring of a worker
+ */
+const size_t ringBytes = 1 << 20;
+/**
+ * @brief chunkBytes represents the largest piece of output written to a ring at once
+ */
+const size_t chunkBytes = ringBytes / 4;
+
+// states of a shard besides the pid of the worker that processes it
+const int32_t pendingShard = 0;
+const int32_t doneShard = -1;
+
+/**
+ * A piece of the output or of the report of a shard, followed in the ring by
+ * its bytes.
+ */
+struct RecordHeader {
+    uint32_t shard;
+    uint32_t attempt;
+    uint32_t length;
+    uint32_t flags;
+};
+
+const uint32_t lastRecord = 1;
+const uint32_t okRecord = 2;
+const uint32_t reportRecord = 4;
+
+/**
+ * Single-producer single-consumer byte ring: the worker advances tail, the
+ * parent advances head; both only grow and are taken modulo the capacity.
+ */
+struct Ring {
+    atomic<uint64_t> head;
+    atomic<uint64_t> tail;
+    char data[ringBytes];
+
+    void copyIn(uint64_t position, const void *bytes, size_t length) {
+        size_t offset = position % ringBytes, first = min(length, ringBytes - offset);
+        memcpy(data + offset, bytes, first);
+        memcpy(data, (const char *) bytes + first, length - first);
+    }
+
+    void copyOut(uint64_t position, void *bytes, size_t length) const {
+        size_t offset = position % ringBytes, first = min(length, ringBytes - offset);
+        memcpy(bytes, data + offset, first);
+        memcpy((char *) bytes + first, data, length - first);
+    }
+
+    /**
+     * Append a record, waiting for the parent to make room.
+     */
+    void write(const RecordHeader &header, const char *bytes) {
+        uint64_t position = tail.load(memory_order_relaxed);
+        size_t needed = sizeof(header) + header.length;
+        while(position + needed - head.load(memory_order_acquire) > ringBytes) {
+            //The parent is gone: nobody will ever read the ring
+            if(getppid() == 1) _exit(1);
+            usleep(100);
+        }
+        copyIn(position, &header, sizeof(header));
+        copyIn(position + sizeof(header), bytes, header.length);
+        tail.store(position + needed, memory_order_release);
+    }
+};
+
+/**
+ * Pointers into the shared memory region: the work queue, the attempt number
+ * of every shard, and the rings.
+ */
+struct Shared {
+    atomic<uint64_t> *nextShard;
+    atomic<int32_t> *state;
+    atomic<uint32_t> *attempt;
+    Ring *rings;
+};
+
+/**
+ * Take a shard: a fresh one from the counter, or one given back after a crash.
+ *
+ * @return The shard, or -1 if none is left.
+ */
+int64_t takeShard(Shared &shared, size_t shards, int32_t pid) {
+    for(uint64_t shard = shared.nextShard->fetch_add(1); shard < shards; shard = shared.nextShard->fetch_add(1)) {
+        int32_t expected = pendingShard;
+        if(shared.state[shard].compare_exchange_strong(expected, pid)) return (int64_t) shard;
+    }
+    for(size_t shard = 0; shard < shards; shard++) {
+        int32_t expected = pendingShard;
+        if(shared.state[shard].compare_exchange_strong(expected, pid)) return (int64_t) shard;
+    }
+    return -1;
+}
+
+/**
+ * Body of a worker: scan shards and send their output and then their report
+ * to the parent, in pieces that fit the ring, until the queue is empty.
+ */
+[[noreturn]] void workerLoop(Shared &shared, Ring &ring, size_t shards,
+                             const function<bool(size_t, ostream &, ostream &)> &scan) {
+    int32_t pid = getpid();
+    for(int64_t shard = takeShard(shared, shards, pid); shard >= 0; shard = takeShard(shared, shards, pid)) {
+        uint32_t attempt = shared.attempt[shard].load();
+        ostringstream out, report;
+        bool ok = scan((size_t) shard, out, report);
+        string parts[2] = {out.str(), report.str()};
+        for(int part = 0; part < 2; part++) {
+            //Every part is sent, even if empty, so the last record always comes with the report
+            size_t sent = 0;
+            do {
+                size_t length = min(chunkBytes, parts[part].length() - sent);
+                bool last = part == 1 && sent + length == parts[part].length();
+                RecordHeader header{(uint32_t) shard, attempt, (uint32_t) length,
+                                    (last ? lastRecord : 0) | (ok ? okRecord : 0) | (part == 1 ? reportRecord : 0)};
+                ring.write(header, parts[part].data() + sent);
+                sent += length;
+            } while(sent < parts[part].length());
+        }
+        shared.state[shard].store(doneShard);
+    }
+    _exit(0);
+}
+
+}
+
+/**
+ * Run a job made of independent shards in worker processes.
+ *
+ * @param shards
+ *            Number of shards.
+ * @param workers
+ *            Number of worker processes.
+ * @param scan
+ *            Runs in a worker: processes a shard and writes its output and its report.
+ * @param deliver
+ *            Runs in the parent, in shard order: receives the output and the report of a shard.
+ * @return The number of worker crashes.
+ */
+int runSharded(size_t shards, unsigned workers, const function<bool(size_t shard, ostream &out, ostream &report)> &scan,
+               const function<void(size_t shard, const string &output, const string &report, bool ok, bool crashed)> &deliver) {
+    workers = max(1u, (unsigned) min<size_t>(workers, max<size_t>(shards, 1)));
+    //The counter gets a cache line of its own, the rings start on a cache line
+    size_t stateOffset = 64, stateBytes = shards * sizeof(atomic<int32_t>), attemptBytes = shards * sizeof(atomic<uint32_t>);
+    size_t ringOffset = (stateOffset + stateBytes + attemptBytes + 63) / 64 * 64;
+    size_t regionBytes = ringOffset + workers * sizeof(Ring);
+    char *region = (char *) mmap(nullptr, regionBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(region == MAP_FAILED) {
+        //No shared memory: the shards are processed here
+        for(size_t shard = 0; shard < shards; shard++) {
+            ostringstream out, report;
+            bool ok = scan(shard, out, report);
+            deliver(shard, out.str(), report.str(), ok, false);
+        }
+        return 0;
+    }
+    Shared shared;
+    shared.nextShard = new(region) atomic<uint64_t>(0);
+    shared.state = new(region + stateOffset) atomic<int32_t>[shards];
+    shared.attempt = new(region + stateOffset + stateBytes) atomic<uint32_t>[shards];
+    shared.rings = new(region + ringOffset) Ring[workers];
+    for(size_t shard = 0; shard < shards; shard++) {
+        shared.state[shard].store(pendingShard);
+        shared.attempt[shard].store(0);
+    }
+
+    vector<pid_t> pids(workers, 0);
+    auto spawn = [&](unsigned slot) {
+        Ring &ring = shared.rings[slot];
+        ring.head.store(0);
+        ring.tail.store(0);
+        //Buffered output would otherwise be written again by the child
+        cout.flush();
+        pid_t pid = fork();
+        if(pid == 0) workerLoop(shared, ring, shards, scan);
+        //If fork fails, the slot stays empty and is tried again later
+        pids[slot] = max(pid, 0);
+    };
+    for(unsigned slot = 0; slot < workers; slot++) spawn(slot);
+
+    vector<string> outputs(shards), reports(shards);
+    vector<unsigned char> complete(shards, 0), ok(shards, 0), crashed(shards, 0);
+    size_t delivered = 0;
+    int crashes = 0;
+    auto drain = [&](unsigned slot) {
+        Ring &ring = shared.rings[slot];
+        bool progress = false;
+        uint64_t head = ring.head.load(memory_order_relaxed);
+        while(head < ring.tail.load(memory_order_acquire)) {
+            RecordHeader header;
+            ring.copyOut(head, &header, sizeof(header));
+            string bytes(header.length, '\0');
+            ring.copyOut(head + sizeof(header), bytes.data(), header.length);
+            head += sizeof(header) + header.length;
+            ring.head.store(head, memory_order_release);
+            progress = true;
+            if(header.attempt != shared.attempt[header.shard].load() || complete[header.shard]) continue;
+            (header.flags & reportRecord ? reports : outputs)[header.shard] += bytes;
+            if(header.flags & lastRecord) {
+                complete[header.shard] = 1;
+                ok[header.shard] = (header.flags & okRecord) != 0;
+            }
+        }
+        return progress;
+    };
+
+    while(delivered < shards) {
+        bool progress = false;
+        for(unsigned slot = 0; slot < workers; slot++) progress = drain(slot) || progress;
+        for(; delivered < shards && complete[delivered]; delivered++) {
+            deliver(delivered, outputs[delivered], reports[delivered], ok[delivered], crashed[delivered]);
+            string().swap(outputs[delivered]);
+            string().swap(reports[delivered]);
+        }
+        int status;
+        pid_t pid;
+        while((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+            auto found = find(pids.begin(), pids.end(), pid);
+            if(found == pids.end()) continue;
+            unsigned slot = (unsigned) (found - pids.begin());
+            pids[slot] = 0;
+            //What the worker wrote before dying is still valid
+            drain(slot);
+            if(WIFEXITED(status) && WEXITSTATUS(status) == 0) continue;
+            crashes++;
+            for(size_t shard = 0; shard < shards; shard++) {
+                if(shared.state[shard].load() != pid) continue;
+                //Its whole output arrived before the crash
+                if(complete[shard]) {
+                    shared.state[shard].store(doneShard);
+                    continue;
+                }
+                outputs[shard].clear();
+                reports[shard].clear();
+                if(shared.attempt[shard].fetch_add(1) + 1 >= maxAttempts) {
+                    shared.state[shard].store(doneShard);
+                    complete[shard] = 1;
+                    crashed[shard] = 1;
+                } else {
+                    shared.state[shard].store(pendingShard);
+                }
+            }
+            progress = true;
+        }
+        //Shards given back after a crash need a worker, even if the others have left
+        bool pending = false;
+        for(size_t shard = delivered; shard < shards && !pending; shard++) pending = shared.state[shard].load() == pendingShard;
+        if(pending) {
+            for(unsigned slot = 0; slot < workers; slot++) {
+                if(pids[slot] == 0) {
+                    spawn(slot);
+                    break;
+                }
+            }
+        }
+        if(!progress) usleep(200);
+    }
+    //Wait for the workers that are still leaving
+    for(pid_t pid : pids) {
+        if(pid != 0) waitpid(pid, nullptr, 0);
+    }
+    munmap(region, regionBytes);
+    return crashes;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include<cstddef>
+#include<functional>
+#include<ostream>
+#include<string>
+
+using namespace std;
+
+/**
+ * Run a job made of independent shards (e.g. one input file each) in worker
+ * processes, so that a crash only loses the shard being processed.
+ *
+ * The workers are forked from the calling process and share with it an
+ * anonymous shared memory region that holds the work queue (a counter of
+ * the next fresh shard and the state of every shard) and one result ring per
+ * worker. A worker takes shards until none is left, writes the output of
+ * each into its ring and marks the shard done. The parent collects the
+ * outputs and hands them over in shard order. If a worker dies, its
+ * unfinished shard is given back to the queue, with a new attempt number so
+ * that partial output is discarded, and a new worker takes its place; a shard
+ * that crashes maxAttempts workers is reported as failed.
+ *
+ * Workers leave with _exit(), without running atexit handlers (trace and
+ * metrics files are written by the parent only), and state they change, like
+ * counters, is not seen by the parent: what the parent needs of it goes in
+ * the report of the shard, which travels with the output and is delivered
+ * with it, once, from the attempt that completed.
+ *
+ * @param shards
+ *            Number of shards.
+ * @param workers
+ *            Number of worker processes.
+ * @param scan
+ *            Runs in a worker: processes a shard, writes its output and its
+ *            report and returns false if the shard failed.
+ * @param deliver
+ *            Runs in the parent, in shard order: receives the output and the
+ *            report of a shard and whether it succeeded; crashed is true (and
+ *            both are empty) if every attempt crashed.
+ * @return The number of worker crashes.
+ */
+int runSharded(size_t shards, unsigned workers, const function<bool(size_t shard, ostream &out, ostream &report)> &scan,
+               const function<void(size_t shard, const string &output, const string &report, bool ok, bool crashed)> &deliver);
+
+/**
+ * @brief maxAttempts represents how many workers may crash on the same shard before it is given up
+ */
+const unsigned maxAttempts = 3;